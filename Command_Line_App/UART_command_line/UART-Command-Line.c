@@ -9,10 +9,15 @@
 
 #include "../../HAL/HAL-SYSTEM/inc/stm32f10x.h"
 #include "UART_Command_Line.h"
-#include "../memory_utility/memory_utility.h"
-#include "../../HAL/HAL-UART/inc/hal_usart2_config.h"
+#include "command_table.h"
+#include "../frame_ring/frame_ring.h"
+#include "../reply_queue/reply_queue.h"
+#include "../baud_switch/baud_switch.h"
+#include "../command_line_port/command_line_port.h"
+#include "../response_frame/response_frame.h"
+#include "../../HAL/HAL-UART/inc/hal_usart_config.h"
+#include "../../HAL/HAL_ISR/UART_isr.h"
 #include <stdlib.h>
-#include <stdio.h>
 
 /**
  array of UART message strings used for logging and debugging purposes.
@@ -20,46 +25,50 @@
 static const char* UART_Message[] = 
 {
    "Error: CommandContent pointer is null.\n",
-   "Command received and processed.\n",
-   "\nFirst Command: %s\n",
-   "\nSecond Command: %s\n",
    NULL //proper termination for an array of pointers
 };
 
-#define XML_MSG_ARRAY_SIZE       (uint8_t) 4
-#define INVALID_OPERATION_INDX   (uint8_t) 1
+#define FNV_OFFSET_BASIS   (uint32_t) 0x811C9DC5
+#define FNV_PRIME          (uint32_t) 0x01000193
 
-/*Array of strings representing various XML processing messages. 
- Each string corresponds to a specific XML parsing status, providing 
- human-readable error or status messages. The array ends with a NULL 
- pointer to indicate the end of the list.*/
-static const char* XML_Proccessing_Messages[XML_MSG_ARRAY_SIZE] = 
-{
-    "\nNo command was found\n",  //message for when no valid command is detected in the XML
-    "\nInvalid operation\n",     //message for an unsupported or invalid operation in the XML
-    "\nBad XML\n",               //message for malformed or incorrect XML format
-    NULL                         //sentinel value marking the end of the array
-};
+#define PWM_CHANNEL_COUNT  (uint8_t) 4
+#define PWM_DUTY_FRACTION_DIGITS (uint8_t) 1   //the duty cycle is kept in tenths of a percent
+
+//LED value set by the LightOn command, the schema limits it to 0..100
+static uint8_t g_led_value = 0;
+
+//duty cycle in tenths of a percent and ramp time in ms of every PWM channel, set by the SetPwm command
+static uint16_t g_pwm_duty[PWM_CHANNEL_COUNT];
+static uint16_t g_pwm_ramp_ms[PWM_CHANNEL_COUNT];
 
-#define NUMBER_OF_COMMANDS  (uint8_t) 3
-/*define a global array of CommandEntry structures, where each entry associates a command string 
- with a corresponding handler function. The array ends with a sentinel entry {NULL, NULL} to 
- indicate the end of the command list. 
- please note that g_cmd_list must be null terminated*/
-static const struct CommandEntry g_cmd_list[NUMBER_OF_COMMANDS] = 
+static void write_message(USART_TypeDef *uart, const char *message);
+
+/**
+ * @brief Returns the USART the reply to a command goes to.
+ *
+ * @param CommandContent Pointer to the command, may be NULL.
+ *
+ * @return USART_TypeDef* The USART of the port the command was received on, the debug
+ *         console if the command comes without one.
+ */
+static USART_TypeDef *reply_uart(const struct XMLDataExtractionResult *CommandContent)
 {
-    {"LightOn", SetLedValue},   //command "LightOn" is handled by the SetLedValue function
-    {"GetHeater", GetHeaterValue}, //command "GetHeater" is handled by the GetHeaterValue function
-    {NULL, NULL}               //Sentinel entry marking the end of the command list
-};
+    UsartPort_t port = COMMAND_LINE_DEBUG_PORT;
 
+    if (CommandContent != NULL && CommandContent->port != NULL)
+    {
+        port = CommandContent->port->usart;
+    }
+
+    return HAL_USART_Instance(port);
+}
 
 /**
 * @brief Callback function to process and set LED value based on command.
 *
-* This function checks the input pointer, logs the incoming command, 
-* and processes it to set the appropriate LED value. It returns an 
-* error status indicating success or failure.
+* This function checks the input pointer, sets the LED value and reports
+* it back in the response. It returns an error status indicating success
+* or failure.
 *
 * @param [in] *CommandContent Pointer to the XMLDataExtractionResult structure.
 *
@@ -74,18 +83,17 @@ ErrorStatus SetLedValue(const struct XMLDataExtractionResult *CommandContent)
     // Check if the input pointer is valid; return ERROR if NULL.
     if (CommandContent == NULL) 
     {
-        UART_WriteData(USART2, (const char*)UART_Message[ERR_NULL_POINTER]);
+        write_message(reply_uart(CommandContent), UART_Message[ERR_NULL_POINTER]);
     }
     else
     {
-      // Log the first command from the incoming structure.
-      UART_WriteData(USART2, (const char*)UART_Message[FIRST_CMD]);
-      UART_WriteData(USART2, (const char*)CommandContent->cmd);
-      
-      // Indicate that the command was received and processed.
-      UART_WriteData(USART2, (const char*)UART_Message[CMD_PROCESSED]);
+      // The parser has already decoded and range-checked the value.
+      g_led_value = (uint8_t) CommandContent->args[0].value.u32;
+
+      // Report the value the LED is set to.
+      response_frame_unsigned(CommandContent->response, g_led_value, 1U);
       
-      // Set outcome to SUCCESS since the command was successfully logged.
+      // Set outcome to SUCCESS since the command was successfully processed.
       outcome = SUCCESS;
     }
     
@@ -96,9 +104,9 @@ ErrorStatus SetLedValue(const struct XMLDataExtractionResult *CommandContent)
 /**
 * @brief Callback function to retrieve the heater value based on command.
 *
-* This function validates the input pointer, logs the incoming command, 
-* and processes it to retrieve the heater value. It returns an error 
-* status indicating success or failure.
+* This function validates the input pointer and processes the command to
+* retrieve the heater value. Its response carries the status only. It
+* returns an error status indicating success or failure.
 *
 * @param [in] *CommandContent Pointer to the XMLDataExtractionResult structure.
 *
@@ -114,17 +122,10 @@ ErrorStatus GetHeaterValue(const struct XMLDataExtractionResult *CommandContent)
     if (CommandContent == NULL) 
     {
         // Log an error message for null pointer.
-        UART_WriteData(USART2, (const char*)UART_Message[ERR_NULL_POINTER]);
+        write_message(reply_uart(CommandContent), UART_Message[ERR_NULL_POINTER]);
     } 
     else 
     {
-        // Log the second command from the incoming structure.
-        UART_WriteData(USART2, (const char*)UART_Message[SECOND_CMD]);
-        UART_WriteData(USART2, (const char*)CommandContent->cmd);
-        
-        // Indicate that the command was received and processed.
-        UART_WriteData(USART2, (const char*)UART_Message[CMD_PROCESSED]);
-        
         // Update outcome to SUCCESS as processing was successful.
         outcome = SUCCESS;
     }
@@ -134,151 +135,279 @@ ErrorStatus GetHeaterValue(const struct XMLDataExtractionResult *CommandContent)
 }
 
 /**
- * @brief Function to find the location of a tag in an XML string.
- *
- * @param xml: Pointer to the XML string
- * @param tag: Pointer to the tag name to locate
- * @param kind_of_tag: Specifies whether to find an opening tag (0) or a closing tag (1)
- * @return Pointer to the tag location in the XML string, or NULL if not found
- */
-const char* find_tag_location(const char *xml, const char *tag, uint8_t kind_of_tag) 
+* @brief Callback function to set the duty cycle and ramp time of a PWM channel.
+*
+* The channel, the duty cycle and the optional ramp time are sent in one frame,
+* either as <PARAM> elements in schema order or as named <P> elements. The
+* response reports the channel and the duty cycle and ramp time it now has.
+*
+* @param [in] *CommandContent Pointer to the XMLDataExtractionResult structure.
+*
+* @retval SUCCESS if the command is successfully processed.
+* @retval ERROR if the input pointer is null or processing fails.
+*/
+ErrorStatus SetPwmValue(const struct XMLDataExtractionResult *CommandContent)
 {
-	//allocated one memory block for the tag
-    char *formatted_tag = NULL;
-	
-	//this buffer is going to hold the tag location in the xml string
-	const char *tag_location;
-	
-    //validate input parameters
-    if(!xml || !tag || kind_of_tag > CLOSE_TAG)
+    ErrorStatus outcome = ERROR;
+    uint8_t channel = 0;
+
+    if (CommandContent == NULL)
     {
-        return NULL; // invalid input parameters
+        write_message(reply_uart(CommandContent), UART_Message[ERR_NULL_POINTER]);
     }
-    
-		formatted_tag = (char *) MemoryPool_Allocate();
-    
-    if (!formatted_tag) 
+    else
     {
-        return NULL; // Memory allocation failed
+        //the schema limits the channel to 0..3 and the duty cycle to 0.0..100.0
+        channel = (uint8_t) CommandContent->args[0].value.u32;
+        g_pwm_duty[channel] = (uint16_t) CommandContent->args[1].value.i32;
+
+        //without a ramp time the duty cycle changes at once
+        g_pwm_ramp_ms[channel] = CommandContent->args[2].present ? (uint16_t) CommandContent->args[2].value.u32 : 0;
+
+        response_frame_unsigned(CommandContent->response, channel, 1U);
+        response_frame_fixed(CommandContent->response, g_pwm_duty[channel], PWM_DUTY_FRACTION_DIGITS);
+        response_frame_unsigned(CommandContent->response, g_pwm_ramp_ms[channel], 2U);
+
+        outcome = SUCCESS;
     }
 
-    // Format the tag based on kind_of_tag (0: opening, 1: closing)
-    if (kind_of_tag == OPEN_TAG) 
-    {
-        snprintf(formatted_tag, BLOCK_SIZE, "<%s>", tag);
-    } 
-    else 
+    return outcome;
+}
+
+/**
+* @brief Callback function to report the counters of the receive path.
+*
+* Reports the frames abandoned by the inter-byte and the whole-frame timeout, the
+* frames dropped because every frame slot was in use or because they were too long,
+* and the error replies dropped because the reply queue was full.
+*
+* @param [in] *CommandContent Pointer to the XMLDataExtractionResult structure.
+*
+* @retval SUCCESS if the command is successfully processed.
+* @retval ERROR if the input pointer is null.
+*/
+ErrorStatus GetDiagnostics(const struct XMLDataExtractionResult *CommandContent)
+{
+    ErrorStatus outcome = ERROR;
+
+    if (CommandContent == NULL)
     {
-        snprintf(formatted_tag, BLOCK_SIZE, "</%s>", tag);
+        write_message(reply_uart(CommandContent), UART_Message[ERR_NULL_POINTER]);
     }
+    else
+    {
+        response_frame_unsigned(CommandContent->response, CommandContent->port->rx_stats.inter_byte_timeouts, 4U);
+        response_frame_unsigned(CommandContent->response, CommandContent->port->rx_stats.frame_timeouts, 4U);
+        response_frame_unsigned(CommandContent->response, CommandContent->port->frames.dropped, 4U);
+        response_frame_unsigned(CommandContent->response, CommandContent->port->frames.overflowed, 4U);
+        response_frame_unsigned(CommandContent->response, CommandContent->port->replies.dropped, 4U);
 
-    // Find the tag in the XML string
-    tag_location = strstr(xml, formatted_tag);
-
-    // Free allocated memory
-    MemoryPool_Free((char *) formatted_tag);
+        outcome = SUCCESS;
+    }
 
-    return tag_location; // Return the location of the tag, or NULL if not found
+    return outcome;
 }
 
 /**
- * @brief Function to extract a value from an XML string between specific tags
- *
- * @param xml: Pointer to the XML string
- * @param tag: Pointer to the tag name whose value needs to be extracted
- * @param tag_value: Pointer to a buffer where the extracted value will be stored
- * @param value_size: Size of the buffer for tag_value
- * @retval XML_Parser_Status_t: Status of the extraction (e.g., success or error)
- */
-XML_Parser_Status_t extract_value_from_xml(const char *xml, const char *tag, 
-                                           char *tag_value, size_t value_size) 
+* @brief Callback function to switch the baud rate of the command line.
+*
+* The response is sent at the old rate and reports the rate the divider actually
+* produces, its error and the time ConfirmBaud has to arrive in. Once it has been
+* sent, the firmware switches to the new rate and waits for ConfirmBaud at that
+* rate; without it, it switches back.
+*
+* @param [in] *CommandContent Pointer to the XMLDataExtractionResult structure.
+*
+* @retval SUCCESS if the switch is requested.
+* @retval ERROR if the input pointer is null or the rate can not be reached precisely enough.
+*/
+ErrorStatus SetBaudRate(const struct XMLDataExtractionResult *CommandContent)
 {
-    // Initialize the return value to XML_OK (success)
-    XML_Parser_Status_t outcome = XML_OK;
-	
-	  //pointer to the start and end point of the tag
-    const char *start;
-    const char *end;
-	
-		size_t tag_length = 0;
+    ErrorStatus outcome = ERROR;
+    struct UsartBaudSetting setting;
+    uint32_t baud_rate = 0;
 
-    // Check if input parameters are valid
-    if (!xml || !tag || !tag_value || value_size == 0) 
+    if (CommandContent == NULL)
     {
-        return INVALID_OPERATION; // Invalid input parameters
+        write_message(reply_uart(CommandContent), UART_Message[ERR_NULL_POINTER]);
     }
-		
-		start = find_tag_location(xml, tag, CLOSE_TAG);   // Find closing tag
-		end   = find_tag_location(xml, tag, OPEN_TAG); // Find opening tag
-
-    // Ensure both tags are found and in proper order
-    if (start && end && end > start) 
+    else
     {
-        start += strlen(tag) + 2; // Move the pointer past the opening tag (e.g., "<tag>")
+        //the schema limits the rate to 1200..2250000
+        baud_rate = (uint32_t) CommandContent->args[0].value.i32;
+        (void)HAL_USART_ComputeBaud(CommandContent->port->usart, baud_rate, &setting);
+        outcome = baud_switch_request(&CommandContent->port->baud_switch, CommandContent->port->usart, baud_rate);
 
-   			tag_length = (size_t)(end - start); // Calculate the length of the value
+        response_frame_unsigned(CommandContent->response, baud_rate, 4U);
+        response_frame_unsigned(CommandContent->response, setting.actual_rate, 4U);
+        response_frame_signed(CommandContent->response, setting.error_ppm);
 
-        // Check if the extracted value fits in the provided buffer
-        if (tag_length >= value_size) 
+        //a rate that can not be reached is not switched to, there is nothing to confirm
+        if (outcome == SUCCESS)
         {
-            outcome = BAD_XML; // Value too large for buffer
-        } 
-        else 
+            response_frame_unsigned(CommandContent->response, BAUD_SWITCH_CONFIRM_TICKS * 1000U / SYSTICK_FREQUENCY_HZ, 4U);
+        }
+    }
+
+    return outcome;
+}
+
+/**
+* @brief Callback function to confirm the baud rate the command line has switched to.
+*
+* Arriving at the new rate proves that both ends run at it, the response reports
+* the rate confirmed. Without a pending switch the command does nothing and its
+* response carries no value.
+*
+* @param [in] *CommandContent Pointer to the XMLDataExtractionResult structure.
+*
+* @retval SUCCESS if the command is successfully processed.
+* @retval ERROR if the input pointer is null.
+*/
+ErrorStatus ConfirmBaudRate(const struct XMLDataExtractionResult *CommandContent)
+{
+    ErrorStatus outcome = ERROR;
+
+    if (CommandContent == NULL)
+    {
+        write_message(reply_uart(CommandContent), UART_Message[ERR_NULL_POINTER]);
+    }
+    else
+    {
+        if (baud_switch_confirm(&CommandContent->port->baud_switch))
         {
-            // Copy the extracted value into the provided buffer
-            strncpy(tag_value, start, tag_length);
-            tag_value[tag_length] = '\0'; // Null-terminate the string
-            outcome = XML_OK; // Extraction successful
+            response_frame_unsigned(CommandContent->response, HAL_USART_GetBaudRate(CommandContent->port->usart), 4U);
         }
-    } 
-    else 
+
+        outcome = SUCCESS;
+    }
+
+    return outcome;
+}
+
+/**
+* @brief Callback function to report the quality of the line the command arrived on.
+*
+* Reports the bytes received, the receive errors by kind, the frames dropped because
+* of them and the errors per million bytes, so a noisy link can be told apart from
+* a host that sends too fast.
+*
+* @param [in] *CommandContent Pointer to the XMLDataExtractionResult structure.
+*
+* @retval SUCCESS if the command is successfully processed.
+* @retval ERROR if the input pointer is null.
+*/
+ErrorStatus GetLineQuality(const struct XMLDataExtractionResult *CommandContent)
+{
+    ErrorStatus outcome = ERROR;
+    const struct UartRxStats *stats = NULL;
+    uint32_t errors = 0;
+
+    if (CommandContent == NULL)
+    {
+        write_message(reply_uart(CommandContent), UART_Message[ERR_NULL_POINTER]);
+    }
+    else
+    {
+        stats = &CommandContent->port->rx_stats;
+        errors = stats->overruns + stats->framing_errors + stats->noise_errors + stats->parity_errors;
+
+        response_frame_unsigned(CommandContent->response, stats->bytes_received, 4U);
+        response_frame_unsigned(CommandContent->response, stats->overruns, 4U);
+        response_frame_unsigned(CommandContent->response, stats->framing_errors, 4U);
+        response_frame_unsigned(CommandContent->response, stats->noise_errors, 4U);
+        response_frame_unsigned(CommandContent->response, stats->parity_errors, 4U);
+        response_frame_unsigned(CommandContent->response, stats->corrupted_frames, 4U);
+        response_frame_unsigned(CommandContent->response, (stats->bytes_received == 0) ? 0 :
+                                (uint32_t)((uint64_t)errors * 1000000U / stats->bytes_received), 4U);
+
+        outcome = SUCCESS;
+    }
+
+    return outcome;
+}
+
+/**
+ * @brief Returns a pointer to the first byte of a slice of the received frame.
+ *
+ * Please note that the slice is not null-terminated, use slice->length to bound it.
+ *
+ * @param CommandContent Pointer to the XMLDataExtractionResult the slice belongs to.
+ * @param slice Pointer to the slice.
+ * @return Pointer to the data of the slice, or NULL if the input is invalid.
+ */
+const char* get_slice_data(const struct XMLDataExtractionResult *CommandContent, const struct XMLSlice *slice)
+{
+    const char *outcome = NULL;
+
+    if (CommandContent && CommandContent->frame && slice)
     {
-        outcome = BAD_XML; // Tags not found or malformed XML
+        outcome = &CommandContent->frame[slice->offset];
     }
 
-    return outcome; // Return the outcome of the operation
+    return outcome;
 }
 
 
+/**
+ * @brief Hashes a command name for the perfect hash table of the command list.
+ *
+ * Seeded FNV-1a followed by a final mix of the high bits into the low bits.
+ * Please note that it must stay identical to command_hash() in Tools/gen_command_table.py,
+ * which computes the seeds and slots of the table.
+ *
+ * @param cmd Pointer to the command name, it does not need to be null-terminated.
+ * @param cmd_length Length of the command name in bytes.
+ * @param seed Seed of the hash.
+ * @return uint32_t The hash value.
+ */
+static uint32_t command_hash(const char *cmd, uint16_t cmd_length, uint32_t seed)
+{
+    uint32_t hash = FNV_OFFSET_BASIS ^ seed;
+    uint16_t index = 0;
+
+    for (index = 0; index < cmd_length; ++index)
+    {
+        hash ^= (uint8_t) cmd[index];
+        hash *= FNV_PRIME;
+    }
+
+    return hash ^ (hash >> 15);
+}
+
 /**
  * @brief Looks for the specified command in the global command list.
  *
- * This function searches through the global command list to find a matching
- * command. If the command is found, it returns its index; otherwise, it 
- * returns NO_COMMAND_FOUND.
+ * The command list comes with a collision-free hash table generated from the command
+ * schema: the first hash selects the seed of the second hash, which selects the only
+ * slot the command can be in. The lookup therefore costs two hashes and one memcmp,
+ * whatever the number of commands.
  *
- * @param cmd Pointer to the command string to search for.
+ * @param cmd Pointer to the command to search for, it does not need to be null-terminated.
+ * @param cmd_length Length of the command in bytes.
  * @return uint8_t Index of the found command or NO_COMMAND_FOUND if not found.
  */
-uint8_t find_command_in_list(const char* cmd)
+uint8_t find_command_in_list(const char* cmd, uint16_t cmd_length)
 {
-    bool    operation_outcome = false;  //tracks whether the command was found.
-    uint8_t cmd_list_index = 0;         //index for iterating through the command list.
-    
+    uint8_t  cmd_list_index = NO_COMMAND_FOUND;  //index of the command in the command list.
+    uint16_t seed = 0;                            //seed of the second hash.
+
     //check if input command is valid.
     if (cmd)
     {
-        //iterate through the command list until the end (null command).
-        //please note that g_cmd_list i null terminated, so there is no way 
-        //it overflows
-        while (g_cmd_list[cmd_list_index].cmd)
-        {
-            //compare the current command in the list with the input command.
-            if (strcmp(g_cmd_list[cmd_list_index].cmd, cmd) == 0)
-            {
-                operation_outcome = true;  //mark that the command is found.
-                break;                     //exit the loop as the command is found.
-            }
-            ++cmd_list_index;  //move to the next command in the list.
-        }
-        
-        //if the command was not found, set index to NO_COMMAND_FOUND.
-        if (!operation_outcome)
+        //select the slot the command has to be in, if it exists.
+        seed = g_cmd_hash_seeds[command_hash(cmd, cmd_length, 0) & (COMMAND_HASH_BUCKETS - 1)];
+        cmd_list_index = g_cmd_hash_slots[command_hash(cmd, cmd_length, seed) & (COMMAND_HASH_SLOTS - 1)];
+
+        //a single comparison tells whether the slot holds the received command.
+        if (cmd_list_index >= COMMAND_COUNT ||
+            g_cmd_list[cmd_list_index].cmd_length != cmd_length ||
+            memcmp(g_cmd_list[cmd_list_index].cmd, cmd, cmd_length) != 0)
         {
             cmd_list_index = NO_COMMAND_FOUND;
         }
     }
-    // If either the input command or command list is invalid, return NO_COMMAND_FOUND.
+    // If the input command is invalid, return INVALID_OPERATION.
     else
     {
         cmd_list_index = INVALID_OPERATION;
@@ -288,57 +417,198 @@ uint8_t find_command_in_list(const char* cmd)
 }
 
 /**
- * @brief Extracts a command and its parameter from an input XML string.
+ * @brief Finds the schema position of a named parameter.
+ *
+ * @param command Pointer to the command list entry of the received command.
+ * @param name Pointer to the name, it does not need to be null-terminated.
+ * @param name_length Length of the name in bytes.
+ * @return uint8_t Position of the parameter in the schema, or param_count if the command does not declare it.
+ */
+static uint8_t find_param_by_name(const struct CommandEntry *command, const char *name, uint16_t name_length)
+{
+    uint8_t index = 0;
+
+    for (index = 0; index < command->param_count; ++index)
+    {
+        if (strlen(command->params[index].name) == name_length &&
+            memcmp(command->params[index].name, name, name_length) == 0)
+        {
+            break;
+        }
+    }
+
+    return index;
+}
+
+/**
+ * @brief Checks that every required parameter of a command was sent.
+ *
+ * @param command Pointer to the command list entry of the received command.
+ * @param args Pointer to the arguments of the command, in schema order.
+ * @return XML_Parser_Status_t XML_OK or MISSING_PARAMETER.
+ */
+static XML_Parser_Status_t check_required_params(const struct CommandEntry *command,
+                                                 const struct CommandArgument *args)
+{
+    XML_Parser_Status_t outcome = XML_OK;
+    uint8_t index = 0;
+
+    for (index = 0; index < command->param_count && outcome == XML_OK; ++index)
+    {
+        if (command->params[index].required && !args[index].present)
+        {
+            outcome = MISSING_PARAMETER;
+        }
+    }
+
+    return outcome;
+}
+
+/**
+ * @brief Binds the arguments of a command of the batch to its parameters and decodes them.
+ *
+ * Unnamed <PARAM> arguments are bound by their position, named <P> arguments by their
+ * name, so both forms can be mixed in one command. Every argument is decoded according
+ * to the command schema.
+ *
+ * @param command Pointer to the command list entry of the received command.
+ * @param xml Pointer to the received frame.
+ * @param layout Pointer to the frame layout holding the argument table.
+ * @param frame_command Pointer to the entry of the command in the command table of the frame.
+ * @param args Pointer to the array of MAX_COMMAND_PARAMS arguments to fill in, in schema order.
+ * @return XML_Parser_Status_t XML_OK, MISSING_PARAMETER, BAD_PARAMETER, PARAMETER_OUT_OF_RANGE,
+ *         UNKNOWN_PARAMETER or TOO_MANY_PARAMETERS.
+ */
+static XML_Parser_Status_t decode_command_params(const struct CommandEntry *command, const char *xml,
+                                                 const struct FrameLayout *layout,
+                                                 const struct FrameCommand *frame_command,
+                                                 struct CommandArgument *args)
+{
+    XML_Parser_Status_t outcome = XML_OK;
+    Param_Status_t param_status = PARAM_OK;
+    const struct FrameArgument *argument = NULL;
+    uint8_t index = 0;
+    uint8_t param_index = 0;
+
+    //more arguments than the table holds are more than the frame can carry
+    if (layout->arg_overflow)
+    {
+        return TOO_MANY_PARAMETERS;
+    }
+
+    for (index = 0; index < frame_command->arg_count && outcome == XML_OK; ++index)
+    {
+        argument = &layout->args[frame_command->first_arg + index];
+
+        if (argument->name_offset == FRAME_TAG_NOT_FOUND)
+        {
+            param_index = index;
+            outcome = (param_index < command->param_count) ? XML_OK : TOO_MANY_PARAMETERS;
+        }
+        else
+        {
+            param_index = find_param_by_name(command, &xml[argument->name_offset], argument->name_length);
+            outcome = (param_index < command->param_count) ? XML_OK : UNKNOWN_PARAMETER;
+        }
+
+        //a parameter can only be sent once
+        if (outcome == XML_OK && args[param_index].present)
+        {
+            outcome = UNKNOWN_PARAMETER;
+        }
+
+        if (outcome == XML_OK)
+        {
+            args[param_index].present    = true;
+            args[param_index].raw.offset = argument->value_offset;
+            args[param_index].raw.length = argument->value_length;
+
+            param_status = decode_param(&command->params[param_index], &xml[argument->value_offset],
+                                        argument->value_length, &args[param_index].value);
+
+            if (param_status == PARAM_BAD_FORMAT)
+            {
+                outcome = BAD_PARAMETER;
+            }
+            else if (param_status == PARAM_OUT_OF_RANGE)
+            {
+                outcome = PARAMETER_OUT_OF_RANGE;
+            }
+        }
+    }
+
+    //the command can not run without its required parameters
+    if (outcome == XML_OK)
+    {
+        outcome = check_required_params(command, args);
+    }
+
+    return outcome;
+}
+
+/**
+ * @brief Extracts one command of a batch and its parameters from an input XML string.
  *
- * This function processes an XML string to extract the value of the `CMD` tag 
- * and its associated parameter. It returns a structure containing the command, 
- * its parameter, and the index of the corresponding callback function.
+ * This function takes the command name from the command table recorded by the frame
+ * tokenizer and binds the arguments of the command to its parameters. Nothing is
+ * copied: the returned structure holds slices into the frame, so the command and
+ * the parameters are not limited in length. The parameters are decoded and validated
+ * against the command schema, so invalid values are rejected with a specific status
+ * before the callback is dispatched.
  *
  * @param xml Pointer to the input XML string.
+ * @param layout Pointer to the commands, tags and arguments recorded by the frame tokenizer.
+ * @param command_index Position of the command in the batch.
  * @return struct XMLDataExtractionResult A structure containing:
- *         - `cmd`: The extracted command.
- *         - `param`: The extracted parameter.
+ *         - `frame`: The frame the slices refer to.
+ *         - `cmd`: Slice of the extracted command.
+ *         - `args`: The parameters, in schema order.
  *         - `callback_index`: Index of the callback function, or an error code if unsuccessful.
  */
-struct XMLDataExtractionResult extract_command_and_params_from_xml(const char *xml)
+struct XMLDataExtractionResult extract_command_and_params_from_xml(const char *xml,
+                                                                  const struct FrameLayout *layout,
+                                                                  uint8_t command_index)
 {
     struct XMLDataExtractionResult outcome; //stores the results of XML parsing.
+    const struct FrameCommand *frame_command = NULL;
     
     XML_Parser_Status_t parser_status = XML_OK; //status of XML parsing operations.
 
-    size_t memory_size = 0;    //initial memory size for tag value storage.
-
-    memory_size = CMD_AND_PARAM_LENGTH * sizeof(char);  //adjust memory size based on character size.
+    //the slices refer to the input frame
+    memset(&outcome, 0, sizeof(outcome));
+    outcome.format = FRAME_FORMAT_XML;
+    outcome.frame = xml;
     
-    //check if the input XML string is valid.
-    if (xml)
+    //check if the input XML string and its frame layout are valid.
+    if (xml && layout)
     {
-        //extract the command from the `CMD` tag in the XML string.
-        parser_status = extract_value_from_xml(xml, XML_TAG_CMD, outcome.cmd, memory_size);
-
-        //check if the command was successfully extracted.
-        if (parser_status == XML_OK)
+        //check that the batch holds the requested command.
+        if (command_index < layout->cmd_count)
         {
+            frame_command = &layout->cmds[command_index];
+            outcome.cmd.offset = frame_command->name_offset;
+            outcome.cmd.length = frame_command->name_length;
+
             //search for the extracted command in the command list and get its callback index.
-            outcome.callback_index = find_command_in_list(outcome.cmd);
+            outcome.callback_index = find_command_in_list(&xml[outcome.cmd.offset], outcome.cmd.length);
             
             //validate that the callback index is valid.
-            if (outcome.callback_index < NO_COMMAND_FOUND)
+            if (outcome.callback_index < COMMAND_COUNT)
             {
-                //extract the parameter from the `PARAMETER` tag and store it in `outcome.param`.
-                parser_status = extract_value_from_xml(xml, XML_TAG_PARAMETER, outcome.param, memory_size);
-                
-                //if parameter extraction fails, mark the callback index as invalid.
+                //bind and decode the parameters as declared in the command schema, and reject
+                //the command before dispatch if a parameter is missing, unknown or invalid.
+                parser_status = decode_command_params(&g_cmd_list[outcome.callback_index], xml,
+                                                      layout, frame_command, outcome.args);
                 if (parser_status != XML_OK)
                 {
                     outcome.callback_index = parser_status;
                 }
             } 
         }
-        //if the `CMD` tag is missing or invalid, mark the callback index as invalid.
+        //if the `CMD` tag is missing, the XML is malformed.
         else
         {
-            outcome.callback_index = parser_status;
+            outcome.callback_index = BAD_XML;
         }   
     }
     //if the input XML is null, mark the operation as invalid.
@@ -347,86 +617,526 @@ struct XMLDataExtractionResult extract_command_and_params_from_xml(const char *x
         outcome.callback_index = INVALID_OPERATION;
     }
 
-    return outcome; // Return the result structure containing the command, parameter, and callback index.
+    return outcome; // Return the result structure containing the command, parameters, and callback index.
 }
 
 /**
- * @brief Executes the appropriate callback function or prints an error message 
- *        based on the result of XML data extraction.
- * 
- * @param commandContent Pointer to an XMLDataExtractionResult structure containing 
- *                       the extracted command and callback index.
- * 
- * This function determines whether to call a callback function from the global 
- * command list (g_cmd_list) or print an error message based on the contents 
- * of the commandContent structure.
+ * @brief Prints a constant message to the UART port.
+ *
+ * The message is not copied, the DMA reads it from where it is; it has to stay
+ * unchanged until it is sent, which string literals and the message tables do.
+ *
+ * @param uart The USART to print to.
+ * @param message Null-terminated message.
  */
-void execute_callback_functions(const struct XMLDataExtractionResult *commandContent)
+static void write_message(USART_TypeDef *uart, const char *message)
 {
-    uint8_t index = 0; // Initialize index to store the calculated error message index or callback index
-    
-    // Check if the commandContent pointer is NULL
-    if (!commandContent)
-    {
-        // Calculate the index for the "Invalid operation" error message
-        index =  INVALID_OPERATION - NO_COMMAND_FOUND;
-        
-        //validate index
-        if(index < XML_MSG_ARRAY_SIZE)
+    const struct UsartTxSegment segment = { message, (uint16_t) strlen(message) };
+
+    UART_WriteSegments(uart, &segment, 1U);
+}
+
+/**
+ * @brief Reserves room for a response frame in the transmit queue and starts the frame in it.
+ *
+ * Nothing else may be written to the USART until send_response() has queued the frame.
+ *
+ * @param uart The USART the response goes to.
+ * @param response Pointer to the frame to start.
+ * @param format FRAME_FORMAT_XML or FRAME_FORMAT_BINARY, the format of the request.
+ * @param size Bytes to reserve, the largest the frame can get.
+ */
+static void begin_response(USART_TypeDef *uart, struct ResponseFrame *response, uint8_t format, uint16_t size)
+{
+    response_frame_begin(response, format, UART_ReserveBuffer(uart, size), size);
+}
+
+/**
+ * @brief Completes a response frame started by begin_response() and queues it.
+ *
+ * @param uart The USART the response goes to.
+ * @param response Pointer to the frame.
+ */
+static void send_response(USART_TypeDef *uart, struct ResponseFrame *response)
+{
+    const uint16_t length = response_frame_end(response);
+
+    //without room in the transmit queue the response is lost, as any other reply
+    if (length > 0)
+    {
+        (void)UART_CommitBuffer(uart, response->data, length);
+    }
+}
+
+/**
+ * @brief Sends a response frame that only carries a status.
+ *
+ * @param uart The USART the response goes to.
+ * @param format FRAME_FORMAT_XML or FRAME_FORMAT_BINARY.
+ * @param cmd_id Id of the command, RESPONSE_FRAME_NO_COMMAND if it is unknown.
+ * @param name Name of the command, NULL if it is unknown.
+ * @param status The status.
+ */
+static void send_status_response(USART_TypeDef *uart, uint8_t format, uint8_t cmd_id, const char *name, uint8_t status)
+{
+    const uint16_t name_length = name ? (uint16_t) strlen(name) : 0U;
+    struct ResponseFrame response;
+
+    begin_response(uart, &response, format, response_frame_size(format, name_length));
+    response_frame_command(&response, cmd_id, name, name_length);
+    response_frame_status(&response, status);
+    send_response(uart, &response);
+}
+
+/**
+ * @brief Runs the callback of a validated command and adds its response to the frame.
+ *
+ * The response is built in the transmit queue while the callback runs: the callback
+ * writes its values into the room reserved for the frame and the status follows once
+ * the callback has returned.
+ *
+ * @param port Pointer to the command line port the command was received on, the response goes back to it.
+ * @param command_content Pointer to the command, its callback_index selects the command list entry.
+ * @param cmd_id Id of the command, sent back in binary responses.
+ * @param response Pointer to the response frame of the received frame.
+ * @return uint8_t XML_OK, or INVALID_OPERATION if the callback failed.
+ */
+static uint8_t run_command(struct CommandLinePort *port, struct XMLDataExtractionResult *command_content,
+                           uint8_t cmd_id, struct ResponseFrame *response)
+{
+    const struct CommandEntry *command = &g_cmd_list[command_content->callback_index];
+    uint8_t status = XML_OK;
+
+    response_frame_command(response, cmd_id, command->cmd, command->cmd_length);
+
+    command_content->port = port;
+    command_content->response = response;
+
+    // Call the corresponding callback function from the global command list
+    if (command->callback(command_content) != SUCCESS)
+    {
+        status = INVALID_OPERATION;
+    }
+
+    //the internal XML_OK is not sent, a command that ran reports RESPONSE_STATUS_OK
+    response_frame_status(response, (status == XML_OK) ? RESPONSE_STATUS_OK : status);
+
+    return status;
+}
+
+/**
+ * @brief Executes the batch of commands of a received frame and sends one response for the whole frame.
+ *
+ * Every command of the batch is validated before the first one runs, so a batch with an
+ * unknown command or an invalid parameter is rejected as a whole and never applied half
+ * way; the only response is then the one of the rejected command, with its status. A
+ * batch whose responses would not fit the room a USART can reserve is rejected with
+ * TOO_MANY_COMMANDS the same way.
+ *
+ * The commands then run in the order they were received, and each one adds its
+ * <RSP> group to the single response of the frame. The batch stops at the first
+ * callback that fails, whose group carries INVALID_OPERATION; the commands after it
+ * do not run and their groups carry COMMAND_SKIPPED. A host can therefore match every
+ * command it sent to a status by its name and order, even while it keeps sending.
+ *
+ * Please note that the commands are extracted once to validate them and once more to run
+ * them, so only one XMLDataExtractionResult is on the stack at a time.
+ *
+ * @param port Pointer to the command line port the frame was received on, the response goes back to it.
+ * @param xml Pointer to the received frame.
+ * @param layout Pointer to the commands, tags and arguments recorded by the frame tokenizer.
+ */
+void execute_callback_functions(struct CommandLinePort *port, const char *xml, const struct FrameLayout *layout)
+{
+    USART_TypeDef *uart = HAL_USART_Instance(port->usart);
+    struct XMLDataExtractionResult command_content;
+    struct ResponseFrame response;
+    const struct CommandEntry *command = NULL;
+    const char *name = NULL;       //name of the rejected command, if it is in the command list
+    uint32_t reply_size = RESPONSE_FRAME_XML_ENVELOPE;   //the envelope once, the rest of every response
+    uint8_t command_index = 0;
+    uint8_t index = 0;
+    uint8_t status = XML_OK;
+
+    //check the input and the size of the batch
+    if (!xml || !layout)
+    {
+        status = INVALID_OPERATION;
+    }
+    else if (layout->cmd_overflow)
+    {
+        status = TOO_MANY_COMMANDS;
+    }
+    else if (layout->cmd_count == 0)
+    {
+        status = BAD_XML;
+    }
+
+    //validate every command before the first one runs
+    for (index = 0; status == XML_OK && index < layout->cmd_count; ++index)
+    {
+        command_content = extract_command_and_params_from_xml(xml, layout, index);
+
+        if (command_content.callback_index >= COMMAND_COUNT)
+        {
+            status = command_content.callback_index;
+
+            //a known command with an invalid parameter is named in the response
+            command_index = find_command_in_list(get_slice_data(&command_content, &command_content.cmd),
+                                                 command_content.cmd.length);
+            if (command_index < COMMAND_COUNT)
+            {
+                name = g_cmd_list[command_index].cmd;
+            }
+            break;
+        }
+
+        reply_size += (uint32_t)g_cmd_list[command_content.callback_index].reply_size - RESPONSE_FRAME_XML_ENVELOPE;
+    }
+
+    //the response of the whole batch is reserved at once, so it has to fit
+    if (status == XML_OK && reply_size > USART_TX_RESERVE_MAX)
+    {
+        status = TOO_MANY_COMMANDS;
+    }
+
+    if (status != XML_OK)
+    {
+        send_status_response(uart, FRAME_FORMAT_XML, RESPONSE_FRAME_NO_COMMAND, name, status);
+        return;
+    }
+
+    begin_response(uart, &response, FRAME_FORMAT_XML, (uint16_t) reply_size);
+
+    //run the commands in the order they were received, up to the first one that fails
+    for (index = 0; index < layout->cmd_count; ++index)
+    {
+        command_content = extract_command_and_params_from_xml(xml, layout, index);
+
+        if (status == XML_OK)
+        {
+            status = run_command(port, &command_content, command_content.callback_index, &response);
+        }
+        else
+        {
+            command = &g_cmd_list[command_content.callback_index];
+            response_frame_command(&response, command_content.callback_index, command->cmd, command->cmd_length);
+            response_frame_status(&response, COMMAND_SKIPPED);
+        }
+    }
+
+    send_response(uart, &response);
+}
+
+/**
+ * @brief Binds and decodes the TLV parameters of a binary frame.
+ *
+ * @param command Pointer to the command list entry of the received command.
+ * @param frame Pointer to the decoded payload of the frame.
+ * @param end Offset of the CRC, the parameters end there.
+ * @param args Pointer to the array of MAX_COMMAND_PARAMS arguments to fill in, in schema order.
+ * @return XML_Parser_Status_t XML_OK, BAD_XML for a truncated parameter, MISSING_PARAMETER,
+ *         BAD_PARAMETER, PARAMETER_OUT_OF_RANGE or UNKNOWN_PARAMETER.
+ */
+static XML_Parser_Status_t decode_binary_params(const struct CommandEntry *command, const uint8_t *frame,
+                                                uint16_t end, struct CommandArgument *args)
+{
+    XML_Parser_Status_t outcome = XML_OK;
+    Param_Status_t param_status = PARAM_OK;
+    uint16_t offset = 1;    //the parameters follow the command id
+    uint8_t param_index = 0;
+    uint8_t value_length = 0;
+
+    while (offset < end && outcome == XML_OK)
+    {
+        //the type, the length and the value have to fit before the CRC
+        if ((uint32_t)offset + BINARY_FRAME_TLV_HEADER > end ||
+            (uint32_t)offset + BINARY_FRAME_TLV_HEADER + frame[offset + 1] > end)
         {
-           // Print the corresponding error message to the UART port
-           UART_WriteData(USART2, (const char*) XML_Proccessing_Messages[index]);
+            outcome = BAD_XML;
+            break;
+        }
+
+        param_index  = frame[offset];
+        value_length = frame[offset + 1];
+        offset += BINARY_FRAME_TLV_HEADER;
+
+        //the type is the position of the parameter in the schema, it can only be sent once
+        if (param_index >= command->param_count || args[param_index].present)
+        {
+            outcome = UNKNOWN_PARAMETER;
         }
-        //if index is not valid then return invalid operation message
         else
         {
-            UART_WriteData(USART2, (const char*) XML_Proccessing_Messages[INVALID_OPERATION_INDX]);
+            args[param_index].present    = true;
+            args[param_index].raw.offset = offset;
+            args[param_index].raw.length = value_length;
+
+            param_status = decode_binary_param(&command->params[param_index], &frame[offset], value_length,
+                                               &args[param_index].value);
+
+            if (param_status == PARAM_BAD_FORMAT)
+            {
+                outcome = BAD_PARAMETER;
+            }
+            else if (param_status == PARAM_OUT_OF_RANGE)
+            {
+                outcome = PARAMETER_OUT_OF_RANGE;
+            }
         }
+
+        offset += value_length;
     }
 
-    else if(commandContent->callback_index < NUMBER_OF_COMMANDS)
+    if (outcome == XML_OK)
     {
-        // Call the corresponding callback function from the global command list
-        // using the callback index provided in commandContent
-        g_cmd_list[commandContent->callback_index].callback(commandContent);
+        outcome = check_required_params(command, args);
     }
-    // Check if the callback index is greater than the maximum valid callback index
-    else if (commandContent->callback_index < NO_OF_PARSER_MESSAGES)
+
+    return outcome;
+}
+
+/**
+ * @brief Extracts the command and its parameters from a decoded binary frame.
+ *
+ * The payload is cmd_id, the TLV parameters and a big-endian CRC-16, see binary_frame.c.
+ * The command is dispatched through the same command list as XML commands, and the
+ * parameters are checked against the same schema.
+ *
+ * @param frame Pointer to the decoded payload.
+ * @param length Length of the payload in bytes.
+ * @return struct XMLDataExtractionResult The extracted command, with an empty `cmd` slice
+ *         since binary frames carry the command id instead of its name.
+ */
+struct XMLDataExtractionResult extract_command_and_params_from_binary(const uint8_t *frame, uint16_t length)
+{
+    struct XMLDataExtractionResult outcome;
+    uint16_t crc_offset = 0;
+    uint16_t received_crc = 0;
+
+    memset(&outcome, 0, sizeof(outcome));
+    outcome.format = FRAME_FORMAT_BINARY;
+    outcome.frame = (const char *)frame;
+
+    //the smallest frame is a command id and its CRC
+    if (!frame)
+    {
+        outcome.callback_index = INVALID_OPERATION;
+    }
+    else if (length < 1U + BINARY_FRAME_CRC_SIZE)
+    {
+        outcome.callback_index = BAD_XML;
+    }
+    else
     {
-        // Calculate the index for the specific error message based on the callback index
-        index = commandContent->callback_index - NO_COMMAND_FOUND;
-        
-        //validate index
-        if(index < XML_MSG_ARRAY_SIZE)
+        crc_offset = length - BINARY_FRAME_CRC_SIZE;
+        received_crc = (uint16_t)(((uint16_t)frame[crc_offset] << 8) | frame[crc_offset + 1]);
+
+        if (binary_frame_crc16(frame, crc_offset) != received_crc)
+        {
+            outcome.callback_index = BAD_CHECKSUM;
+        }
+        //the command id is the index of the command in the command list
+        else if (frame[0] >= COMMAND_COUNT)
         {
-           // Print the corresponding error message to the UART port
-           UART_WriteData(USART2, (const char*) XML_Proccessing_Messages[index]);
+            outcome.callback_index = NO_COMMAND_FOUND;
         }
-        //if index is not valid then return invalid operation message
         else
         {
-            UART_WriteData(USART2, (const char*) XML_Proccessing_Messages[INVALID_OPERATION_INDX]);
+            outcome.callback_index = decode_binary_params(&g_cmd_list[frame[0]], frame, crc_offset, outcome.args);
+
+            if (outcome.callback_index == XML_OK)
+            {
+                outcome.callback_index = frame[0];
+            }
         }
     }
+
+    return outcome;
+}
+
+/**
+ * @brief Executes the command of a decoded binary frame and sends a binary response.
+ *
+ * The response is a binary frame holding the command id, the status (RESPONSE_STATUS_OK
+ * or the parser status), the values the command reports as TLV triples and a CRC-16,
+ * so machine clients never have to parse text.
+ *
+ * @param port Pointer to the command line port the frame was received on, the response goes back to it.
+ * @param frame Pointer to the decoded payload.
+ * @param length Length of the payload in bytes.
+ */
+void execute_binary_frame(struct CommandLinePort *port, const uint8_t *frame, uint16_t length)
+{
+    USART_TypeDef *uart = HAL_USART_Instance(port->usart);
+    struct XMLDataExtractionResult command_content;
+    struct ResponseFrame response;
+    uint8_t cmd_id = RESPONSE_FRAME_NO_COMMAND;
+
+    command_content = extract_command_and_params_from_binary(frame, length);
+
+    if (frame && length > 0)
+    {
+        cmd_id = frame[0];
+    }
+
+    if (command_content.callback_index < COMMAND_COUNT)
+    {
+        begin_response(uart, &response, FRAME_FORMAT_BINARY, g_cmd_list[command_content.callback_index].reply_size);
+        (void)run_command(port, &command_content, cmd_id, &response);
+        send_response(uart, &response);
+    }
     else
     {
-        // Calculate the index for the "Invalid operation" error message
-        index =  INVALID_OPERATION - NO_COMMAND_FOUND;
-        
-        //validate index
-        if(index < XML_MSG_ARRAY_SIZE)
+        send_status_response(uart, FRAME_FORMAT_BINARY, cmd_id, NULL, command_content.callback_index);
+    }
+}
+
+/**
+ * @brief Sends the response of a frame that was rejected before it reached the parser.
+ *
+ * The receive ISR rejects invalid frames while they arrive and queues their status;
+ * the main loop sends the response in the format of the rejected frame. The response
+ * names the command the frame was rejected at if the ISR had received a known one,
+ * otherwise it only carries the status.
+ *
+ * @param port Pointer to the command line port the frame was received on.
+ * @param reply Pointer to the reply the receive ISR has queued.
+ */
+void send_parser_status(const struct CommandLinePort *port, const struct PendingReply *reply)
+{
+    uint8_t cmd_id = RESPONSE_FRAME_NO_COMMAND;
+    const char *name = NULL;
+
+    if (reply->command < COMMAND_COUNT)
+    {
+        cmd_id = reply->command;
+        name = g_cmd_list[reply->command].cmd;
+    }
+
+    send_status_response(HAL_USART_Instance(port->usart), reply->format, cmd_id, name, reply->status);
+}
+
+/**
+ * @brief Sends the replies of the frames the receive ISR has rejected, in the order the frames ended.
+ *
+ * The rejected frames and the received ones are queued apart, so a reply is held back
+ * while a frame that ended before it still waits to be executed. The ISR numbers both
+ * kinds, at most FRAME_RING_SLOTS + REPLY_QUEUE_DEPTH frames are waiting, so the numbers
+ * can be compared across their wrap around.
+ *
+ * Please note that the reply queue is read before the frame ring: a frame that ended
+ * before a queued reply has been published by then.
+ *
+ * @param port Pointer to the command line port.
+ */
+static void send_rejected_frames(struct CommandLinePort *port)
+{
+    struct PendingReply pending_reply;     //error reply of a frame the receive ISR has rejected
+    const struct FrameSlot *frame = NULL;  //oldest frame handed over by the receive ISR and not executed yet
+
+    while (reply_queue_peek(&port->replies, &pending_reply))
+    {
+        frame = frame_ring_acquire_read(&port->frames);
+
+        // The frame ended first, its response goes out first
+        if (frame && (int8_t)(uint8_t)(pending_reply.sequence - frame->sequence) > 0)
+        {
+            break;
+        }
+
+        send_parser_status(port, &pending_reply);
+        (void)reply_queue_pop(&port->replies, &pending_reply);
+    }
+}
+
+/**
+ * @brief Gives the slot of an executed frame back to the receive ISR.
+ *
+ * The response has been built in the transmit queue and does not point into the slot,
+ * so the slot is free as soon as the callbacks have returned.
+ *
+ * @param port Pointer to the command line port.
+ */
+static void release_executed_frame(struct CommandLinePort *port)
+{
+    frame_ring_release(&port->frames);
+
+    // Let a sender stopped by RTS go on once the ring has drained.
+    if (frame_ring_waiting(&port->frames) <= FRAME_RING_RTS_LOW)
+    {
+        HAL_USART_SetRts(port->usart, ENABLE);
+
+        // The receive ISR may have stopped the sender meanwhile, it only ever stops it
+        if (frame_ring_waiting(&port->frames) >= FRAME_RING_RTS_HIGH)
+        {
+            HAL_USART_SetRts(port->usart, DISABLE);
+        }
+    }
+}
+
+/**
+ * @brief Runs one iteration of the command line session of one port.
+ *
+ * Sends the replies of the frames the receive ISR has rejected before the oldest frame
+ * handed over by the ISR, then executes that frame, if there is one, and gives its slot
+ * back.
+ * Finally it carries out a baud rate switch requested by SetBaud.
+ *
+ * @param port Pointer to the command line port.
+ */
+static void command_line_poll_port(struct CommandLinePort *port)
+{
+    const struct FrameSlot *frame = NULL;  //frame handed over by the receive ISR
+
+    // Send the replies of the frames rejected while they were received, up to the next frame to execute.
+    send_rejected_frames(port);
+
+    // Check if the receive ISR has handed a frame over. Frames received after SetBaud
+    // wait for the switch, their replies go out at the new rate.
+    if (port->baud_switch.state != BAUD_SWITCH_REQUESTED)
+    {
+        frame = frame_ring_acquire_read(&port->frames);
+    }
+
+    if (frame)
+    {
+        // Execute the batch of commands of the frame, all of them are answered in one
+        // response frame. Nothing is copied, the commands and parameters are read from the slot.
+        if (frame->format == FRAME_FORMAT_BINARY)
         {
-           // Print the corresponding error message to the UART port
-           UART_WriteData(USART2, (const char*) XML_Proccessing_Messages[index]);
+            execute_binary_frame(port, (const uint8_t *)frame->data, frame->length);
         }
-        //if index is not valid then return invalid operation message
         else
         {
-            UART_WriteData(USART2, (const char*) XML_Proccessing_Messages[INVALID_OPERATION_INDX]);
+            execute_callback_functions(port, frame->data, &frame->tokenizer.layout);
         }
-        
+
+        // The received frame has been handled, its slot goes back to the receive ISR.
+        release_executed_frame(port);
     }
-    
+
+    // Switch the baud rate once the reply of SetBaud has been sent, or switch back without a confirmation.
+    baud_switch_poll(&port->baud_switch, port->usart, HAL_GetTick());
 }
 
+/**
+ * @brief Runs one iteration of the command line in the main loop.
+ *
+ * Gives every port with a command line session its turn; a port executes at most one
+ * frame per turn, so a busy machine link does not hold up the debug console.
+ * The firmware calls it forever from main(); the host simulation calls it between the
+ * bytes it feeds into the receive ISR.
+ */
+void command_line_poll(void)
+{
+    uint8_t usart = 0;
 
+    for (usart = 0; usart < (uint8_t)USART_PORT_COUNT; ++usart)
+    {
+        if (g_command_line_ports[usart] != NULL)
+        {
+            command_line_poll_port(g_command_line_ports[usart]);
+        }
+    }
+}
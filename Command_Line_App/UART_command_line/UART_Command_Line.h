@@ -2,40 +2,65 @@
 #define UCL_H
 
 #include "../../HAL/HAL-SYSTEM/inc/stm32f10x.h"
+#include "../frame_tokenizer/frame_tokenizer.h"
+#include "../binary_frame/binary_frame.h"
+#include "../param_decoder/param_decoder.h"
+#include "../response_frame/response_frame.h"
 #include <stdlib.h>
-#include <stdio.h>
 #include <string.h>
 #include <stdbool.h>
 
-#define XML_PARENT_TAG       (char *)"UCL"
-#define XML_TAG_CMD          (char *)"CMD"
-#define XML_TAG_PARAMETER    (char *)"PARAM"
-
-#define CMD_AND_PARAM_LENGTH           (uint8_t) 32 //command and parameter can be maximum 32 bytes long
-
-#define OPEN_TAG     (uint8_t) 0
-#define CLOSE_TAG    (uint8_t) 1
+#define MAX_COMMAND_PARAMS   (uint8_t) 8     //maximum number of parameters of a command
 
 /**
  * @brief Enum to define the indexes of the UART_Message array
 */
 typedef enum 
 {
-    ERR_NULL_POINTER,     // Index 0: "Error: CommandContent pointer is null.\n"
-    CMD_PROCESSED,        // Index 1: "Command received and processed.\n"
-    FIRST_CMD,            // Index 5: "\nFirst Command: %s\n"
-    SECOND_CMD,           // Index 6: "\nSecond Command: %s\n"
-    UART_MESSAGES_COUNT   // Total number of messages (useful for iteration)
+    ERR_NULL_POINTER      // Index 0: "Error: CommandContent pointer is null.\n"
 } UART_MessageIndex;
 
+struct CommandLinePort;
+struct PendingReply;
+
+/**
+ * @brief Slice of a received frame, given as an offset and a length into the frame buffer.
+ */
+struct XMLSlice
+{
+   uint16_t offset;  /*offset of the first byte of the slice in the frame buffer*/
+   uint16_t length;  /*number of bytes in the slice, the slice is not null-terminated*/
+};
+
+/**
+ * @brief A parameter of the received command, bound to its entry in the command schema.
+ */
+struct CommandArgument
+{
+   bool present;           /*true if the parameter was sent*/
+   struct XMLSlice raw;    /*slice holding the text of the parameter*/
+   union ParamData value;  /*parameter decoded according to the type declared in the command schema*/
+};
+
 /**
  * @brief Structure to hold the result of extracting data from an XML message.
+ *
+ * The command and its parameters are not copied out of the frame; they are slices
+ * into the received frame buffer, which stays valid until the callback returns.
+ * The parameters are also decoded and range-checked against the command schema, so
+ * callbacks read the native values from `args`, which is indexed by the position of
+ * the parameter in the schema. They report their values through `response`, in the
+ * order of the "reply" of the command schema.
  */
 struct XMLDataExtractionResult
 {
-   uint8_t callback_index;            /*index of the callback function to handle the command. */
-   char cmd[CMD_AND_PARAM_LENGTH];    /*pointer to the extracted XML command as a null-terminated string.*/
-   char param[CMD_AND_PARAM_LENGTH];  /*pointer to the extracted XML command parameter as a null-terminated string.*/
+   uint8_t callback_index;    /*index of the callback function to handle the command. */
+   uint8_t format;            /*FRAME_FORMAT_XML or FRAME_FORMAT_BINARY, the format of the received frame.*/
+   const char *frame;         /*pointer to the received frame the slices refer to.*/
+   struct CommandLinePort *port; /*command line port the frame was received on, the reply goes back to it.*/
+   struct XMLSlice cmd;       /*slice holding the extracted XML command.*/
+   struct CommandArgument args[MAX_COMMAND_PARAMS]; /*parameters of the command, in schema order.*/
+   struct ResponseFrame *response; /*response frame of the command, being built in the transmit queue of the port.*/
 };
 
 /**
@@ -49,11 +74,18 @@ typedef ErrorStatus (*CommandCallback)(const struct XMLDataExtractionResult *Com
 
 /**
 * @brief CommandEntry is used to configure input commands and callback functions
+*
+* The command list is generated from command_schema.json by Tools/gen_command_table.py,
+* see command_table.h.
 */
 struct CommandEntry
 {
-    const char *cmd;
-    CommandCallback callback;
+    const char *cmd;                /*name of the command*/
+    uint8_t cmd_length;             /*length of the name, without the null terminator*/
+    CommandCallback callback;       /*function handling the command*/
+    const struct ParamSpec *params; /*parameters of the command, NULL if it has none*/
+    uint8_t param_count;            /*number of entries in params*/
+    uint16_t reply_size;            /*bytes of the largest response frame of the command, in either format*/
 };
 
 /**
@@ -62,29 +94,40 @@ struct CommandEntry
  */
 typedef enum 
 {
-   XML_OK = 0xFA,              // Indicates that the XML parsing was successful
-   NO_COMMAND_FOUND = 0xFB,    // Indicates that no valid command was found in the XML
-   INVALID_OPERATION = 0xFC,   // Indicates that an invalid operation or unsupported command was encountered
-   BAD_XML = 0xFD,             // Indicates that the XML string is malformed or the expected tags were missing
-   NO_OF_PARSER_MESSAGES = 0xFF // Represents the total number of parser status messages; used as a limit or marker
+   XML_OK = 0xF0,              // Indicates that the XML parsing was successful
+   NO_COMMAND_FOUND = 0xF1,    // Indicates that no valid command was found in the XML
+   INVALID_OPERATION = 0xF2,   // Indicates that an invalid operation or unsupported command was encountered
+   BAD_XML = 0xF3,             // Indicates that the XML string is malformed or the expected tags were missing
+   MISSING_PARAMETER = 0xF4,   // Indicates that a parameter required by the command schema was not sent
+   BAD_PARAMETER = 0xF5,       // Indicates that a parameter is not a valid value of its declared type
+   PARAMETER_OUT_OF_RANGE = 0xF6, // Indicates that a parameter is outside of its declared range
+   UNKNOWN_PARAMETER = 0xF7,   // Indicates that a named parameter is not declared by the command, or was sent twice
+   TOO_MANY_PARAMETERS = 0xF8, // Indicates that more parameters were sent than the command declares
+   TOO_MANY_COMMANDS = 0xF9,   // Indicates that a batch holds more commands than a frame can carry
+   BAD_CHECKSUM = 0xFA,        // Indicates that the CRC of a binary frame does not match its payload
+   FRAME_BUSY = 0xFB,          // Indicates that the frame was dropped because every frame slot was waiting to be executed
+   LINE_ERROR = 0xFC,          // Indicates that the frame was dropped because one of its bytes was lost or received corrupted
+   COMMAND_SKIPPED = 0xFD      // Indicates that the command did not run because a command before it in the batch failed
 } XML_Parser_Status_t;
 
 
 /******************************function prototypes*******************************/
-//SetLedValue prototype
-ErrorStatus SetLedValue(const struct XMLDataExtractionResult *CommandContent);
-//GetHeaterValue
-ErrorStatus GetHeaterValue(const struct XMLDataExtractionResult *CommandContent);
+const char* get_slice_data(const struct XMLDataExtractionResult *CommandContent, const struct XMLSlice *slice);
+
+uint8_t find_command_in_list(const char* cmd, uint16_t cmd_length);
+
+struct XMLDataExtractionResult extract_command_and_params_from_xml(const char *xml,
+                                                                  const struct FrameLayout *layout,
+                                                                  uint8_t command_index);
 
-XML_Parser_Status_t extract_value_from_xml(const char *xml, const char *tag, 
-                                           char *tag_value, size_t value_size);
+void execute_callback_functions(struct CommandLinePort *port, const char *xml, const struct FrameLayout *layout);
 
-uint8_t find_command_in_list(const char* cmd);
+struct XMLDataExtractionResult extract_command_and_params_from_binary(const uint8_t *frame, uint16_t length);
 
-struct XMLDataExtractionResult extract_command_and_params_from_xml(const char *xml);
+void execute_binary_frame(struct CommandLinePort *port, const uint8_t *frame, uint16_t length);
 
-void execute_callback_functions(const struct XMLDataExtractionResult *commandContent);
+void send_parser_status(const struct CommandLinePort *port, const struct PendingReply *reply);
 
-const char* find_tag_location(const char *xml, const char *tag, uint8_t kind_of_tag);
+void command_line_poll(void);
 
 #endif //End of UCL_H
@@ -0,0 +1,56 @@
+/**
+  ******************************************************************************
+  * @file    command_table.c
+  * @brief   Command list and perfect hash table of the UART command line.
+  *
+  *          GENERATED by Tools/gen_command_table.py from command_schema.json.
+  *          Do not edit this file by hand, edit the schema instead.
+  ******************************************************************************/
+
+#include "command_table.h"
+
+static const struct ParamSpec g_params_lighton[] =
+{
+    {"value", true, PARAM_TYPE_U8, 0, 0, 100, NULL, 0},
+};
+
+static const struct ParamSpec g_params_getheater[] =
+{
+    {"heater", true, PARAM_TYPE_U8, 0, 0, 3, NULL, 0},
+};
+
+static const struct ParamSpec g_params_setpwm[] =
+{
+    {"ch", true, PARAM_TYPE_U8, 0, 0, 3, NULL, 0},
+    {"duty", true, PARAM_TYPE_FIXED, 1, 0, 1000, NULL, 0},
+    {"ramp", false, PARAM_TYPE_U16, 0, 0, 65535, NULL, 0},
+};
+
+static const struct ParamSpec g_params_setbaud[] =
+{
+    {"rate", true, PARAM_TYPE_I32, 0, 1200, 2250000, NULL, 0},
+};
+
+/*commands of the command line, indexed by CommandId_t*/
+const struct CommandEntry g_cmd_list[COMMAND_COUNT] =
+{
+    {"LightOn", 7, SetLedValue, g_params_lighton, 1, 65},
+    {"GetHeater", 9, GetHeaterValue, g_params_getheater, 1, 53},
+    {"SetPwm", 6, SetPwmValue, g_params_setpwm, 3, 103},
+    {"GetDiag", 7, GetDiagnostics, NULL, 0, 156},
+    {"SetBaud", 7, SetBaudRate, g_params_setbaud, 1, 136},
+    {"ConfirmBaud", 11, ConfirmBaudRate, NULL, 0, 76},
+    {"GetLineQuality", 14, GetLineQuality, NULL, 0, 205},
+};
+
+/*seed of the second hash for every bucket selected by the first hash*/
+const uint16_t g_cmd_hash_seeds[COMMAND_HASH_BUCKETS] =
+{
+    0, 5, 3, 1,
+};
+
+/*command index stored in every slot of the hash table*/
+const uint8_t g_cmd_hash_slots[COMMAND_HASH_SLOTS] =
+{
+    0x00, 0x04, 0x03, 0xFF, 0x01, 0x02, 0x05, 0x06,
+};
@@ -0,0 +1,47 @@
+/**
+  ******************************************************************************
+  * @file    command_table.h
+  * @brief   Command ids and lookup tables of the UART command line.
+  *
+  *          GENERATED by Tools/gen_command_table.py from command_schema.json.
+  *          Do not edit this file by hand, edit the schema instead.
+  ******************************************************************************/
+
+#ifndef COMMAND_TABLE_H
+#define COMMAND_TABLE_H
+
+#include "UART_Command_Line.h"
+
+#define COMMAND_COUNT              (uint8_t) 7   //number of commands in g_cmd_list
+#define COMMAND_HASH_BUCKETS       (uint32_t) 4  //number of displacement buckets, a power of two
+#define COMMAND_HASH_SLOTS         (uint32_t) 8  //number of hash table slots, a power of two
+#define COMMAND_HASH_EMPTY_SLOT    (uint8_t) 0xFF //marks a slot that holds no command
+
+/**
+ * @brief Ids of the commands, each id is the index of the command in g_cmd_list.
+ */
+typedef enum
+{
+    COMMAND_ID_LIGHTON = 0,
+    COMMAND_ID_GETHEATER = 1,
+    COMMAND_ID_SETPWM = 2,
+    COMMAND_ID_GETDIAG = 3,
+    COMMAND_ID_SETBAUD = 4,
+    COMMAND_ID_CONFIRMBAUD = 5,
+    COMMAND_ID_GETLINEQUALITY = 6,
+} CommandId_t;
+
+extern const struct CommandEntry g_cmd_list[COMMAND_COUNT];
+extern const uint16_t g_cmd_hash_seeds[COMMAND_HASH_BUCKETS];
+extern const uint8_t g_cmd_hash_slots[COMMAND_HASH_SLOTS];
+
+/******************************callback prototypes*******************************/
+ErrorStatus SetLedValue(const struct XMLDataExtractionResult *CommandContent);
+ErrorStatus GetHeaterValue(const struct XMLDataExtractionResult *CommandContent);
+ErrorStatus SetPwmValue(const struct XMLDataExtractionResult *CommandContent);
+ErrorStatus GetDiagnostics(const struct XMLDataExtractionResult *CommandContent);
+ErrorStatus SetBaudRate(const struct XMLDataExtractionResult *CommandContent);
+ErrorStatus ConfirmBaudRate(const struct XMLDataExtractionResult *CommandContent);
+ErrorStatus GetLineQuality(const struct XMLDataExtractionResult *CommandContent);
+
+#endif //End of COMMAND_TABLE_H
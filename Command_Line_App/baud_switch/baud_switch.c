@@ -0,0 +1,113 @@
+/**
+ * @file baud_switch.c
+ *
+ * @brief Baud rate switch of a command line port, negotiated with the client.
+ *
+ * The switch runs in three steps:
+ *  - SetBaud checks that the rate can be reached and requests the switch. Its reply
+ *    still goes out at the old rate, so the client knows the firmware is switching.
+ *  - Once the reply has left the transmit ring and the USART, the main loop switches the USART to the new rate and
+ *    the client is expected to switch too.
+ *  - The client sends ConfirmBaud at the new rate. If it does not arrive within
+ *    BAUD_SWITCH_CONFIRM_TICKS, e.g. because the client can not run at the new rate,
+ *    the firmware switches back to the last confirmed rate.
+ */
+
+#include "baud_switch.h"
+
+/**
+ * @brief Requests a switch to another baud rate, called from the SetBaud callback.
+ *
+ * A request while the previous switch waits for its confirmation confirms it: the
+ * request has arrived at the new rate.
+ *
+ * @param baud_switch Pointer to the switch.
+ * @param port The USART to switch.
+ * @param baud_rate The new rate.
+ *
+ * @return SUCCESS if the switch is requested, ERROR if the rate can not be reached
+ *         precisely enough or the input is invalid.
+ */
+ErrorStatus baud_switch_request(struct BaudSwitch *baud_switch, UsartPort_t port, uint32_t baud_rate)
+{
+    ErrorStatus outcome = ERROR;
+    struct UsartBaudSetting setting;
+
+    if (baud_switch && HAL_USART_ComputeBaud(port, baud_rate, &setting) == SUCCESS)
+    {
+        baud_switch->new_rate = baud_rate;
+        baud_switch->state = BAUD_SWITCH_REQUESTED;
+        outcome = SUCCESS;
+    }
+
+    return outcome;
+}
+
+/**
+ * @brief Confirms the rate the firmware has switched to, called from the ConfirmBaud callback.
+ *
+ * @param baud_switch Pointer to the switch.
+ *
+ * @return true if a switch was waiting for the confirmation.
+ */
+bool baud_switch_confirm(struct BaudSwitch *baud_switch)
+{
+    bool outcome = false;
+
+    if (baud_switch && baud_switch->state == BAUD_SWITCH_CONFIRMING)
+    {
+        baud_switch->state = BAUD_SWITCH_IDLE;
+        outcome = true;
+    }
+
+    return outcome;
+}
+
+/**
+ * @brief Carries the switch out, called from the main loop after every frame.
+ *
+ * Switches to a requested rate once the reply of the request has been sent, and
+ * switches back to the last confirmed rate if the confirmation does not arrive in time.
+ * While the reply is still on the line it returns at once and tries again on the next
+ * call, so the main loop does not wait for the transmitter.
+ *
+ * @param baud_switch Pointer to the switch.
+ * @param port The USART to switch.
+ * @param now The current SysTick tick.
+ */
+void baud_switch_poll(struct BaudSwitch *baud_switch, UsartPort_t port, uint32_t now)
+{
+    if (!baud_switch)
+    {
+        return;
+    }
+
+    if (baud_switch->state == BAUD_SWITCH_REQUESTED)
+    {
+        //the reply of the request still goes out at the current rate
+        if (!HAL_USART_TxIdle(port))
+        {
+            return;
+        }
+
+        //the request has arrived at the current rate, so that rate works
+        baud_switch->previous_rate = HAL_USART_GetBaudRate(port);
+
+        if (HAL_USART_SetBaudRate(port, baud_switch->new_rate) == SUCCESS)
+        {
+            baud_switch->deadline = now + BAUD_SWITCH_CONFIRM_TICKS;
+            baud_switch->state = BAUD_SWITCH_CONFIRMING;
+        }
+        else
+        {
+            baud_switch->state = BAUD_SWITCH_IDLE;
+        }
+    }
+    //the tick counter wraps around, only the difference to the deadline is compared
+    else if (baud_switch->state == BAUD_SWITCH_CONFIRMING && (int32_t)(now - baud_switch->deadline) >= 0)
+    {
+        (void)HAL_USART_SetBaudRate(port, baud_switch->previous_rate);
+        ++baud_switch->fallbacks;
+        baud_switch->state = BAUD_SWITCH_IDLE;
+    }
+}
@@ -0,0 +1,43 @@
+#ifndef BAUD_SWITCH_H
+#define BAUD_SWITCH_H
+
+#include "../../HAL/HAL-UART/inc/hal_usart_config.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define BAUD_SWITCH_CONFIRM_TICKS  (uint32_t) 2000   //SysTick ticks (ms) the client has to confirm a new rate
+
+/**
+ * @brief Steps of a baud rate switch.
+ */
+typedef enum
+{
+    BAUD_SWITCH_IDLE = 0,        // The rate is confirmed, nothing to do
+    BAUD_SWITCH_REQUESTED,       // SetBaud was accepted, the switch follows once its reply is sent
+    BAUD_SWITCH_CONFIRMING       // The new rate is in use and waits for ConfirmBaud
+} BaudSwitchState_t;
+
+/**
+ * @brief Baud rate switch negotiated with the client.
+ *
+ * SetBaud is answered at the old rate, then both ends switch. The client confirms the
+ * new rate with ConfirmBaud; without the confirmation the firmware goes back to the
+ * old rate, so a client that can not follow never loses the link.
+ *
+ * Only the main loop uses it, so it needs no lock.
+ */
+struct BaudSwitch
+{
+    uint8_t  state;           /*BaudSwitchState_t*/
+    uint32_t new_rate;        /*rate requested by SetBaud*/
+    uint32_t previous_rate;   /*last confirmed rate, the rate to fall back to*/
+    uint32_t deadline;        /*tick the confirmation has to arrive by*/
+    uint32_t fallbacks;       /*switches undone because they were not confirmed*/
+};
+
+/*************function prototypes**********************/
+ErrorStatus baud_switch_request(struct BaudSwitch *baud_switch, UsartPort_t port, uint32_t baud_rate);
+bool baud_switch_confirm(struct BaudSwitch *baud_switch);
+void baud_switch_poll(struct BaudSwitch *baud_switch, UsartPort_t port, uint32_t now);
+
+#endif // BAUD_SWITCH_H
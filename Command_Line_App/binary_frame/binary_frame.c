@@ -0,0 +1,179 @@
+/**
+ * @file binary_frame.c
+ *
+ * @brief COBS framing and CRC-16 of the compact binary protocol.
+ *
+ * Machine clients can send a binary frame instead of XML. A binary frame starts and
+ * ends with a 0x00 delimiter and carries a COBS-encoded payload, so the payload never
+ * contains the delimiter and the receiver resynchronises at the next 0x00:
+ *
+ *     0x00 | COBS( cmd_id | T L V ... | CRC-16 ) | 0x00
+ *
+ * cmd_id is the CommandId_t of the command, every parameter is a T(ype) L(ength)
+ * V(alue) triple where T is the position of the parameter in the command schema,
+ * and the CRC-16/CCITT-FALSE of cmd_id and the parameters is sent big-endian.
+ * "LightOn 10" is 9 bytes on the wire, delimiters included, against 46 bytes of XML.
+ *
+ * The decoder runs in the receive ISR, one byte at a time, and decodes in place.
+ */
+
+#include "binary_frame.h"
+
+#define COBS_MAX_BLOCK      (uint8_t) 0xFF  //code of a block of 254 data bytes without an implicit zero
+#define CRC16_INIT          (uint16_t) 0xFFFF
+
+/*CRC-16/CCITT-FALSE (polynomial 0x1021) of every nibble, processed 4 bits at a time*/
+static const uint16_t g_crc16_nibble_table[16] =
+{
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+/**
+ * @brief Resets the decoder so that it is ready for a new frame.
+ *
+ * @param decoder Pointer to the decoder state.
+ */
+void binary_frame_reset(struct BinaryFrameDecoder *decoder)
+{
+    if (decoder)
+    {
+        decoder->remaining    = 0;
+        decoder->zero_pending = false;
+        decoder->length       = 0;
+    }
+}
+
+/**
+ * @brief Feeds one received byte into the COBS decoder.
+ *
+ * The opening delimiter is not fed into the decoder; the next delimiter ends the frame.
+ *
+ * @param decoder Pointer to the decoder state.
+ * @param received_byte The received byte.
+ * @param frame Pointer to the buffer receiving the decoded payload.
+ * @param capacity Size of the buffer in bytes.
+ *
+ * @retval BINARY_FRAME_IN_PROGRESS if more bytes are needed.
+ * @retval BINARY_FRAME_COMPLETE if the frame has been decoded, its length is decoder->length.
+ * @retval BINARY_FRAME_EMPTY if the delimiter followed the opening delimiter.
+ * @retval BINARY_FRAME_BAD if a block is truncated, the frame does not fit or the input is invalid.
+ */
+Binary_Frame_Status_t binary_frame_feed(struct BinaryFrameDecoder *decoder, uint8_t received_byte,
+                                        uint8_t *frame, uint16_t capacity)
+{
+    Binary_Frame_Status_t outcome = BINARY_FRAME_IN_PROGRESS;
+
+    //validate input parameters
+    if (!decoder || !frame)
+    {
+        return BINARY_FRAME_BAD;
+    }
+
+    if (received_byte == BINARY_FRAME_DELIMITER)
+    {
+        //the implicit zero of the last block is not part of the payload
+        if (decoder->remaining != 0)
+        {
+            outcome = BINARY_FRAME_BAD;
+        }
+        else
+        {
+            outcome = (decoder->length == 0) ? BINARY_FRAME_EMPTY : BINARY_FRAME_COMPLETE;
+        }
+    }
+    else if (decoder->remaining == 0)
+    {
+        //a code byte ends the previous block, which may end with a zero
+        if (decoder->zero_pending)
+        {
+            if (decoder->length < capacity)
+            {
+                frame[decoder->length++] = 0;
+            }
+            else
+            {
+                outcome = BINARY_FRAME_BAD;
+            }
+        }
+
+        decoder->remaining    = received_byte - 1U;
+        decoder->zero_pending = (received_byte != COBS_MAX_BLOCK);
+    }
+    else if (decoder->length < capacity)
+    {
+        frame[decoder->length++] = received_byte;
+        --decoder->remaining;
+    }
+    else
+    {
+        outcome = BINARY_FRAME_BAD;
+    }
+
+    return outcome;
+}
+
+/**
+ * @brief Encodes a payload in place, for a frame built where it is sent from.
+ *
+ * The payload is written one byte after the position of the code byte, as it would
+ * be with a single block; every zero is then replaced by the distance to the next one,
+ * which needs no room beyond the payload as long as it holds fewer than 254 bytes.
+ * The delimiters are not written.
+ *
+ * @param frame Pointer to the code byte, the payload follows it.
+ * @param length Length of the payload in bytes, at most BINARY_FRAME_MAX_IN_PLACE.
+ *
+ * @return uint16_t Length of the encoded payload, code byte included, or 0 if it is too long.
+ */
+uint16_t binary_frame_encode_in_place(uint8_t *frame, uint16_t length)
+{
+    uint16_t code_index = 0;   //position of the code byte of the current block
+    uint16_t index = 0;
+
+    if (!frame || length > BINARY_FRAME_MAX_IN_PLACE)
+    {
+        return 0;
+    }
+
+    for (index = 1; index <= length; ++index)
+    {
+        //the zero becomes the code byte of the next block and ends the current one
+        if (frame[index] == 0)
+        {
+            frame[code_index] = (uint8_t)(index - code_index);
+            code_index = index;
+        }
+    }
+
+    frame[code_index] = (uint8_t)(length + 1U - code_index);
+
+    return (uint16_t)(length + 1U);
+}
+
+/**
+ * @brief Computes the CRC-16/CCITT-FALSE of a buffer.
+ *
+ * @param data Pointer to the data.
+ * @param length Length of the data in bytes.
+ *
+ * @return uint16_t The CRC, 0x29B1 for "123456789".
+ */
+uint16_t binary_frame_crc16(const uint8_t *data, uint16_t length)
+{
+    uint16_t crc = CRC16_INIT;
+    uint16_t index = 0;
+
+    if (!data)
+    {
+        return crc;
+    }
+
+    for (index = 0; index < length; ++index)
+    {
+        crc = (uint16_t)(g_crc16_nibble_table[(crc >> 12) ^ (data[index] >> 4)] ^ (crc << 4));
+        crc = (uint16_t)(g_crc16_nibble_table[(crc >> 12) ^ (data[index] & 0x0FU)] ^ (crc << 4));
+    }
+
+    return crc;
+}
@@ -0,0 +1,49 @@
+#ifndef BINARY_FRAME_H
+#define BINARY_FRAME_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define FRAME_FORMAT_XML            (uint8_t) 0     //frame made of <UCL>...</UCL> text
+#define FRAME_FORMAT_BINARY         (uint8_t) 1     //COBS-encoded binary frame
+
+#define BINARY_FRAME_DELIMITER      (uint8_t) 0x00  //starts and ends every binary frame
+#define BINARY_FRAME_CRC_SIZE       (uint16_t) 2    //size of the CRC-16 at the end of the payload
+#define BINARY_FRAME_TLV_HEADER     (uint16_t) 2    //type and length bytes of a parameter
+#define BINARY_FRAME_MAX_VALUE      (uint8_t) 4     //largest encoding of a numeric parameter
+#define BINARY_FRAME_MAX_IN_PLACE   (uint16_t) 253  //longest payload encoded in place, a single COBS block
+
+/**
+ * @brief Result of feeding one byte into the COBS decoder.
+ */
+typedef enum
+{
+    BINARY_FRAME_IN_PROGRESS = 0,  // the frame is not complete yet, keep receiving
+    BINARY_FRAME_COMPLETE,         // the closing delimiter has just been consumed
+    BINARY_FRAME_EMPTY,            // a delimiter without any data, e.g. idle fill between frames
+    BINARY_FRAME_BAD               // the encoding is broken or the frame does not fit in the buffer
+} Binary_Frame_Status_t;
+
+/**
+ * @brief State of the incremental COBS decoder.
+ *
+ * The decoded payload is written into the same buffer the encoded bytes are received
+ * in: a decoded frame is never longer than its encoding, so the decoder never writes
+ * ahead of the bytes that have been received.
+ */
+struct BinaryFrameDecoder
+{
+    uint8_t  remaining;     /*data bytes left in the current COBS block*/
+    bool     zero_pending;  /*true if the current block ends with an implicit zero*/
+    uint16_t length;        /*number of decoded bytes*/
+};
+
+/*************function prototypes**********************/
+void binary_frame_reset(struct BinaryFrameDecoder *decoder);
+Binary_Frame_Status_t binary_frame_feed(struct BinaryFrameDecoder *decoder, uint8_t received_byte,
+                                        uint8_t *frame, uint16_t capacity);
+uint16_t binary_frame_encode_in_place(uint8_t *frame, uint16_t length);
+uint16_t binary_frame_crc16(const uint8_t *data, uint16_t length);
+
+#endif // BINARY_FRAME_H
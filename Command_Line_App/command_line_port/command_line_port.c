@@ -0,0 +1,42 @@
+/**
+ * @file command_line_port.c
+ *
+ * @brief The command line sessions, one per USART enabled in hal_usart_ports.h.
+ *
+ * The sessions are allocated statically; a USART without a session costs no memory
+ * for frames.
+ */
+
+#include "command_line_port.h"
+
+#if USART1_COMMAND_LINE
+static struct CommandLinePort g_usart1_command_line = { .usart = USART_PORT_1 };
+#endif
+
+#if USART2_COMMAND_LINE
+static struct CommandLinePort g_usart2_command_line = { .usart = USART_PORT_2 };
+#endif
+
+#if USART3_COMMAND_LINE
+static struct CommandLinePort g_usart3_command_line = { .usart = USART_PORT_3 };
+#endif
+
+//session of every USART, indexed by UsartPort_t, NULL for a USART without a session
+struct CommandLinePort *const g_command_line_ports[USART_PORT_COUNT] =
+{
+#if USART1_COMMAND_LINE
+    &g_usart1_command_line,
+#else
+    NULL,
+#endif
+#if USART2_COMMAND_LINE
+    &g_usart2_command_line,
+#else
+    NULL,
+#endif
+#if USART3_COMMAND_LINE
+    &g_usart3_command_line,
+#else
+    NULL,
+#endif
+};
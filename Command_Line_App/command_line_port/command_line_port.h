@@ -0,0 +1,81 @@
+#ifndef COMMAND_LINE_PORT_H
+#define COMMAND_LINE_PORT_H
+
+#include "../frame_ring/frame_ring.h"
+#include "../reply_queue/reply_queue.h"
+#include "../baud_switch/baud_switch.h"
+#include "../binary_frame/binary_frame.h"
+#include "../tag_matcher/tag_matcher.h"
+#include "../../HAL/HAL-UART/inc/hal_usart_ports.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+//port errors that belong to no session are reported on, the first one that has a session
+#if USART1_COMMAND_LINE
+#define COMMAND_LINE_DEBUG_PORT  USART_PORT_1
+#elif USART2_COMMAND_LINE
+#define COMMAND_LINE_DEBUG_PORT  USART_PORT_2
+#elif USART3_COMMAND_LINE
+#define COMMAND_LINE_DEBUG_PORT  USART_PORT_3
+#else
+#error "at least one USART needs a command line session, see hal_usart_ports.h"
+#endif
+
+/**
+ * @brief State of the frame being received, owned by the receive ISR of the port.
+ */
+struct RxAssembler
+{
+    struct FrameSlot *slot;                  /*slot of the frame ring the current frame is received into, NULL between frames*/
+    struct BinaryFrameDecoder binary_decoder;/*decoder of the frame being received when it is a binary frame*/
+    uint8_t format;                          /*format of the frame being received, selected by its first byte*/
+    bool discarding;                         /*true while the rest of a rejected frame is skipped without a buffer*/
+    uint8_t sequence;                        /*number of the next frame handed over or rejected, wraps around*/
+    struct TagMatcher discard_matcher;       /*matcher looking for the end of a rejected XML frame*/
+    uint16_t ring_read;                      /*next byte of the receive ring to assemble, the DMA writes ahead of it*/
+    uint32_t char_index;                     /*position in the frame being received*/
+    uint32_t frame_start_tick;               /*SysTick tick the frame being received started at*/
+    uint32_t last_byte_tick;                 /*SysTick tick its last byte was seen at*/
+    uint32_t timeout_baud_rate;              /*baud rate the timeouts were converted at, the rate can change at run time*/
+    uint32_t inter_byte_timeout_ticks;       /*RX_INTER_BYTE_TIMEOUT_BITS in ticks*/
+    uint32_t frame_timeout_ticks;            /*RX_FRAME_TIMEOUT_BITS in ticks*/
+};
+
+/**
+ * @brief Counters of the receive path: the frames it has abandoned and the quality of the line.
+ */
+struct UartRxStats
+{
+    volatile uint32_t inter_byte_timeouts;  /*frames abandoned because the line stayed silent in the middle of them*/
+    volatile uint32_t frame_timeouts;       /*frames abandoned because they took too long as a whole*/
+    volatile uint32_t bytes_received;       /*bytes taken from the receive ring, corrupted ones included*/
+    volatile uint32_t overruns;             /*bytes lost because the DMA did not read DR in time (ORE)*/
+    volatile uint32_t framing_errors;       /*bytes without a stop bit, e.g. sent at another rate or a break (FE)*/
+    volatile uint32_t noise_errors;         /*bytes whose samples disagreed (NE)*/
+    volatile uint32_t parity_errors;        /*bytes with a wrong parity bit, only with parity configured (PE)*/
+    volatile uint32_t corrupted_frames;     /*frames abandoned because one of their bytes was lost or corrupted*/
+};
+
+/**
+ * @brief An independent command line session on one USART.
+ *
+ * Every session receives into its own frame ring, keeps its own counters and baud
+ * rate, and replies on the USART the frame came from, so e.g. a debug console and a
+ * machine link can run side by side. The receive ISR of the port owns rx; the main
+ * loop executes the frames and sends the replies.
+ */
+struct CommandLinePort
+{
+    UsartPort_t usart;                 /*USART the session runs on*/
+    struct RxAssembler rx;             /*frame being received*/
+    struct UartRxStats rx_stats;       /*timeout and line error counters of the receive path*/
+    struct FrameRing frames;           /*frames handed over from the receive ISR to the main loop*/
+    struct ReplyQueue replies;         /*replies for the frames the receive ISR has rejected*/
+    struct BaudSwitch baud_switch;     /*baud rate switch negotiated with the client*/
+};
+
+//session of every USART, indexed by UsartPort_t, NULL for a USART without a session
+extern struct CommandLinePort *const g_command_line_ports[USART_PORT_COUNT];
+
+#endif // COMMAND_LINE_PORT_H
@@ -0,0 +1,130 @@
+/**
+ * @file frame_ring.c
+ *
+ * @brief Ring of received frames between the receive ISR and the main loop.
+ *
+ * The ISR receives every frame straight into a slot of the ring and publishes the slot
+ * when the frame is complete; the main loop executes the frame from the same slot and
+ * releases it as soon as the callbacks have returned. Nothing is allocated or copied
+ * to hand the frame over; the reply is built in the transmit queue and does not point
+ * into the slot.
+ *
+ * The indices have acquire/release semantics: a side reads the other side's index
+ * before it touches a slot, and writes its own index only after it is done with the
+ * slot. The barriers order those accesses for the compiler and the core.
+ */
+
+#include "frame_ring.h"
+#include "../../HAL/HAL-SYSTEM/inc/stm32f10x.h"
+
+/**
+ * @brief Takes the slot the next frame is received into, called from the receive ISR.
+ *
+ * Calling it again before the slot is published returns the same slot.
+ *
+ * @param ring Pointer to the ring.
+ *
+ * @return struct FrameSlot* The free slot, or NULL if every slot waits for the main loop;
+ *         the caller then drops the frame and counts it in ring->dropped.
+ */
+struct FrameSlot *frame_ring_acquire_write(struct FrameRing *ring)
+{
+    struct FrameSlot *outcome = NULL;
+    uint8_t head = 0;
+
+    if (ring)
+    {
+        head = ring->head;
+
+        //the ring is full when the head is a whole lap ahead of the tail
+        if ((uint8_t)(head - ring->tail) < FRAME_RING_SLOTS)
+        {
+            //acquire: the main loop is done with the slot before it is written again
+            __DMB();
+            outcome = &ring->slots[head & (FRAME_RING_SLOTS - 1U)];
+        }
+    }
+
+    return outcome;
+}
+
+/**
+ * @brief Hands the slot returned by frame_ring_acquire_write() over to the main loop.
+ *
+ * @param ring Pointer to the ring.
+ */
+void frame_ring_publish(struct FrameRing *ring)
+{
+    uint8_t waiting = 0;
+
+    if (ring)
+    {
+        //release: the frame is written before the main loop can see it
+        __DMB();
+        ring->head = (uint8_t)(ring->head + 1U);
+
+        //the depth the ring needs for the traffic it sees
+        waiting = (uint8_t)(ring->head - ring->tail);
+
+        if (waiting > ring->high_water)
+        {
+            ring->high_water = waiting;
+        }
+    }
+}
+
+/**
+ * @brief Takes the oldest received frame, called from the main loop.
+ *
+ * Calling it again before the slot is released returns the same frame.
+ *
+ * @param ring Pointer to the ring.
+ *
+ * @return const struct FrameSlot* The frame, or NULL if no frame has been received.
+ */
+const struct FrameSlot *frame_ring_acquire_read(struct FrameRing *ring)
+{
+    const struct FrameSlot *outcome = NULL;
+    uint8_t tail = 0;
+
+    if (ring)
+    {
+        tail = ring->tail;
+
+        if (tail != ring->head)
+        {
+            //acquire: the frame is read only after it has been published
+            __DMB();
+            outcome = &ring->slots[tail & (FRAME_RING_SLOTS - 1U)];
+        }
+    }
+
+    return outcome;
+}
+
+/**
+ * @brief Gives the slot returned by frame_ring_acquire_read() back to the receive ISR once its frame is executed.
+ *
+ * @param ring Pointer to the ring.
+ */
+void frame_ring_release(struct FrameRing *ring)
+{
+    if (ring && ring->tail != ring->head)
+    {
+        //release: the frame has been read before the ISR can overwrite it
+        __DMB();
+        ring->tail = (uint8_t)(ring->tail + 1U);
+    }
+}
+
+/**
+ * @brief Counts the frames that wait for the main loop.
+ *
+ * @param ring Pointer to the ring.
+ *
+ * @return uint8_t Number of published frames that have not been released yet.
+ */
+uint8_t frame_ring_waiting(const struct FrameRing *ring)
+{
+    return ring ? (uint8_t)(ring->head - ring->tail) : 0U;
+}
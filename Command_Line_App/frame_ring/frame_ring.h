@@ -0,0 +1,60 @@
+#ifndef FRAME_RING_H
+#define FRAME_RING_H
+
+#include "../frame_tokenizer/frame_tokenizer.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define FRAME_RING_SLOTS    8U               //frames that can wait for the main loop, must be a power of two
+#define FRAME_SLOT_SIZE     (uint16_t) 256   //largest frame in bytes, its null terminator included
+#define FRAME_RING_BUSY_NAK 1                //1 to reply BUSY to a frame dropped because every slot is in use
+#define FRAME_RING_RTS_HIGH 6U               //frames waiting when RTS stops the sender, leaves a slot for a frame already on its way
+#define FRAME_RING_RTS_LOW  2U               //frames waiting when RTS lets the sender go on
+
+#if (FRAME_RING_SLOTS == 0U) || ((FRAME_RING_SLOTS & (FRAME_RING_SLOTS - 1U)) != 0U) || (FRAME_RING_SLOTS > 128U)
+#error "FRAME_RING_SLOTS must be a power of two between 1 and 128"
+#endif
+
+#if (FRAME_RING_RTS_LOW >= FRAME_RING_RTS_HIGH) || (FRAME_RING_RTS_HIGH >= FRAME_RING_SLOTS)
+#error "FRAME_RING_RTS_LOW must be below FRAME_RING_RTS_HIGH, which must leave a slot free"
+#endif
+
+/**
+ * @brief One received frame, written in place by the receive ISR.
+ */
+struct FrameSlot
+{
+    char data[FRAME_SLOT_SIZE];       /*XML text or decoded binary payload, null-terminated*/
+    uint16_t length;                  /*number of bytes in data, the null terminator excluded*/
+    uint8_t format;                   /*FRAME_FORMAT_XML or FRAME_FORMAT_BINARY*/
+    uint8_t sequence;                 /*number of the frame, counted by the receive ISR with the frames it rejects*/
+    struct FrameTokenizer tokenizer;  /*tokenizer the frame was received through, its layout describes an XML frame*/
+};
+
+/**
+ * @brief Single-producer single-consumer ring of received frames.
+ *
+ * The receive ISR is the only producer and the main loop the only consumer. Each side
+ * only writes its own index and takes its own pointer to a slot, so the two contexts
+ * never share a mutable pointer. The slot at head belongs to the ISR until it is
+ * published; published slots belong to the main loop until they are released. The
+ * main loop executes the frame at tail and releases its slot right after.
+ */
+struct FrameRing
+{
+    struct FrameSlot slots[FRAME_RING_SLOTS];  /*received frames*/
+    volatile uint8_t head;                     /*slot the ISR receives into, written by the ISR*/
+    volatile uint8_t tail;                     /*oldest published slot, written by the main loop*/
+    volatile uint8_t high_water;               /*most frames that have waited at once, written by the ISR*/
+    volatile uint32_t dropped;                 /*frames dropped because every slot was in use, written by the ISR*/
+    volatile uint32_t overflowed;              /*frames rejected because they did not fit in a slot, written by the ISR*/
+};
+
+/*************function prototypes**********************/
+struct FrameSlot *frame_ring_acquire_write(struct FrameRing *ring);
+void frame_ring_publish(struct FrameRing *ring);
+const struct FrameSlot *frame_ring_acquire_read(struct FrameRing *ring);
+void frame_ring_release(struct FrameRing *ring);
+uint8_t frame_ring_waiting(const struct FrameRing *ring);
+
+#endif // FRAME_RING_H
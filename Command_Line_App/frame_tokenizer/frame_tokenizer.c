@@ -0,0 +1,305 @@
+/**
+ * @file frame_tokenizer.c
+ *
+ * @brief Incremental tokenizer for the XML frames received over UART.
+ *
+ * The tokenizer consumes one byte at a time, straight from the receive ISR, and
+ * records where the known tags (<UCL>, <CMD>, <PARAM> and their closing tags) start
+ * and end while the frame is still arriving. The tags are recognised by the tag
+ * matcher, so the amount of work per byte is constant and the buffer is never
+ * searched again, neither in the ISR nor in the parser.
+ *
+ * Every <CMD>, <PARAM> and <P name="..."> element is also added to the command and
+ * argument tables of the frame layout, so one frame can carry a batch of commands,
+ * each with several parameters.
+ */
+
+#include "frame_tokenizer.h"
+
+/**
+ * @brief Marks every tag of a frame layout as not found and empties its argument table.
+ *
+ * @param layout Pointer to the frame layout.
+ */
+void frame_layout_reset(struct FrameLayout *layout)
+{
+    if (layout)
+    {
+        tag_matcher_reset_offsets(&layout->tags);
+        layout->cmd_count    = 0;
+        layout->arg_count    = 0;
+        layout->cmd_overflow = false;
+        layout->arg_overflow = false;
+    }
+}
+
+/**
+ * @brief Resets the tokenizer so that it is ready for a new frame.
+ *
+ * @param tokenizer Pointer to the tokenizer state.
+ */
+void frame_tokenizer_reset(struct FrameTokenizer *tokenizer)
+{
+    if (tokenizer)
+    {
+        tag_matcher_reset(&tokenizer->matcher);
+
+        //mark all the tags as not received
+        frame_layout_reset(&tokenizer->layout);
+        tokenizer->open_arg_tag = NO_OF_FRAME_TAGS;
+        tokenizer->cmd_open     = false;
+        tokenizer->leading_args = 0;
+    }
+}
+
+/**
+ * @brief Adds <CMD> elements to the command table.
+ *
+ * @param tokenizer Pointer to the tokenizer state.
+ * @param match Pointer to the completed <CMD> or </CMD> tag.
+ *
+ * @retval Tokenizer_Status_t status of the frame after this tag.
+ */
+static Tokenizer_Status_t record_command(struct FrameTokenizer *tokenizer, const struct TagMatch *match)
+{
+    Tokenizer_Status_t outcome = TOKENIZER_IN_PROGRESS;
+    struct FrameLayout *layout = &tokenizer->layout;
+    struct FrameCommand *command = NULL;
+
+    if (match->kind_of_tag == OPEN_TAG)
+    {
+        //commands can not be nested or sent inside an argument
+        if (tokenizer->cmd_open || tokenizer->open_arg_tag != NO_OF_FRAME_TAGS)
+        {
+            outcome = TOKENIZER_BAD_FRAME;
+        }
+        else
+        {
+            tokenizer->cmd_open = true;
+
+            if (layout->cmd_count < FRAME_MAX_COMMANDS)
+            {
+                command = &layout->cmds[layout->cmd_count];
+                command->name_offset = match->end + 1;
+                command->name_length = 0;
+
+                //the arguments received before the first command belong to it
+                command->first_arg = (layout->cmd_count == 0) ? 0 : layout->arg_count;
+                command->arg_count = (layout->cmd_count == 0) ? tokenizer->leading_args : 0;
+            }
+            else
+            {
+                //the parser rejects the frame, the rest of it is still tokenized
+                layout->cmd_overflow = true;
+            }
+        }
+    }
+    else
+    {
+        if (!tokenizer->cmd_open)
+        {
+            outcome = TOKENIZER_BAD_FRAME;
+        }
+        else
+        {
+            tokenizer->cmd_open = false;
+
+            if (layout->cmd_count < FRAME_MAX_COMMANDS)
+            {
+                command = &layout->cmds[layout->cmd_count];
+                command->name_length = match->start - command->name_offset;
+                ++layout->cmd_count;
+            }
+
+            //the receiver can check the command before the rest of the frame arrives
+            outcome = TOKENIZER_COMMAND_COMPLETE;
+        }
+    }
+
+    return outcome;
+}
+
+/**
+ * @brief Adds <PARAM> and <P> elements to the argument table.
+ *
+ * @param tokenizer Pointer to the tokenizer state.
+ * @param match Pointer to the completed <PARAM> or <P> tag.
+ *
+ * @retval Tokenizer_Status_t status of the frame after this tag.
+ */
+static Tokenizer_Status_t record_argument(struct FrameTokenizer *tokenizer, const struct TagMatch *match)
+{
+    Tokenizer_Status_t outcome = TOKENIZER_IN_PROGRESS;
+    struct FrameLayout *layout = &tokenizer->layout;
+    struct FrameArgument *argument = NULL;
+
+    if (match->kind_of_tag == OPEN_TAG)
+    {
+        //arguments can not be nested or sent inside a command, and a <P> has to be named
+        if (tokenizer->open_arg_tag != NO_OF_FRAME_TAGS || tokenizer->cmd_open ||
+            (match->tag == FRAME_TAG_P && match->name_start == FRAME_TAG_NOT_FOUND))
+        {
+            outcome = TOKENIZER_BAD_FRAME;
+        }
+        else
+        {
+            tokenizer->open_arg_tag = match->tag;
+
+            if (layout->arg_count < FRAME_MAX_ARGS)
+            {
+                argument = &layout->args[layout->arg_count];
+                argument->name_offset  = match->name_start;
+                argument->name_length  = match->name_length;
+                argument->value_offset = match->end + 1;
+                argument->value_length = 0;
+            }
+            else
+            {
+                //the parser rejects the frame, the rest of it is still tokenized
+                layout->arg_overflow = true;
+            }
+        }
+    }
+    else
+    {
+        //the closing tag has to match the element being received
+        if (tokenizer->open_arg_tag != match->tag)
+        {
+            outcome = TOKENIZER_BAD_FRAME;
+        }
+        else
+        {
+            tokenizer->open_arg_tag = NO_OF_FRAME_TAGS;
+
+            if (layout->arg_count < FRAME_MAX_ARGS)
+            {
+                argument = &layout->args[layout->arg_count];
+                argument->value_length = match->start - argument->value_offset;
+                ++layout->arg_count;
+
+                //the argument belongs to the last command received
+                if (layout->cmd_count > 0)
+                {
+                    ++layout->cmds[layout->cmd_count - 1].arg_count;
+                }
+                else
+                {
+                    ++tokenizer->leading_args;
+                }
+            }
+        }
+    }
+
+    return outcome;
+}
+
+/**
+ * @brief Records a completed tag and checks the frame structure.
+ *
+ * @param tokenizer Pointer to the tokenizer state.
+ * @param match Pointer to the completed tag.
+ *
+ * @retval Tokenizer_Status_t status of the frame after this tag.
+ */
+static Tokenizer_Status_t record_tag(struct FrameTokenizer *tokenizer, const struct TagMatch *match)
+{
+    Tokenizer_Status_t outcome = TOKENIZER_IN_PROGRESS;
+    struct FrameTagOffsets *tags = &tokenizer->layout.tags;
+
+    //nothing may come before the parent tag
+    if (tags->open[FRAME_TAG_UCL] == FRAME_TAG_NOT_FOUND)
+    {
+        if (match->tag == FRAME_TAG_UCL && match->kind_of_tag == OPEN_TAG && !match->malformed)
+        {
+            tags->open[FRAME_TAG_UCL] = match->end + 1;
+        }
+        else
+        {
+            outcome = TOKENIZER_BAD_FRAME;
+        }
+    }
+    else if (match->tag < NO_OF_FRAME_TAGS)
+    {
+        //the attributes of a known tag have to be well-formed
+        if (match->malformed)
+        {
+            outcome = TOKENIZER_BAD_FRAME;
+        }
+        else if (match->tag == FRAME_TAG_PARAM || match->tag == FRAME_TAG_P)
+        {
+            outcome = record_argument(tokenizer, match);
+        }
+        else if (match->tag == FRAME_TAG_CMD)
+        {
+            outcome = record_command(tokenizer, match);
+        }
+
+        if (outcome == TOKENIZER_BAD_FRAME)
+        {
+            //nothing else to record
+        }
+        else if (match->kind_of_tag == OPEN_TAG)
+        {
+            //only the first occurrence of a tag is recorded
+            if (tags->open[match->tag] == FRAME_TAG_NOT_FOUND)
+            {
+                tags->open[match->tag] = match->end + 1;
+            }
+        }
+        else
+        {
+            if (tags->close[match->tag] == FRAME_TAG_NOT_FOUND)
+            {
+                tags->close[match->tag] = match->start;
+            }
+
+            //the closing parent tag completes the frame, unless an element is still open
+            if (match->tag == FRAME_TAG_UCL)
+            {
+                outcome = (tokenizer->open_arg_tag == NO_OF_FRAME_TAGS && !tokenizer->cmd_open) ?
+                          TOKENIZER_FRAME_COMPLETE : TOKENIZER_BAD_FRAME;
+            }
+        }
+    }
+    //unknown tags are skipped
+
+    return outcome;
+}
+
+/**
+ * @brief Feeds one received byte into the tokenizer.
+ *
+ * @param tokenizer Pointer to the tokenizer state.
+ * @param received_char The received byte.
+ * @param offset Offset of the received byte in the frame buffer.
+ *
+ * @retval TOKENIZER_IN_PROGRESS if more bytes are needed.
+ * @retval TOKENIZER_FRAME_COMPLETE if the closing parent tag has been consumed.
+ * @retval TOKENIZER_BAD_FRAME if the frame is malformed or the input is invalid.
+ * @retval TOKENIZER_COMMAND_COMPLETE if a </CMD> tag has been consumed, the last entry of the
+ *         command table (or cmd_overflow) tells which command it closed.
+ */
+Tokenizer_Status_t frame_tokenizer_feed(struct FrameTokenizer *tokenizer, char received_char, uint16_t offset)
+{
+    Tokenizer_Status_t outcome = TOKENIZER_IN_PROGRESS;
+    struct TagMatch match;
+
+    //validate input parameters
+    if (!tokenizer)
+    {
+        return TOKENIZER_BAD_FRAME;
+    }
+
+    if (tag_matcher_feed(&tokenizer->matcher, received_char, offset, &match))
+    {
+        outcome = record_tag(tokenizer, &match);
+    }
+    //the parent tag has to open the frame
+    else if (tokenizer->layout.tags.open[FRAME_TAG_UCL] == FRAME_TAG_NOT_FOUND &&
+             offset >= PARENT_TAG_WINDOW)
+    {
+        outcome = TOKENIZER_BAD_FRAME;
+    }
+
+    return outcome;
+}
@@ -0,0 +1,88 @@
+#ifndef FRAME_TOKENIZER_H
+#define FRAME_TOKENIZER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "../tag_matcher/tag_matcher.h"
+
+#define PARENT_TAG_WINDOW        (uint16_t) 7      //the parent tag must be opened within the first 7 bytes of a frame
+#define FRAME_MAX_ARGS           (uint8_t) 16      //capacity of the argument table of a frame
+#define FRAME_MAX_COMMANDS       (uint8_t) 8       //capacity of the command table of a frame
+
+/**
+ * @brief Result of feeding one byte into the tokenizer.
+ */
+typedef enum
+{
+    TOKENIZER_IN_PROGRESS = 0,  // the frame is not complete yet, keep receiving
+    TOKENIZER_FRAME_COMPLETE,   // the closing </UCL> tag has just been consumed
+    TOKENIZER_BAD_FRAME,        // the frame is malformed and has to be discarded
+    TOKENIZER_COMMAND_COMPLETE  // a </CMD> tag has just been consumed, the frame is still in progress
+} Tokenizer_Status_t;
+
+/**
+ * @brief One <PARAM> or <P name="..."> element of a frame.
+ *
+ * All the offsets are relative to the start of the frame buffer. name_offset is
+ * FRAME_TAG_NOT_FOUND for an element without a name attribute, the argument is then
+ * matched by its position.
+ */
+struct FrameArgument
+{
+    uint16_t name_offset;   /*offset of the value of the name attribute*/
+    uint16_t name_length;   /*length of the value of the name attribute*/
+    uint16_t value_offset;  /*offset of the first byte of the element value*/
+    uint16_t value_length;  /*length of the element value*/
+};
+
+/**
+ * @brief One <CMD> element of a frame and the arguments that belong to it.
+ *
+ * The arguments of a command are the ones received after its </CMD> and before the
+ * next <CMD>; arguments received before the first <CMD> belong to the first command.
+ */
+struct FrameCommand
+{
+    uint16_t name_offset;   /*offset of the first byte of the command name*/
+    uint16_t name_length;   /*length of the command name*/
+    uint8_t first_arg;      /*index of the first argument of the command in the argument table*/
+    uint8_t arg_count;      /*number of arguments of the command*/
+};
+
+/**
+ * @brief Everything the tokenizer records about a frame.
+ *
+ * The command and argument tables have a fixed capacity and live in the frame layout,
+ * so a batch of commands and their arguments are extracted in the same pass as the
+ * tags without any allocation.
+ */
+struct FrameLayout
+{
+    struct FrameTagOffsets tags;                     /*offsets of the first occurrence of every tag*/
+    struct FrameCommand cmds[FRAME_MAX_COMMANDS];    /*commands in the order they were received*/
+    struct FrameArgument args[FRAME_MAX_ARGS];       /*arguments in the order they were received*/
+    uint8_t cmd_count;                               /*number of entries used in cmds*/
+    uint8_t arg_count;                               /*number of entries used in args*/
+    bool cmd_overflow;                               /*true if the frame has more than FRAME_MAX_COMMANDS commands*/
+    bool arg_overflow;                               /*true if the frame has more than FRAME_MAX_ARGS arguments*/
+};
+
+/**
+ * @brief State of the incremental frame tokenizer.
+ */
+struct FrameTokenizer
+{
+    struct TagMatcher matcher;  /*matcher recognising the tags of the frame*/
+    struct FrameLayout layout;  /*layout recorded so far*/
+    uint8_t open_arg_tag;       /*FrameTag_t of the argument element being received, NO_OF_FRAME_TAGS if none*/
+    bool cmd_open;              /*true while a <CMD> element is being received*/
+    uint8_t leading_args;       /*number of arguments received before the first <CMD>*/
+};
+
+/*************function prototypes**********************/
+void frame_tokenizer_reset(struct FrameTokenizer *tokenizer);
+void frame_layout_reset(struct FrameLayout *layout);
+Tokenizer_Status_t frame_tokenizer_feed(struct FrameTokenizer *tokenizer, char received_char, uint16_t offset);
+
+#endif // FRAME_TOKENIZER_H
@@ -46,89 +46,268 @@
  * In summary, this memory pool is tailored to the specific needs of embedded 
  * systems, offering predictable, efficient, and reliable memory management, 
  * which is crucial for maintaining system stability and performance.
+ *
+ * The pool can be used from interrupt handlers and from the main loop at the same
+ * time. The search for free blocks runs with interrupts enabled, on the bitmap as it
+ * is; only claiming the blocks found is a critical section. It checks that the blocks
+ * are still free and marks them in one go, touching at most two words of the bitmap
+ * per 32 blocks, so interrupts are masked for a few instructions no matter how full
+ * the pool is. An interrupt that took a block in between makes the claim fail and the
+ * search goes on.
+ *
+ * Single blocks do not search at all. The free blocks are also kept in a doubly linked
+ * list of block indices, so MemoryPool_Allocate() takes the first block of the list and
+ * MemoryPool_Free() puts the block back in front of it, in the same few instructions
+ * however full the pool is. The links live next to the bitmap rather than in the free
+ * blocks, so a write through a dangling pointer can not break the list. Runs of pages
+ * are still found in the bitmap; claiming or freeing a run takes its blocks out of the
+ * list or puts them back, one link update per page.
  */
 
 #include "memory_utility.h"
-#include "../UART_command_line/UART_Command_Line.h"
+#include "../../HAL/HAL-SYSTEM/inc/stm32f10x.h"
 #include <stdlib.h>
 
 // Global memory pool instance
 static MemoryPool memPool;
 
-//buffers for receiving and processing incoming XML data via UART
-char* g_uart_xml_raw_buffer = NULL;  //temporary buffer for receiving raw UART data
-char* g_uart_xml_main_buffer = NULL; // main buffer for processed XML data
+/**
+ * @brief Checks whether a block is allocated.
+ * @param block_index Index of the block.
+ * @return true if the block is allocated.
+ */
+static bool block_is_used(uint32_t block_index)
+{
+    return ((memPool.block_usage[block_index / BLOCK_WORD_BITS] >> (block_index % BLOCK_WORD_BITS)) & 1U) != 0U;
+}
+
+/**
+ * @brief Builds the mask of the blocks of a range that are tracked by one word of the bitmap.
+ * @param first_block Index of the first block of the range.
+ * @param block_count Number of blocks in the range.
+ * @param word Index of the word.
+ * @return Bits of the word that belong to the range.
+ */
+static uint32_t range_word_mask(uint32_t first_block, uint32_t block_count, uint32_t word)
+{
+    const uint32_t word_first = word * BLOCK_WORD_BITS;
+    uint32_t start = 0;
+    uint32_t end = BLOCK_WORD_BITS;
+
+    if (first_block > word_first)
+    {
+        start = first_block - word_first;
+    }
+    if (first_block + block_count - word_first < BLOCK_WORD_BITS)
+    {
+        end = first_block + block_count - word_first;
+    }
+
+    // Bits start..end-1, without shifting a word by its width
+    return ((end == BLOCK_WORD_BITS) ? 0xFFFFFFFFU : ((1U << end) - 1U)) & ~((1U << start) - 1U);
+}
+
+/**
+ * @brief Puts a free block in front of the free list, with interrupts masked.
+ * @param block_index Index of the block.
+ */
+static void free_list_push(uint32_t block_index)
+{
+    memPool.free_next[block_index] = memPool.free_head;
+    memPool.free_prev[block_index] = BLOCK_NONE;
+
+    if (memPool.free_head != BLOCK_NONE)
+    {
+        memPool.free_prev[memPool.free_head] = (uint16_t)block_index;
+    }
+
+    memPool.free_head = (uint16_t)block_index;
+    ++memPool.free_blocks;
+}
+
+/**
+ * @brief Takes a block out of the free list wherever it is, with interrupts masked.
+ * @param block_index Index of the block, it has to be in the list.
+ */
+static void free_list_unlink(uint32_t block_index)
+{
+    const uint16_t next = memPool.free_next[block_index];
+    const uint16_t prev = memPool.free_prev[block_index];
+
+    if (prev != BLOCK_NONE)
+    {
+        memPool.free_next[prev] = next;
+    }
+    else
+    {
+        memPool.free_head = next;
+    }
+
+    if (next != BLOCK_NONE)
+    {
+        memPool.free_prev[next] = prev;
+    }
+
+    --memPool.free_blocks;
+}
+
+/**
+ * @brief Marks a range of blocks as allocated if none of them has been taken meanwhile.
+ *
+ * Runs with interrupts masked; an interrupt handler can not take a block between the
+ * check and the marking. The blocks claimed are taken out of the free list.
+ *
+ * @param first_block Index of the first block of the range.
+ * @param block_count Number of blocks in the range.
+ * @return true if the range has been claimed.
+ */
+static bool claim_blocks(uint32_t first_block, uint32_t block_count)
+{
+    const uint32_t first_word = first_block / BLOCK_WORD_BITS;
+    const uint32_t last_word = (first_block + block_count - 1U) / BLOCK_WORD_BITS;
+    const uint32_t primask = __get_PRIMASK();   // Keep the caller's mask, it may be an interrupt handler
+    bool claimed = true;
+    uint32_t word = 0;
+    uint32_t block = 0;
+
+    __disable_irq();
+
+    for (word = first_word; word <= last_word; ++word)
+    {
+        if (memPool.block_usage[word] & range_word_mask(first_block, block_count, word))
+        {
+            claimed = false;
+            break;
+        }
+    }
+
+    if (claimed)
+    {
+        for (word = first_word; word <= last_word; ++word)
+        {
+            memPool.block_usage[word] |= range_word_mask(first_block, block_count, word);
+        }
+
+        for (block = first_block; block < first_block + block_count; ++block)
+        {
+            free_list_unlink(block);
+        }
+    }
+
+    __set_PRIMASK(primask);
+
+    return claimed;
+}
+
+/**
+ * @brief Marks a range of blocks as free and puts them in front of the free list.
+ *
+ * Runs with interrupts masked, so a block another context claims in the same word of
+ * the bitmap is not lost and the list is never seen half updated. A block that is
+ * already free is left alone, so freeing it twice does not put it in the list twice.
+ *
+ * @param first_block Index of the first block of the range.
+ * @param block_count Number of blocks in the range.
+ */
+static void release_blocks(uint32_t first_block, uint32_t block_count)
+{
+    const uint32_t primask = __get_PRIMASK();
+    uint32_t block = 0;
+
+    __disable_irq();
+
+    for (block = first_block; block < first_block + block_count; ++block)
+    {
+        if (block_is_used(block))
+        {
+            memPool.block_usage[block / BLOCK_WORD_BITS] &= ~(1U << (block % BLOCK_WORD_BITS));
+            free_list_push(block);
+        }
+    }
+
+    __set_PRIMASK(primask);
+}
 
-struct XMLDataExtractionResult *g_extracted_data;
 /**
  * @brief Initializes the memory pool by clearing the memory and marking all blocks as free.
+ *
+ * Must be called before any interrupt handler uses the pool.
  */
 void MemoryPool_Init(void) 
 {
+    uint32_t word = 0;
+    uint32_t block = 0;
+
     // Clear all bytes in the memory pool to zero
     memset(memPool.pool, 0, MEMORY_POOL_SIZE);
 
-    // Set all blocks in the block usage array to false (free)
-    memset(memPool.block_usage, 0, BLOCK_COUNT);
+    // Mark all blocks as free
+    for (word = 0; word < BLOCK_WORDS; ++word)
+    {
+        memPool.block_usage[word] = 0;
+    }
+
+    // Link the free blocks in the order of their addresses
+    for (block = 0; block < BLOCK_COUNT; ++block)
+    {
+        memPool.free_next[block] = (block + 1U < BLOCK_COUNT) ? (uint16_t)(block + 1U) : BLOCK_NONE;
+        memPool.free_prev[block] = (block > 0U) ? (uint16_t)(block - 1U) : BLOCK_NONE;
+    }
+
+    memPool.free_head = (BLOCK_COUNT > 0U) ? 0U : BLOCK_NONE;
+    memPool.free_blocks = BLOCK_COUNT;
 }
 
 /**
  * @brief Allocates a single block of memory from the pool.
+ *
+ * Takes the first block of the free list, in constant time however full the pool is.
+ * Safe to call from interrupt handlers and from the main loop at the same time.
+ *
  * @return Pointer to the allocated block, or NULL if no free block is available.
  */
 void* MemoryPool_Allocate(void) 
 {
-    void* allocated_block = NULL; // Pointer to the block to return
+    void* allocated_block = NULL;
+    const uint32_t primask = __get_PRIMASK();   // Keep the caller's mask, it may be an interrupt handler
+    uint32_t block = 0;
 
-    // Iterate through the block usage array to find a free block
-    for (uint32_t block_index = 0; block_index < BLOCK_COUNT; block_index++) 
+    __disable_irq();
+
+    block = memPool.free_head;
+
+    if (block != BLOCK_NONE)
     {
-        if (!memPool.block_usage[block_index]) 
-        { // Check if the block is free
-            memPool.block_usage[block_index] = true; // Mark the block as allocated
-            allocated_block = &memPool.pool[block_index * BLOCK_SIZE]; // Get the address of the block
-            break; // Stop searching after finding a free block
-        }
+        free_list_unlink(block);
+        memPool.block_usage[block / BLOCK_WORD_BITS] |= 1U << (block % BLOCK_WORD_BITS);
+        allocated_block = &memPool.pool[block * BLOCK_SIZE];
     }
 
-    return allocated_block; // Return the allocated block pointer or NULL
+    __set_PRIMASK(primask);
+
+    return allocated_block;
 }
 
 /**
  * @brief Frees a single block of memory back to the pool.
- * @param block_pointer Pointer to the block to free.
- */
-/**
- * @brief Frees a single block of memory back to the pool.
+ *
+ * Puts the block in front of the free list, in constant time.
+ *
  * @param block_pointer Pointer to the block to free.
  */
 void MemoryPool_Free(void* block_pointer) 
 {
-    if (block_pointer != NULL) 
-    { 
-        // Calculate the block offset
-        int offset = (int)((uint8_t*)block_pointer - memPool.pool);
-
-        // Ensure the offset is non-negative
-        if (offset >= 0) 
-        {
-            // Calculate the block index from the pointer
-            uint32_t block_index = (uint32_t)offset / BLOCK_SIZE;
-
-            // If the index is valid, mark the block as free
-            if (block_index < BLOCK_COUNT) 
-            {
-                memPool.block_usage[block_index] = false;
-
-                block_pointer = NULL;
-            }
-        }
-    }
+    MemoryPool_FreePages(block_pointer, 1);
 }
 
 
 /**
  * @brief Allocates multiple contiguous blocks (pages) of memory from the pool.
+ *
+ * Searches the bitmap for the first run of free blocks, so it takes longer the fuller
+ * the pool is; single blocks are allocated with MemoryPool_Allocate() instead.
+ * Safe to call from interrupt handlers and from the main loop at the same time.
+ *
  * @param page_count Number of contiguous blocks to allocate.
  * @return Pointer to the first block of the allocated pages, or NULL if allocation fails.
  */
@@ -142,7 +321,7 @@ void* MemoryPool_AllocatePages(uint32_t page_count)
     // Ensure the requested page count is valid
     if (page_count > 0 && page_count <= BLOCK_COUNT) 
     {
-        // Search the block usage array for a range of free blocks
+        // Search the block usage bitmap for a range of free blocks, with interrupts enabled
         for (start_index = 0; start_index <= BLOCK_COUNT - page_count; start_index++) 
         {
             bool can_allocate_pages = true; // Assume the blocks can be allocated
@@ -150,19 +329,16 @@ void* MemoryPool_AllocatePages(uint32_t page_count)
             // Check if the required number of contiguous blocks are free
             for (offset = 0; offset < page_count; ++offset) 
             {
-                if (memPool.block_usage[start_index + offset]) 
+                if (block_is_used(start_index + offset)) 
                 { // If a block is already allocated
                     can_allocate_pages = false; // Allocation is not possible
                     break; // Stop checking further
                 }
             }
 
-            if (can_allocate_pages) 
-            { // If the range is free, allocate the blocks
-                for (offset = 0; offset < page_count; ++offset) 
-                {
-                    memPool.block_usage[start_index + offset] = true; // Mark the blocks as allocated
-                }
+            // An interrupt may have taken one of the blocks since they were checked, then search on
+            if (can_allocate_pages && claim_blocks(start_index, page_count)) 
+            {
                 allocated_pages = &memPool.pool[start_index * BLOCK_SIZE]; // Get the address of the first block
                 break; // Allocation complete, exit loop
             }
@@ -174,6 +350,9 @@ void* MemoryPool_AllocatePages(uint32_t page_count)
 
 /**
  * @brief Frees multiple contiguous blocks (pages) of memory back to the pool.
+ *
+ * Safe to call from interrupt handlers and from the main loop at the same time.
+ *
  * @param block_pointer Pointer to the first block of the pages to free.
  * @param page_count Number of contiguous blocks to free.
  */
@@ -195,10 +374,7 @@ void MemoryPool_FreePages(void* block_pointer, uint32_t page_count)
             if (start_block_index + page_count <= BLOCK_COUNT) 
             {
                 // Mark all blocks in the range as free
-                for (uint32_t i = 0; i < page_count; i++) 
-                {
-                    memPool.block_usage[start_block_index + i] = false;
-                }
+                release_blocks(start_block_index, page_count);
 
                 block_pointer = NULL; // Avoid dangling pointer after freeing memory
             }
@@ -208,22 +384,10 @@ void MemoryPool_FreePages(void* block_pointer, uint32_t page_count)
 
 
 /**
- * @brief Calculates and returns the number of free blocks in the memory pool.
- * @return Number of free blocks available in the pool.
+ * @brief Returns the number of free blocks in the memory pool.
+ * @return Number of free blocks available in the pool, the length of the free list.
  */
 uint32_t MemoryPool_GetFreeBlocks(void) 
 {
-    uint32_t free_block_count = 0; // Counter for free blocks
-
-    // Iterate through the block usage array
-    for (uint32_t block_index = 0; block_index < BLOCK_COUNT; block_index++) 
-    {
-        if (!memPool.block_usage[block_index]) 
-        { // If the block is free
-            free_block_count++; // Increment the counter
-        }
-    }
-
-    return free_block_count; // Return the total number of free blocks
+    return memPool.free_blocks;
 }
-
@@ -4,25 +4,26 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <string.h>
-#include <stdio.h>
 
 // Configuration
 #define MEMORY_POOL_SIZE    (uint32_t) 1024  // Total memory pool size in bytes
 #define BLOCK_SIZE          (uint32_t) 32    // Size of each block in bytes
 #define BLOCK_COUNT         (uint32_t) (MEMORY_POOL_SIZE / BLOCK_SIZE) // Total number of blocks in the memory pool
+#define BLOCK_WORD_BITS     (uint32_t) 32    // Blocks tracked by one word of the usage bitmap
+#define BLOCK_WORDS         (uint32_t) ((BLOCK_COUNT + BLOCK_WORD_BITS - 1U) / BLOCK_WORD_BITS) // Words of the usage bitmap
+#define BLOCK_NONE          (uint16_t) 0xFFFF // End of the free list, BLOCK_COUNT must stay below it
 
 // memory pool structure to manage the pool and track block usage
 typedef struct 
 {
     uint8_t pool[MEMORY_POOL_SIZE]; // Array to represent the memory pool
-    bool block_usage[BLOCK_COUNT]; // Boolean array to track which blocks are allocated
+    volatile uint32_t block_usage[BLOCK_WORDS]; // Bitmap of the allocated blocks, bit n of word w is block w * 32 + n
+    uint16_t free_next[BLOCK_COUNT]; // Next block of the free list, BLOCK_NONE after the last one
+    uint16_t free_prev[BLOCK_COUNT]; // Previous block of the free list, BLOCK_NONE before the first one
+    uint16_t free_head;              // First block of the free list, BLOCK_NONE if every block is allocated
+    uint32_t free_blocks;            // Number of blocks in the free list
 } MemoryPool;
 
-//buffers for receiving and processing incoming XML data via UART
-extern char* g_uart_xml_raw_buffer;  //temporary buffer for receiving raw UART data
-extern char* g_uart_xml_main_buffer; // main buffer for processed XML data
-extern struct XMLDataExtractionResult *g_extracted_data;
-
 /*************function prototypes**********************/
 void MemoryPool_Init(void);
 void* MemoryPool_Allocate(void);
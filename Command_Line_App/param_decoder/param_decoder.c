@@ -0,0 +1,457 @@
+/**
+ * @file param_decoder.c
+ *
+ * @brief Decoding and validation of typed command parameters.
+ *
+ * Every parameter in the command schema declares a type and a range. The parser
+ * decodes the received text with decode_param() while it extracts the command, so a
+ * malformed or out of range value is rejected with a specific status before any
+ * callback runs, and the callbacks receive native values instead of strings.
+ *
+ * The decoder works directly on slices of the received frame: the text does not need
+ * to be null-terminated and nothing is copied. No stdlib conversion (strtol, sscanf)
+ * is used, so overflow is detected exactly and no locale or errno is involved.
+ *
+ * Binary frames carry the values already encoded as little-endian integers, they are
+ * checked against the same spec with decode_binary_param().
+ */
+
+#include "param_decoder.h"
+
+#define MAX_HEX_DIGITS      (uint16_t) 8   //a HEX parameter holds at most 32 bits
+#define MAX_U32_DIV_10      (uint32_t) (UINT32_MAX / 10U)
+
+/*words accepted for BOOL parameters, the index of a word modulo 2 is its value*/
+static const char *const g_bool_words[] =
+{
+    "0", "1",
+    "false", "true",
+    "off", "on"
+};
+
+#define BOOL_WORD_COUNT     (uint8_t) (sizeof(g_bool_words) / sizeof(g_bool_words[0]))
+
+/**
+ * @brief Compares a slice with a null-terminated word, ignoring the case of ASCII letters.
+ */
+static bool slice_equals_word(const char *text, uint16_t length, const char *word, bool ignore_case)
+{
+    uint16_t index = 0;
+    char received = 0;
+    char expected = 0;
+
+    for (index = 0; index < length; ++index)
+    {
+        received = text[index];
+        expected = word[index];
+
+        //the word is shorter than the slice
+        if (expected == '\0')
+        {
+            return false;
+        }
+
+        if (ignore_case)
+        {
+            if (received >= 'A' && received <= 'Z')
+            {
+                received = (char)(received - 'A' + 'a');
+            }
+            if (expected >= 'A' && expected <= 'Z')
+            {
+                expected = (char)(expected - 'A' + 'a');
+            }
+        }
+
+        if (received != expected)
+        {
+            return false;
+        }
+    }
+
+    //the word must not be longer than the slice
+    return (word[length] == '\0');
+}
+
+/**
+ * @brief Adds a decimal digit to an unsigned magnitude, detecting overflow.
+ *
+ * @return true if the digit was added, false on overflow.
+ */
+static bool append_decimal_digit(uint32_t *magnitude, char digit)
+{
+    uint32_t digit_value = (uint32_t)(digit - '0');
+
+    if (*magnitude > MAX_U32_DIV_10 || (*magnitude * 10U) > (UINT32_MAX - digit_value))
+    {
+        return false;
+    }
+
+    *magnitude = (*magnitude * 10U) + digit_value;
+    return true;
+}
+
+/**
+ * @brief Decodes an optionally signed decimal number with up to fraction_digits fraction digits.
+ *
+ * The result is scaled by 10^fraction_digits. Values that do not fit in an int32_t are
+ * reported as out of range, text that is not a number as a bad format.
+ */
+static Param_Status_t decode_decimal(const char *text, uint16_t length, uint8_t fraction_digits,
+                                     bool allow_sign, int32_t *value)
+{
+    Param_Status_t outcome = PARAM_OK;
+    uint16_t index = 0;
+    uint32_t magnitude = 0;
+    uint8_t  fraction_read = 0;
+    bool negative = false;
+    bool in_fraction = false;
+    bool digit_found = false;
+    bool overflow = false;
+
+    //optional sign
+    if (length > 0 && (text[0] == '-' || text[0] == '+'))
+    {
+        if (!allow_sign)
+        {
+            return PARAM_BAD_FORMAT;
+        }
+        negative = (text[0] == '-');
+        index = 1;
+    }
+
+    for (; index < length; ++index)
+    {
+        if (text[index] >= '0' && text[index] <= '9')
+        {
+            digit_found = true;
+
+            if (in_fraction)
+            {
+                //more fraction digits than the type can hold
+                if (fraction_read >= fraction_digits)
+                {
+                    return PARAM_BAD_FORMAT;
+                }
+                ++fraction_read;
+            }
+
+            if (!overflow && !append_decimal_digit(&magnitude, text[index]))
+            {
+                overflow = true;
+            }
+        }
+        else if (text[index] == '.' && fraction_digits > 0 && !in_fraction)
+        {
+            in_fraction = true;
+        }
+        else
+        {
+            return PARAM_BAD_FORMAT;
+        }
+    }
+
+    //"", "-" and "." are not numbers, neither is a trailing '.'
+    if (!digit_found || (in_fraction && fraction_read == 0))
+    {
+        return PARAM_BAD_FORMAT;
+    }
+
+    //scale to the declared number of fraction digits
+    for (; fraction_read < fraction_digits && !overflow; ++fraction_read)
+    {
+        overflow = !append_decimal_digit(&magnitude, '0');
+    }
+
+    //the magnitude of an int32_t is at most 2^31, and only for negative numbers
+    if (overflow || magnitude > ((uint32_t)INT32_MAX + (negative ? 1U : 0U)))
+    {
+        outcome = PARAM_OUT_OF_RANGE;
+    }
+    else if (negative)
+    {
+        *value = (int32_t)(0U - magnitude);
+    }
+    else
+    {
+        *value = (int32_t)magnitude;
+    }
+
+    return outcome;
+}
+
+/**
+ * @brief Decodes an unsigned hexadecimal number with an optional 0x prefix.
+ */
+static Param_Status_t decode_hex(const char *text, uint16_t length, uint32_t *value)
+{
+    uint16_t index = 0;
+    uint32_t result = 0;
+    char digit = 0;
+
+    //optional prefix
+    if (length > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X'))
+    {
+        index = 2;
+    }
+
+    if (index == length)
+    {
+        return PARAM_BAD_FORMAT;
+    }
+
+    //more digits than 32 bits can hold
+    if ((length - index) > MAX_HEX_DIGITS)
+    {
+        return PARAM_OUT_OF_RANGE;
+    }
+
+    for (; index < length; ++index)
+    {
+        digit = text[index];
+
+        if (digit >= '0' && digit <= '9')
+        {
+            result = (result << 4) | (uint32_t)(digit - '0');
+        }
+        else if (digit >= 'a' && digit <= 'f')
+        {
+            result = (result << 4) | (uint32_t)(digit - 'a' + 10);
+        }
+        else if (digit >= 'A' && digit <= 'F')
+        {
+            result = (result << 4) | (uint32_t)(digit - 'A' + 10);
+        }
+        else
+        {
+            return PARAM_BAD_FORMAT;
+        }
+    }
+
+    *value = result;
+    return PARAM_OK;
+}
+
+/**
+ * @brief Decodes and validates the text of a parameter according to its spec.
+ *
+ * @param spec Pointer to the spec of the parameter.
+ * @param text Pointer to the text of the parameter, it does not need to be null-terminated.
+ * @param length Length of the text in bytes.
+ * @param value Pointer to the union receiving the decoded value.
+ *
+ * @retval PARAM_OK if the value is valid and within its range.
+ * @retval PARAM_BAD_FORMAT if the text is not a value of the declared type.
+ * @retval PARAM_OUT_OF_RANGE if the value is outside of the declared range.
+ */
+Param_Status_t decode_param(const struct ParamSpec *spec, const char *text, uint16_t length, union ParamData *value)
+{
+    Param_Status_t outcome = PARAM_OK;
+    int32_t  signed_value = 0;
+    uint32_t unsigned_value = 0;
+    uint8_t  index = 0;
+
+    //validate input parameters
+    if (!spec || !value || (!text && length > 0))
+    {
+        return PARAM_BAD_FORMAT;
+    }
+
+    value->u32 = 0;
+
+    switch (spec->type)
+    {
+        case PARAM_TYPE_STRING:
+            //the callback reads the raw slice
+            break;
+
+        case PARAM_TYPE_U8:
+        case PARAM_TYPE_U16:
+        case PARAM_TYPE_I32:
+        case PARAM_TYPE_FIXED:
+            outcome = decode_decimal(text, length,
+                                     (spec->type == PARAM_TYPE_FIXED) ? spec->fraction_digits : 0,
+                                     (spec->type == PARAM_TYPE_I32 || spec->type == PARAM_TYPE_FIXED),
+                                     &signed_value);
+
+            //the natural range of the type is checked along with the declared one
+            if (outcome == PARAM_OK &&
+                ((spec->type == PARAM_TYPE_U8 && signed_value > (int32_t)UINT8_MAX) ||
+                 (spec->type == PARAM_TYPE_U16 && signed_value > (int32_t)UINT16_MAX) ||
+                 signed_value < spec->min || signed_value > spec->max))
+            {
+                outcome = PARAM_OUT_OF_RANGE;
+            }
+
+            if (outcome == PARAM_OK)
+            {
+                value->i32 = signed_value;
+            }
+            break;
+
+        case PARAM_TYPE_HEX:
+            outcome = decode_hex(text, length, &unsigned_value);
+
+            if (outcome == PARAM_OK &&
+                (unsigned_value < (uint32_t)spec->min || unsigned_value > (uint32_t)spec->max))
+            {
+                outcome = PARAM_OUT_OF_RANGE;
+            }
+
+            if (outcome == PARAM_OK)
+            {
+                value->u32 = unsigned_value;
+            }
+            break;
+
+        case PARAM_TYPE_BOOL:
+            outcome = PARAM_BAD_FORMAT;
+
+            for (index = 0; index < BOOL_WORD_COUNT; ++index)
+            {
+                if (slice_equals_word(text, length, g_bool_words[index], true))
+                {
+                    value->flag = ((index % 2U) == 1U);
+                    outcome = PARAM_OK;
+                    break;
+                }
+            }
+            break;
+
+        case PARAM_TYPE_ENUM:
+            outcome = PARAM_BAD_FORMAT;
+
+            for (index = 0; spec->enum_values && index < spec->enum_count; ++index)
+            {
+                if (slice_equals_word(text, length, spec->enum_values[index], false))
+                {
+                    value->u32 = index;
+                    outcome = PARAM_OK;
+                    break;
+                }
+            }
+            break;
+
+        default:
+            outcome = PARAM_BAD_FORMAT;
+            break;
+    }
+
+    return outcome;
+}
+
+/**
+ * @brief Decodes and validates a little-endian binary value according to its spec.
+ *
+ * Numeric, BOOL and ENUM values are sent in 1 to 4 bytes; I32 and FIXED values are
+ * sign-extended from their most significant byte. STRING values are not decoded.
+ *
+ * @param spec Pointer to the spec of the parameter.
+ * @param data Pointer to the encoded value.
+ * @param length Length of the encoded value in bytes.
+ * @param value Pointer to the union receiving the decoded value.
+ *
+ * @retval PARAM_OK if the value is valid and within its range.
+ * @retval PARAM_BAD_FORMAT if the length does not fit the declared type.
+ * @retval PARAM_OUT_OF_RANGE if the value is outside of the declared range.
+ */
+Param_Status_t decode_binary_param(const struct ParamSpec *spec, const uint8_t *data, uint16_t length,
+                                   union ParamData *value)
+{
+    Param_Status_t outcome = PARAM_OK;
+    uint32_t raw = 0;
+    uint16_t index = 0;
+    bool is_signed = false;
+
+    //validate input parameters
+    if (!spec || !value || (!data && length > 0))
+    {
+        return PARAM_BAD_FORMAT;
+    }
+
+    value->u32 = 0;
+
+    //the callback reads the raw slice
+    if (spec->type == PARAM_TYPE_STRING)
+    {
+        return PARAM_OK;
+    }
+
+    if (length == 0 || length > sizeof(raw))
+    {
+        return PARAM_BAD_FORMAT;
+    }
+
+    for (index = length; index > 0; --index)
+    {
+        raw = (raw << 8) | data[index - 1];
+    }
+
+    is_signed = (spec->type == PARAM_TYPE_I32 || spec->type == PARAM_TYPE_FIXED);
+
+    //sign-extend values shorter than 32 bits
+    if (is_signed && length < sizeof(raw) && (data[length - 1] & 0x80U))
+    {
+        raw |= ~((1UL << (8U * length)) - 1U);
+    }
+
+    switch (spec->type)
+    {
+        case PARAM_TYPE_U8:
+        case PARAM_TYPE_U16:
+        case PARAM_TYPE_I32:
+        case PARAM_TYPE_FIXED:
+            //unsigned values above INT32_MAX are out of the range of every type
+            if ((!is_signed && raw > (uint32_t)INT32_MAX) ||
+                (int32_t)raw < spec->min || (int32_t)raw > spec->max ||
+                (spec->type == PARAM_TYPE_U8 && raw > UINT8_MAX) ||
+                (spec->type == PARAM_TYPE_U16 && raw > UINT16_MAX))
+            {
+                outcome = PARAM_OUT_OF_RANGE;
+            }
+            else
+            {
+                value->i32 = (int32_t)raw;
+            }
+            break;
+
+        case PARAM_TYPE_HEX:
+            if (raw < (uint32_t)spec->min || raw > (uint32_t)spec->max)
+            {
+                outcome = PARAM_OUT_OF_RANGE;
+            }
+            else
+            {
+                value->u32 = raw;
+            }
+            break;
+
+        case PARAM_TYPE_BOOL:
+            if (raw > 1U)
+            {
+                outcome = PARAM_OUT_OF_RANGE;
+            }
+            else
+            {
+                value->flag = (raw == 1U);
+            }
+            break;
+
+        case PARAM_TYPE_ENUM:
+            if (raw >= spec->enum_count)
+            {
+                outcome = PARAM_OUT_OF_RANGE;
+            }
+            else
+            {
+                value->u32 = raw;
+            }
+            break;
+
+        default:
+            outcome = PARAM_BAD_FORMAT;
+            break;
+    }
+
+    return outcome;
+}
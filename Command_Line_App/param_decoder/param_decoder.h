@@ -0,0 +1,68 @@
+#ifndef PARAM_DECODER_H
+#define PARAM_DECODER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+/**
+ * @brief Types a command parameter can be declared with in the command schema.
+ */
+typedef enum
+{
+    PARAM_TYPE_STRING = 0,  // raw text, not decoded
+    PARAM_TYPE_U8,          // unsigned decimal, 0..255
+    PARAM_TYPE_U16,         // unsigned decimal, 0..65535
+    PARAM_TYPE_I32,         // signed decimal
+    PARAM_TYPE_FIXED,       // signed decimal with a fixed number of fraction digits, stored scaled
+    PARAM_TYPE_HEX,         // unsigned hexadecimal with an optional 0x prefix, up to 32 bits
+    PARAM_TYPE_BOOL,        // 0/1, true/false or on/off
+    PARAM_TYPE_ENUM,        // one of a list of names, stored as the index of the name
+    NO_OF_PARAM_TYPES
+} ParamType_t;
+
+/**
+ * @brief Outcome of decoding a parameter.
+ */
+typedef enum
+{
+    PARAM_OK = 0,           // the parameter was decoded and is within its range
+    PARAM_BAD_FORMAT,       // the text is not a valid value of the declared type
+    PARAM_OUT_OF_RANGE      // the value is valid but outside of the declared range
+} Param_Status_t;
+
+/**
+* @brief ParamSpec describes one parameter a command accepts
+*
+* min and max bound the decoded value. FIXED values are compared after scaling by
+* 10^fraction_digits, HEX values are compared as unsigned numbers and ENUM values
+* are the index in enum_values. STRING and BOOL parameters ignore the range.
+*/
+struct ParamSpec
+{
+    const char *name;               /*name of the parameter*/
+    bool required;                  /*true if the command can not run without the parameter*/
+    uint8_t type;                   /*ParamType_t of the parameter*/
+    uint8_t fraction_digits;        /*number of fraction digits of a FIXED parameter*/
+    int32_t min;                    /*smallest accepted value*/
+    int32_t max;                    /*largest accepted value*/
+    const char *const *enum_values; /*names of an ENUM parameter, NULL for other types*/
+    uint8_t enum_count;             /*number of entries in enum_values*/
+};
+
+/**
+ * @brief Decoded value of a parameter, interpreted according to its ParamType_t.
+ */
+union ParamData
+{
+    uint32_t u32;   /*U8, U16, HEX and ENUM values*/
+    int32_t  i32;   /*I32 values and FIXED values scaled by 10^fraction_digits*/
+    bool     flag;  /*BOOL values*/
+};
+
+/*************function prototypes**********************/
+Param_Status_t decode_param(const struct ParamSpec *spec, const char *text, uint16_t length, union ParamData *value);
+Param_Status_t decode_binary_param(const struct ParamSpec *spec, const uint8_t *data, uint16_t length,
+                                   union ParamData *value);
+
+#endif // PARAM_DECODER_H
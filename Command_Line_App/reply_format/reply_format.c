@@ -0,0 +1,188 @@
+/**
+ * @file reply_format.c
+ *
+ * @brief Formatting of numbers for the replies of the command line.
+ *
+ * The counterpart of the parameter decoder: integers, hexadecimal and fixed-point
+ * values are turned into text without snprintf, which would pull the whole printf
+ * engine of the C library into the firmware and parse a format string on every call.
+ *
+ * Every function writes its text from the first character onwards and returns its
+ * length, nothing is null-terminated and nothing is allocated. The length of a number
+ * is known before its first digit is written, so the digits go straight to where they
+ * are sent from, e.g. room reserved in the transmit queue of a USART, which needs room
+ * for the largest text of the function (REPLY_FORMAT_..._SIZE) and keeps only what was
+ * written.
+ */
+
+#include "reply_format.h"
+
+#define HEX_DIGITS_MAX     (uint8_t) 8    //nibbles of 32 bits
+
+//powers of ten a uint32_t holds, the number of decimal digits of a value is found by comparing with them
+static const uint32_t g_powers_of_ten[REPLY_FORMAT_U32_SIZE] =
+{
+    1U, 10U, 100U, 1000U, 10000U, 100000U, 1000000U, 10000000U, 100000000U, 1000000000U
+};
+
+static const char g_hex_digits[] = "0123456789abcdef";
+
+/**
+ * @brief Counts the decimal digits of a value.
+ */
+static uint8_t decimal_digits(uint32_t value)
+{
+    uint8_t digits = 1;
+
+    while (digits < REPLY_FORMAT_U32_SIZE && value >= g_powers_of_ten[digits])
+    {
+        ++digits;
+    }
+
+    return digits;
+}
+
+/**
+ * @brief Writes a value as a given number of decimal digits, with leading zeros if it has fewer.
+ */
+static void write_digits(char *text, uint32_t value, uint8_t digits)
+{
+    //the digits are produced from the last to the first
+    while (digits > 0)
+    {
+        --digits;
+        text[digits] = (char)('0' + (value % 10U));
+        value /= 10U;
+    }
+}
+
+/**
+ * @brief Formats an unsigned integer in decimal.
+ *
+ * @param text Where the text goes, room for REPLY_FORMAT_U32_SIZE characters.
+ * @param value The value.
+ *
+ * @return uint8_t Number of characters written, 0 if text is NULL.
+ */
+uint8_t reply_format_u32(char *text, uint32_t value)
+{
+    uint8_t length = 0;
+
+    if (text)
+    {
+        length = decimal_digits(value);
+        write_digits(text, value, length);
+    }
+
+    return length;
+}
+
+/**
+ * @brief Formats a signed integer in decimal, with a minus sign if it is negative.
+ *
+ * @param text Where the text goes, room for REPLY_FORMAT_I32_SIZE characters.
+ * @param value The value.
+ *
+ * @return uint8_t Number of characters written, 0 if text is NULL.
+ */
+uint8_t reply_format_i32(char *text, int32_t value)
+{
+    uint8_t length = 0;
+
+    if (text)
+    {
+        if (value < 0)
+        {
+            text[length++] = '-';
+        }
+
+        //the magnitude is taken unsigned, INT32_MIN has no positive counterpart
+        length = (uint8_t)(length + reply_format_u32(&text[length],
+                                                     (value < 0) ? 0U - (uint32_t)value : (uint32_t)value));
+    }
+
+    return length;
+}
+
+/**
+ * @brief Formats an unsigned integer in hexadecimal with a 0x prefix and lower case digits.
+ *
+ * @param text Where the text goes, room for REPLY_FORMAT_HEX_SIZE characters.
+ * @param value The value.
+ * @param min_digits Digits written at least, the value is padded with leading zeros; 0..8.
+ *
+ * @return uint8_t Number of characters written, 0 if text is NULL.
+ */
+uint8_t reply_format_hex(char *text, uint32_t value, uint8_t min_digits)
+{
+    uint8_t digits = 1;
+    uint8_t index = 0;
+
+    if (!text)
+    {
+        return 0;
+    }
+
+    while (digits < HEX_DIGITS_MAX && (value >> (4U * digits)) != 0)
+    {
+        ++digits;
+    }
+
+    if (digits < min_digits)
+    {
+        digits = (min_digits < HEX_DIGITS_MAX) ? min_digits : HEX_DIGITS_MAX;
+    }
+
+    text[0] = '0';
+    text[1] = 'x';
+
+    for (index = 0; index < digits; ++index)
+    {
+        text[1U + digits - index] = g_hex_digits[(value >> (4U * index)) & 0xFU];
+    }
+
+    return (uint8_t)(2U + digits);
+}
+
+/**
+ * @brief Formats a fixed-point value, an integer scaled by 10^fraction_digits.
+ *
+ * The value is written with all of its fraction digits, 1234 with 2 fraction digits
+ * as "12.34" and -5 with 3 as "-0.005". This is how PARAM_TYPE_FIXED parameters are
+ * stored, so a decoded value is sent back in the form it was received in.
+ *
+ * @param text Where the text goes, room for REPLY_FORMAT_FIXED_SIZE characters.
+ * @param value The scaled value.
+ * @param fraction_digits Number of fraction digits, 0 formats an integer; at most REPLY_FORMAT_MAX_FRACTION.
+ *
+ * @return uint8_t Number of characters written, 0 if text is NULL or fraction_digits is too large.
+ */
+uint8_t reply_format_fixed(char *text, int32_t value, uint8_t fraction_digits)
+{
+    uint32_t magnitude = 0;
+    uint8_t length = 0;
+
+    if (!text || fraction_digits > REPLY_FORMAT_MAX_FRACTION)
+    {
+        return 0;
+    }
+
+    if (fraction_digits == 0)
+    {
+        return reply_format_i32(text, value);
+    }
+
+    if (value < 0)
+    {
+        text[length++] = '-';
+    }
+
+    magnitude = (value < 0) ? 0U - (uint32_t)value : (uint32_t)value;
+
+    length = (uint8_t)(length + reply_format_u32(&text[length], magnitude / g_powers_of_ten[fraction_digits]));
+    text[length++] = '.';
+    write_digits(&text[length], magnitude % g_powers_of_ten[fraction_digits], fraction_digits);
+
+    return (uint8_t)(length + fraction_digits);
+}
+
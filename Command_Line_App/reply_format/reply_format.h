@@ -0,0 +1,20 @@
+#ifndef REPLY_FORMAT_H
+#define REPLY_FORMAT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define REPLY_FORMAT_U32_SIZE      (uint8_t) 10   //"4294967295"
+#define REPLY_FORMAT_I32_SIZE      (uint8_t) 11   //"-2147483648"
+#define REPLY_FORMAT_HEX_SIZE      (uint8_t) 10   //"0x" and 8 digits
+#define REPLY_FORMAT_FIXED_SIZE    (uint8_t) 12   //"-2.147483648", the sign, 10 digits and the point
+#define REPLY_FORMAT_MAX_FRACTION  (uint8_t) 9    //fraction digits of a fixed-point value, 10^9 fits 32 bits
+#define REPLY_FORMAT_MAX_SIZE      REPLY_FORMAT_FIXED_SIZE  //room that holds any formatted number
+
+/*************function prototypes**********************/
+uint8_t reply_format_u32(char *text, uint32_t value);
+uint8_t reply_format_i32(char *text, int32_t value);
+uint8_t reply_format_hex(char *text, uint32_t value, uint8_t min_digits);
+uint8_t reply_format_fixed(char *text, int32_t value, uint8_t fraction_digits);
+
+#endif // REPLY_FORMAT_H
@@ -0,0 +1,116 @@
+/**
+ * @file reply_queue.c
+ *
+ * @brief Queue of the error replies for frames rejected while they are received.
+ *
+ * The receive ISR rejects a frame as soon as it can tell the frame is invalid, but it
+ * can not write the error reply itself: transmitting blocks for a millisecond per byte.
+ * It queues the reply instead and the main loop sends it.
+ *
+ * The indices have acquire/release semantics, as those of the frame ring: a side reads
+ * the other side's index before it touches an entry, and writes its own index only
+ * after it is done with the entry.
+ */
+
+#include "reply_queue.h"
+#include "../../HAL/HAL-SYSTEM/inc/stm32f10x.h"
+
+/**
+ * @brief Queues a reply, called from the receive ISR.
+ *
+ * @param queue Pointer to the queue.
+ * @param reply Pointer to the reply, it is copied into the queue.
+ *
+ * @return true if the reply was queued, false if the queue is full or the input is invalid.
+ */
+bool reply_queue_push(struct ReplyQueue *queue, const struct PendingReply *reply)
+{
+    bool outcome = false;
+    uint8_t head = 0;
+
+    if (queue && reply)
+    {
+        head = queue->head;
+
+        //the queue is full when the head is a whole lap ahead of the tail
+        if ((uint8_t)(head - queue->tail) < REPLY_QUEUE_DEPTH)
+        {
+            //acquire: the main loop is done with the entry before it is written again
+            __DMB();
+            queue->replies[head & (REPLY_QUEUE_DEPTH - 1U)] = *reply;
+
+            //release: the entry is written before the main loop can see it
+            __DMB();
+            queue->head = (uint8_t)(head + 1U);
+            outcome = true;
+        }
+        else
+        {
+            ++queue->dropped;
+        }
+    }
+
+    return outcome;
+}
+
+/**
+ * @brief Looks at the oldest reply without taking it out of the queue, called from the main loop.
+ *
+ * @param queue Pointer to the queue.
+ * @param reply Pointer to the reply to fill in.
+ *
+ * @return true if a reply is queued, false if the queue is empty or the input is invalid.
+ */
+bool reply_queue_peek(const struct ReplyQueue *queue, struct PendingReply *reply)
+{
+    bool outcome = false;
+    uint8_t tail = 0;
+
+    if (queue && reply)
+    {
+        tail = queue->tail;
+
+        if (tail != queue->head)
+        {
+            //acquire: the entry is read only after it has been published
+            __DMB();
+            *reply = queue->replies[tail & (REPLY_QUEUE_DEPTH - 1U)];
+            outcome = true;
+        }
+    }
+
+    return outcome;
+}
+
+/**
+ * @brief Takes the oldest reply out of the queue, called from the main loop.
+ *
+ * @param queue Pointer to the queue.
+ * @param reply Pointer to the reply to fill in.
+ *
+ * @return true if a reply was taken, false if the queue is empty or the input is invalid.
+ */
+bool reply_queue_pop(struct ReplyQueue *queue, struct PendingReply *reply)
+{
+    bool outcome = false;
+    uint8_t tail = 0;
+
+    if (queue && reply)
+    {
+        tail = queue->tail;
+
+        if (tail != queue->head)
+        {
+            //acquire: the entry is read only after it has been published
+            __DMB();
+            *reply = queue->replies[tail & (REPLY_QUEUE_DEPTH - 1U)];
+
+            //release: the entry has been read before the ISR can overwrite it
+            __DMB();
+            queue->tail = (uint8_t)(tail + 1U);
+            outcome = true;
+        }
+    }
+
+    return outcome;
+}
@@ -0,0 +1,42 @@
+#ifndef REPLY_QUEUE_H
+#define REPLY_QUEUE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define REPLY_QUEUE_DEPTH    (uint8_t) 4   //number of pending replies, must be a power of two
+
+/**
+ * @brief Error reply queued by the receive ISR for the main loop to send.
+ *
+ * The received frames and the rejected ones are numbered in the order they ended, so
+ * the main loop can answer them in that order although they are queued apart.
+ */
+struct PendingReply
+{
+    uint8_t format;   /*FRAME_FORMAT_XML or FRAME_FORMAT_BINARY, format of the rejected frame*/
+    uint8_t status;   /*XML_Parser_Status_t the frame was rejected with*/
+    uint8_t command;  /*index of the command the frame was rejected at in the command list, COMMAND_COUNT or above if none is known*/
+    uint8_t sequence; /*number of the rejected frame, see FrameSlot*/
+};
+
+/**
+ * @brief Single-producer single-consumer queue of pending replies.
+ *
+ * The receive ISR is the only producer and the main loop the only consumer, so the
+ * queue needs no lock: each side only writes its own index.
+ */
+struct ReplyQueue
+{
+    struct PendingReply replies[REPLY_QUEUE_DEPTH];  /*pending replies*/
+    volatile uint8_t head;                           /*next entry to write, written by the ISR*/
+    volatile uint8_t tail;                           /*next entry to read, written by the main loop*/
+    volatile uint32_t dropped;                       /*replies dropped because the queue was full*/
+};
+
+/*************function prototypes**********************/
+bool reply_queue_push(struct ReplyQueue *queue, const struct PendingReply *reply);
+bool reply_queue_peek(const struct ReplyQueue *queue, struct PendingReply *reply);
+bool reply_queue_pop(struct ReplyQueue *queue, struct PendingReply *reply);
+
+#endif // REPLY_QUEUE_H
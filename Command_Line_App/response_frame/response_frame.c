@@ -0,0 +1,368 @@
+/**
+ * @file response_frame.c
+ *
+ * @brief Structured responses of the command line, in XML and in the binary format.
+ *
+ * Every frame executed gets one response frame. For every command of the frame it names
+ * the command, carries the status it ended with and the values it reports, so a host
+ * reads a field instead of scraping text and can match every response to its request
+ * while it keeps sending:
+ *
+ *     <UCL><RSP>LightOn</RSP><STATUS>0x00</STATUS><VAL>10</VAL></UCL>
+ *
+ * A batch is answered in the same envelope, one <RSP> group after the other in the
+ * order the commands were received.
+ *
+ * The binary response carries the same fields as the binary request: the command id,
+ * the status, one T(ype) L(ength) V(alue) triple per value, where T is the position of
+ * the value in the "reply" of the command schema and numbers are little-endian, and
+ * the CRC-16 of all of them. A response without values is the status reply the binary
+ * protocol has always sent.
+ *
+ * The frame is written straight into the room it is sent from: no text or payload is
+ * built on the stack and copied. The numbers are formatted by reply_format, and the
+ * binary payload is COBS-encoded where it is, once its CRC is known.
+ */
+
+#include "response_frame.h"
+
+#define STATUS_TEXT_SIZE    (uint16_t) 4   //"0x00", the status in two hexadecimal digits
+#define XML_CLOSING_SIZE    (uint16_t) 7   //</UCL> and the newline
+#define BINARY_CLOSING_SIZE (uint16_t) 3   //CRC-16 and the delimiter
+#define BINARY_PAYLOAD_AT   (uint16_t) 2   //offset of the command id, after the delimiter and the code byte
+#define XML_COMMAND_SIZE    (uint16_t) 32  //<RSP></RSP><STATUS>0x00</STATUS>
+#define BINARY_COMMAND_SIZE (uint16_t) 2   //command id and status
+#define U8_TEXT_SIZE        (uint16_t) 3   //"255"
+#define U16_TEXT_SIZE       (uint16_t) 5   //"65535"
+
+/**
+ * @brief Appends text to the frame, the room has been checked.
+ */
+static void put_text(struct ResponseFrame *response, const char *text, uint16_t length)
+{
+    memcpy(&response->data[response->length], text, length);
+    response->length = (uint16_t)(response->length + length);
+}
+
+/**
+ * @brief Tells whether a value of a given size still fits in front of the end of the frame.
+ *
+ * A value that does not fit is left out, and so are all values and commands after it,
+ * so the values sent are always the first ones of the schema.
+ */
+static bool value_fits(struct ResponseFrame *response, uint16_t length)
+{
+    const uint16_t closing = (response->format == FRAME_FORMAT_BINARY) ? BINARY_CLOSING_SIZE : XML_CLOSING_SIZE;
+
+    //values belong to a command, there is none after a command that did not fit
+    if (!response->data || response->overflow || response->status_at == 0)
+    {
+        return false;
+    }
+
+    if ((uint32_t)response->length + length + closing > response->size)
+    {
+        response->overflow = true;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Appends a binary value as a type, length and little-endian value triple.
+ */
+static void put_binary_value(struct ResponseFrame *response, uint32_t value, uint8_t size)
+{
+    uint8_t index = 0;
+
+    if (value_fits(response, (uint16_t)(RESPONSE_FRAME_BINARY_VALUE + size)))
+    {
+        response->data[response->length++] = (char)response->value_count++;
+        response->data[response->length++] = (char)size;
+
+        for (index = 0; index < size; ++index)
+        {
+            response->data[response->length++] = (char)(uint8_t)(value >> (8U * index));
+        }
+    }
+}
+
+/**
+ * @brief Opens a <VAL> element for text of at most a given length.
+ *
+ * @return true if the element and its text fit, close_xml_value() has to follow.
+ */
+static bool open_xml_value(struct ResponseFrame *response, uint16_t max_length)
+{
+    bool outcome = value_fits(response, (uint16_t)(RESPONSE_FRAME_XML_VALUE + max_length));
+
+    if (outcome)
+    {
+        put_text(response, "<VAL>", 5U);
+    }
+
+    return outcome;
+}
+
+/**
+ * @brief Closes the <VAL> element opened by open_xml_value().
+ */
+static void close_xml_value(struct ResponseFrame *response)
+{
+    put_text(response, "</VAL>", 6U);
+    ++response->value_count;
+}
+
+/**
+ * @brief Returns the size of a response frame that answers one command without values.
+ *
+ * Commands reserve the g_cmd_list entry's reply_size instead, which includes their
+ * values; a batch reserves RESPONSE_FRAME_XML_ENVELOPE once and the rest of the
+ * reply_size of every command.
+ *
+ * @param format FRAME_FORMAT_XML or FRAME_FORMAT_BINARY.
+ * @param name_length Length of the name of the command, 0 if it is unknown.
+ *
+ * @return uint16_t Bytes the frame takes.
+ */
+uint16_t response_frame_size(uint8_t format, uint16_t name_length)
+{
+    return (format == FRAME_FORMAT_BINARY) ? RESPONSE_FRAME_BINARY_OVERHEAD :
+                                             (uint16_t)(RESPONSE_FRAME_XML_OVERHEAD + name_length);
+}
+
+/**
+ * @brief Starts a response frame in reserved room.
+ *
+ * @param response Pointer to the frame being built.
+ * @param format FRAME_FORMAT_XML or FRAME_FORMAT_BINARY, the format of the request.
+ * @param data Room reserved for the frame; NULL if none could be, which makes every
+ *        other call a no-op so a command runs the same with or without a response.
+ * @param size Bytes of room, at least response_frame_size() of the frame.
+ */
+void response_frame_begin(struct ResponseFrame *response, uint8_t format, char *data, uint16_t size)
+{
+    if (!response)
+    {
+        return;
+    }
+
+    response->format = format;
+    response->data = data;
+    response->length = 0;
+    response->status_at = 0;
+    response->value_count = 0;
+    response->overflow = false;
+
+    //the payload of a binary frame has to fit a single COBS block to be encoded in place
+    response->size = (format == FRAME_FORMAT_BINARY && size > BINARY_FRAME_MAX_IN_PLACE + 3U) ?
+                     (uint16_t)(BINARY_FRAME_MAX_IN_PLACE + 3U) : size;
+
+    if (!data || response->size < response_frame_size(format, 0))
+    {
+        response->data = NULL;
+        return;
+    }
+
+    if (format == FRAME_FORMAT_BINARY)
+    {
+        //the code byte at offset 1 is written once the payload is complete
+        data[0] = (char)BINARY_FRAME_DELIMITER;
+        response->length = BINARY_PAYLOAD_AT;
+    }
+    else
+    {
+        put_text(response, "<UCL>", 5U);
+    }
+}
+
+/**
+ * @brief Starts the response to a command, its values follow.
+ *
+ * The status is filled in by response_frame_status() once the command has run. A
+ * command that does not fit is left out, and so is everything after it.
+ *
+ * @param response Pointer to the frame being built.
+ * @param cmd_id Id of the command, sent in binary frames; RESPONSE_FRAME_NO_COMMAND if it is unknown.
+ * @param name Name of the command, sent in XML frames; NULL if it is unknown.
+ * @param name_length Length of the name.
+ */
+void response_frame_command(struct ResponseFrame *response, uint8_t cmd_id, const char *name, uint16_t name_length)
+{
+    uint16_t length = 0;
+
+    if (!response || !response->data || response->overflow)
+    {
+        return;
+    }
+
+    if (!name)
+    {
+        name_length = 0;
+    }
+
+    //the command has to fit in front of the end of the frame
+    length = (response->format == FRAME_FORMAT_BINARY) ? (uint16_t)(BINARY_COMMAND_SIZE + BINARY_CLOSING_SIZE) :
+                                                         (uint16_t)(XML_COMMAND_SIZE + name_length + XML_CLOSING_SIZE);
+
+    if ((uint32_t)response->length + length > response->size)
+    {
+        response->overflow = true;
+        response->status_at = 0;
+        return;
+    }
+
+    response->value_count = 0;
+
+    if (response->format == FRAME_FORMAT_BINARY)
+    {
+        response->data[response->length++] = (char)cmd_id;
+        response->status_at = response->length++;
+    }
+    else
+    {
+        put_text(response, "<RSP>", 5U);
+        put_text(response, name, name_length);
+        put_text(response, "</RSP><STATUS>", 14U);
+        response->status_at = response->length;
+        response->length = (uint16_t)(response->length + STATUS_TEXT_SIZE);
+        put_text(response, "</STATUS>", 9U);
+    }
+}
+
+/**
+ * @brief Appends an unsigned value, in decimal or as a binary value of the given size.
+ *
+ * @param response Pointer to the frame being built.
+ * @param value The value.
+ * @param size Bytes of the binary value: 1 for u8, 2 for u16 and 4 for u32 values; the
+ *        value must fit, the text is checked against the largest value of that size.
+ */
+void response_frame_unsigned(struct ResponseFrame *response, uint32_t value, uint8_t size)
+{
+    if (!response)
+    {
+        return;
+    }
+
+    if (response->format == FRAME_FORMAT_BINARY)
+    {
+        put_binary_value(response, value, size);
+    }
+    else if (open_xml_value(response, (size == 1U) ? U8_TEXT_SIZE : (size == 2U) ? U16_TEXT_SIZE : REPLY_FORMAT_U32_SIZE))
+    {
+        response->length = (uint16_t)(response->length + reply_format_u32(&response->data[response->length], value));
+        close_xml_value(response);
+    }
+}
+
+/**
+ * @brief Appends a signed value, in decimal or as a 4 byte binary value.
+ *
+ * @param response Pointer to the frame being built.
+ * @param value The value.
+ */
+void response_frame_signed(struct ResponseFrame *response, int32_t value)
+{
+    if (!response)
+    {
+        return;
+    }
+
+    if (response->format == FRAME_FORMAT_BINARY)
+    {
+        put_binary_value(response, (uint32_t)value, BINARY_FRAME_MAX_VALUE);
+    }
+    else if (open_xml_value(response, REPLY_FORMAT_I32_SIZE))
+    {
+        response->length = (uint16_t)(response->length + reply_format_i32(&response->data[response->length], value));
+        close_xml_value(response);
+    }
+}
+
+/**
+ * @brief Appends a fixed-point value, as text with its fraction digits or as the scaled 4 byte binary value.
+ *
+ * @param response Pointer to the frame being built.
+ * @param value The value scaled by 10^fraction_digits, the way PARAM_TYPE_FIXED parameters are stored.
+ * @param fraction_digits Number of fraction digits.
+ */
+void response_frame_fixed(struct ResponseFrame *response, int32_t value, uint8_t fraction_digits)
+{
+    if (!response)
+    {
+        return;
+    }
+
+    if (response->format == FRAME_FORMAT_BINARY)
+    {
+        put_binary_value(response, (uint32_t)value, BINARY_FRAME_MAX_VALUE);
+    }
+    else if (open_xml_value(response, REPLY_FORMAT_FIXED_SIZE))
+    {
+        response->length = (uint16_t)(response->length +
+                                      reply_format_fixed(&response->data[response->length], value, fraction_digits));
+        close_xml_value(response);
+    }
+}
+
+/**
+ * @brief Fills in the status of the command started last.
+ *
+ * @param response Pointer to the frame being built.
+ * @param status RESPONSE_STATUS_OK or the status the command ended with.
+ */
+void response_frame_status(struct ResponseFrame *response, uint8_t status)
+{
+    if (!response || !response->data || response->status_at == 0)
+    {
+        return;
+    }
+
+    if (response->format == FRAME_FORMAT_BINARY)
+    {
+        response->data[response->status_at] = (char)status;
+    }
+    else
+    {
+        (void)reply_format_hex(&response->data[response->status_at], status, 2U);
+    }
+}
+
+/**
+ * @brief Completes the frame.
+ *
+ * @param response Pointer to the frame being built.
+ *
+ * @return uint16_t Length of the complete frame, the bytes to send; 0 if it had no room.
+ */
+uint16_t response_frame_end(struct ResponseFrame *response)
+{
+    uint8_t *payload = NULL;
+    uint16_t crc = 0;
+
+    if (!response || !response->data)
+    {
+        return 0;
+    }
+
+    if (response->format == FRAME_FORMAT_BINARY)
+    {
+        payload = (uint8_t *)&response->data[BINARY_PAYLOAD_AT];
+
+        crc = binary_frame_crc16(payload, (uint16_t)(response->length - BINARY_PAYLOAD_AT));
+        response->data[response->length++] = (char)(uint8_t)(crc >> 8);
+        response->data[response->length++] = (char)(uint8_t)crc;
+
+        (void)binary_frame_encode_in_place((uint8_t *)&response->data[1],
+                                           (uint16_t)(response->length - BINARY_PAYLOAD_AT));
+        response->data[response->length++] = (char)BINARY_FRAME_DELIMITER;
+    }
+    else
+    {
+        put_text(response, "</UCL>\n", XML_CLOSING_SIZE);
+    }
+
+    return response->length;
+}
@@ -0,0 +1,56 @@
+#ifndef RESPONSE_FRAME_H
+#define RESPONSE_FRAME_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "../binary_frame/binary_frame.h"
+#include "../reply_format/reply_format.h"
+
+//sizes Tools/gen_command_table.py works out the largest response of every command with
+#define RESPONSE_FRAME_XML_OVERHEAD     (uint16_t) 44  //<UCL><RSP></RSP><STATUS>0x00</STATUS></UCL> and the newline
+#define RESPONSE_FRAME_XML_ENVELOPE     (uint16_t) 12  //<UCL></UCL> and the newline, once per frame however many commands it answers
+#define RESPONSE_FRAME_XML_VALUE        (uint16_t) 11  //<VAL></VAL>
+#define RESPONSE_FRAME_BINARY_OVERHEAD  (uint16_t) 7   //delimiters, COBS code byte, command id, status and CRC-16
+#define RESPONSE_FRAME_BINARY_VALUE     BINARY_FRAME_TLV_HEADER  //type and length bytes of a value
+
+#define RESPONSE_FRAME_NO_COMMAND       (uint8_t) 0xFF //command id of a response to a frame whose command is unknown
+#define RESPONSE_STATUS_OK              (uint8_t) 0x00 //status of a command that ran, any other status is a code of XML_Parser_Status_t
+
+/**
+ * @brief A response frame being built in place.
+ *
+ * The response to a frame is built right where it is sent from, in room reserved in
+ * the transmit queue of the USART for the largest response its commands can have. An
+ * XML frame answers every command of its batch in one envelope, a binary frame
+ * carries a single command:
+ *
+ *     <UCL><RSP>name</RSP><STATUS>0x00</STATUS><VAL>value</VAL>...<RSP>name</RSP>...</UCL>
+ *     0x00 | COBS( cmd_id | status | T L V ... | CRC-16 ) | 0x00
+ *
+ * The status of a command comes first but is only known once the command has run, so
+ * room for it is left and filled in by response_frame_status(); the values go in
+ * between, in the order the command schema lists them in its "reply".
+ */
+struct ResponseFrame
+{
+    uint8_t format;       /*FRAME_FORMAT_XML or FRAME_FORMAT_BINARY*/
+    char *data;           /*first byte of the room, NULL if no room could be reserved*/
+    uint16_t size;        /*bytes of room*/
+    uint16_t length;      /*bytes written so far*/
+    uint16_t status_at;   /*offset of the status of the current command, 0 if none has been started*/
+    uint8_t value_count;  /*values of the current command so far, the type of the next binary value*/
+    bool overflow;        /*true if a value was left out for lack of room*/
+};
+
+/*************function prototypes**********************/
+uint16_t response_frame_size(uint8_t format, uint16_t name_length);
+void response_frame_begin(struct ResponseFrame *response, uint8_t format, char *data, uint16_t size);
+void response_frame_command(struct ResponseFrame *response, uint8_t cmd_id, const char *name, uint16_t name_length);
+void response_frame_unsigned(struct ResponseFrame *response, uint32_t value, uint8_t size);
+void response_frame_signed(struct ResponseFrame *response, int32_t value);
+void response_frame_fixed(struct ResponseFrame *response, int32_t value, uint8_t fraction_digits);
+void response_frame_status(struct ResponseFrame *response, uint8_t status);
+uint16_t response_frame_end(struct ResponseFrame *response);
+
+#endif // RESPONSE_FRAME_H
@@ -0,0 +1,367 @@
+/**
+ * @file tag_matcher.c
+ *
+ * @brief Allocation-free matcher for the XML tags of the command line protocol.
+ *
+ * All the tags the protocol knows about are listed in a pattern table that is built
+ * at compile time. The matcher runs over the input once, one character at a time,
+ * and keeps a bitmask of the patterns that still match the tag name read so far, so
+ * every open and close tag is recognised in a single scan. No heap, memory pool or
+ * stdio function is used, which makes the matcher safe to run inside the receive ISR.
+ *
+ * Opening tags may carry attributes (<P name="ch">); the value of the `name`
+ * attribute is reported with the match, any other attribute is skipped.
+ */
+
+#include "tag_matcher.h"
+
+#define ALL_TAG_CANDIDATES   (uint8_t) ((1U << NO_OF_FRAME_TAGS) - 1U)
+
+/**
+ * @brief States of the matcher state machine.
+ */
+typedef enum
+{
+    TAG_MATCHER_STATE_TEXT = 0,    // reading text outside of a tag
+    TAG_MATCHER_STATE_TAG_START,   // '<' has been read, waiting for '/' or the first name character
+    TAG_MATCHER_STATE_TAG_NAME,    // reading the tag name until whitespace or '>'
+    TAG_MATCHER_STATE_ATTR_GAP,    // whitespace between the name and an attribute, or between attributes
+    TAG_MATCHER_STATE_ATTR_KEY,    // reading an attribute key until '='
+    TAG_MATCHER_STATE_ATTR_QUOTE,  // '=' has been read, waiting for the opening quote
+    TAG_MATCHER_STATE_ATTR_VALUE   // reading an attribute value until the closing quote
+} TagMatcher_State_t;
+
+#define NAME_ATTRIBUTE          "name"
+#define NAME_ATTRIBUTE_LENGTH   (uint8_t) (sizeof(NAME_ATTRIBUTE) - 1U)
+
+/**
+ * @brief Name and length of a known tag.
+ */
+struct TagPattern
+{
+    const char *name;
+    uint8_t length;
+};
+
+#define TAG_PATTERN(name)   {name, (uint8_t)(sizeof(name) - 1U)}
+
+/*pattern table of the known tags, indexed by FrameTag_t*/
+static const struct TagPattern g_tag_patterns[NO_OF_FRAME_TAGS] =
+{
+    TAG_PATTERN("UCL"),   //FRAME_TAG_UCL
+    TAG_PATTERN("CMD"),   //FRAME_TAG_CMD
+    TAG_PATTERN("PARAM"), //FRAME_TAG_PARAM
+    TAG_PATTERN("P")      //FRAME_TAG_P
+};
+
+/**
+ * @brief Resets the matcher so that it starts outside of a tag.
+ *
+ * @param matcher Pointer to the matcher state.
+ */
+void tag_matcher_reset(struct TagMatcher *matcher)
+{
+    if (matcher)
+    {
+        matcher->state       = TAG_MATCHER_STATE_TEXT;
+        matcher->kind_of_tag = OPEN_TAG;
+        matcher->name_length = 0;
+        matcher->candidates  = 0;
+        matcher->tag_start   = 0;
+        matcher->malformed   = false;
+        matcher->attr_length = 0;
+        matcher->attr_match  = false;
+        matcher->attr_quote  = 0;
+        matcher->attr_start  = FRAME_TAG_NOT_FOUND;
+        matcher->attr_end    = FRAME_TAG_NOT_FOUND;
+    }
+}
+
+/**
+ * @brief Narrows down the set of patterns that match the name read so far.
+ *
+ * @param matcher Pointer to the matcher state.
+ * @param received_char Next character of the tag name.
+ */
+static void match_tag_name_char(struct TagMatcher *matcher, char received_char)
+{
+    uint8_t tag = 0;
+
+    //a pattern is kept as a candidate only if its next character matches
+    for (tag = 0; tag < NO_OF_FRAME_TAGS; ++tag)
+    {
+        if ((matcher->candidates & (1U << tag)) &&
+            ((matcher->name_length >= g_tag_patterns[tag].length) ||
+             (g_tag_patterns[tag].name[matcher->name_length] != received_char)))
+        {
+            matcher->candidates &= (uint8_t) ~(1U << tag);
+        }
+    }
+
+    //the name length is saturated; a name that long can not match any pattern anyway
+    if (matcher->name_length < UINT8_MAX)
+    {
+        ++matcher->name_length;
+    }
+}
+
+/**
+ * @brief Fills in the match for the tag terminated by '>'.
+ *
+ * @param matcher Pointer to the matcher state.
+ * @param offset Offset of the '>'.
+ * @param match Pointer to the match to fill in.
+ */
+static void complete_tag(struct TagMatcher *matcher, uint16_t offset, struct TagMatch *match)
+{
+    uint8_t tag = 0;
+
+    match->tag         = NO_OF_FRAME_TAGS;
+    match->kind_of_tag = matcher->kind_of_tag;
+    match->malformed   = matcher->malformed;
+    match->start       = matcher->tag_start;
+    match->end         = offset;
+    match->name_start  = FRAME_TAG_NOT_FOUND;
+    match->name_length = 0;
+
+    //the tag is known if one of the candidates has exactly the length of the name
+    for (tag = 0; tag < NO_OF_FRAME_TAGS; ++tag)
+    {
+        if ((matcher->candidates & (1U << tag)) &&
+            (g_tag_patterns[tag].length == matcher->name_length))
+        {
+            match->tag = tag;
+            break;
+        }
+    }
+
+    //report the value of the name attribute
+    if (matcher->attr_end != FRAME_TAG_NOT_FOUND)
+    {
+        match->name_start  = matcher->attr_start;
+        match->name_length = (uint16_t)(matcher->attr_end - matcher->attr_start);
+    }
+
+    matcher->state = TAG_MATCHER_STATE_TEXT;
+}
+
+/**
+ * @brief Checks whether a character separates the name and the attributes of a tag.
+ */
+static bool is_tag_whitespace(char received_char)
+{
+    return (received_char == ' ' || received_char == '\t' || received_char == '\r' || received_char == '\n');
+}
+
+/**
+ * @brief Handles a character inside the attributes of a tag.
+ *
+ * @param matcher Pointer to the matcher state.
+ * @param received_char The next character of the input.
+ * @param offset Offset of the character in the input.
+ *
+ * @return true if the character is the '>' that ends the tag, false otherwise.
+ */
+static bool match_attribute_char(struct TagMatcher *matcher, char received_char, uint16_t offset)
+{
+    bool tag_complete = false;
+
+    switch (matcher->state)
+    {
+        case TAG_MATCHER_STATE_ATTR_GAP:
+            if (received_char == '>')
+            {
+                tag_complete = true;
+            }
+            else if (!is_tag_whitespace(received_char))
+            {
+                //the first character of a new attribute key
+                matcher->state       = TAG_MATCHER_STATE_ATTR_KEY;
+                matcher->attr_length = 1;
+                matcher->attr_match  = (received_char == NAME_ATTRIBUTE[0]);
+            }
+            break;
+
+        case TAG_MATCHER_STATE_ATTR_KEY:
+            if (received_char == '=')
+            {
+                matcher->attr_match = matcher->attr_match && (matcher->attr_length == NAME_ATTRIBUTE_LENGTH);
+                matcher->state      = TAG_MATCHER_STATE_ATTR_QUOTE;
+            }
+            else if (received_char == '>' || is_tag_whitespace(received_char))
+            {
+                //an attribute without a value
+                matcher->malformed = true;
+                matcher->state     = TAG_MATCHER_STATE_ATTR_GAP;
+                tag_complete       = (received_char == '>');
+            }
+            else
+            {
+                matcher->attr_match = matcher->attr_match &&
+                                      (matcher->attr_length < NAME_ATTRIBUTE_LENGTH) &&
+                                      (NAME_ATTRIBUTE[matcher->attr_length] == received_char);
+
+                if (matcher->attr_length < UINT8_MAX)
+                {
+                    ++matcher->attr_length;
+                }
+            }
+            break;
+
+        case TAG_MATCHER_STATE_ATTR_QUOTE:
+            if (received_char == '"' || received_char == '\'')
+            {
+                matcher->attr_quote = received_char;
+                matcher->state      = TAG_MATCHER_STATE_ATTR_VALUE;
+
+                if (matcher->attr_match)
+                {
+                    matcher->attr_start = offset + 1;
+                }
+            }
+            else
+            {
+                //the value of an attribute has to be quoted
+                matcher->malformed = true;
+                matcher->state     = TAG_MATCHER_STATE_ATTR_GAP;
+                tag_complete       = (received_char == '>');
+            }
+            break;
+
+        case TAG_MATCHER_STATE_ATTR_VALUE:
+            if (received_char == matcher->attr_quote)
+            {
+                if (matcher->attr_match)
+                {
+                    //a repeated name attribute makes the tag ambiguous
+                    if (matcher->attr_end != FRAME_TAG_NOT_FOUND)
+                    {
+                        matcher->malformed = true;
+                    }
+                    matcher->attr_end = offset;
+                }
+                matcher->state = TAG_MATCHER_STATE_ATTR_GAP;
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    return tag_complete;
+}
+
+/**
+ * @brief Feeds one character into the matcher.
+ *
+ * The work done per character is constant, so the matcher can run inside the
+ * receive ISR.
+ *
+ * @param matcher Pointer to the matcher state.
+ * @param received_char The next character of the input.
+ * @param offset Offset of the character in the input.
+ * @param match Pointer to the match that is filled in when a tag is completed.
+ *
+ * @return true if the character completed a tag (known or unknown), false otherwise.
+ */
+bool tag_matcher_feed(struct TagMatcher *matcher, char received_char, uint16_t offset, struct TagMatch *match)
+{
+    bool outcome = false;
+
+    //validate input parameters
+    if (!matcher || !match)
+    {
+        return false;
+    }
+
+    switch (matcher->state)
+    {
+        case TAG_MATCHER_STATE_TEXT:
+            if (received_char == '<')
+            {
+                //a new tag starts, every pattern is a candidate again
+                tag_matcher_reset(matcher);
+                matcher->state      = TAG_MATCHER_STATE_TAG_START;
+                matcher->candidates = ALL_TAG_CANDIDATES;
+                matcher->tag_start  = offset;
+            }
+            break;
+
+        case TAG_MATCHER_STATE_TAG_START:
+            matcher->state = TAG_MATCHER_STATE_TAG_NAME;
+
+            if (received_char == '/')
+            {
+                matcher->kind_of_tag = CLOSE_TAG;
+            }
+            else if (received_char == '>')
+            {
+                complete_tag(matcher, offset, match);
+                outcome = true;
+            }
+            else
+            {
+                match_tag_name_char(matcher, received_char);
+            }
+            break;
+
+        case TAG_MATCHER_STATE_TAG_NAME:
+            if (received_char == '>')
+            {
+                complete_tag(matcher, offset, match);
+                outcome = true;
+            }
+            else if (is_tag_whitespace(received_char))
+            {
+                //the name ends, attributes may follow; closing tags can not have any
+                matcher->state = TAG_MATCHER_STATE_ATTR_GAP;
+            }
+            else
+            {
+                match_tag_name_char(matcher, received_char);
+            }
+            break;
+
+        case TAG_MATCHER_STATE_ATTR_GAP:
+        case TAG_MATCHER_STATE_ATTR_KEY:
+        case TAG_MATCHER_STATE_ATTR_QUOTE:
+        case TAG_MATCHER_STATE_ATTR_VALUE:
+            //attributes of a closing tag are not allowed
+            if (matcher->kind_of_tag == CLOSE_TAG && !is_tag_whitespace(received_char) && received_char != '>')
+            {
+                matcher->malformed = true;
+            }
+
+            if (match_attribute_char(matcher, received_char, offset))
+            {
+                complete_tag(matcher, offset, match);
+                outcome = true;
+            }
+            break;
+
+        default:
+            tag_matcher_reset(matcher);
+            break;
+    }
+
+    return outcome;
+}
+
+/**
+ * @brief Marks every tag in the offset table as not found.
+ *
+ * @param offsets Pointer to the offset table.
+ */
+void tag_matcher_reset_offsets(struct FrameTagOffsets *offsets)
+{
+    uint8_t tag = 0;
+
+    if (offsets)
+    {
+        for (tag = 0; tag < NO_OF_FRAME_TAGS; ++tag)
+        {
+            offsets->open[tag]  = FRAME_TAG_NOT_FOUND;
+            offsets->close[tag] = FRAME_TAG_NOT_FOUND;
+        }
+    }
+}
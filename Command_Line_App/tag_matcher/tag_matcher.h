@@ -0,0 +1,78 @@
+#ifndef TAG_MATCHER_H
+#define TAG_MATCHER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define OPEN_TAG     (uint8_t) 0
+#define CLOSE_TAG    (uint8_t) 1
+
+#define FRAME_TAG_NOT_FOUND      (uint16_t) 0xFFFF //offset value of a tag that has not been found
+
+/**
+ * @brief Identifiers of the XML tags known by the tag matcher.
+ */
+typedef enum
+{
+    FRAME_TAG_UCL = 0,   // Index 0: parent tag <UCL> ... </UCL>
+    FRAME_TAG_CMD,       // Index 1: command tag <CMD> ... </CMD>
+    FRAME_TAG_PARAM,     // Index 2: parameter tag <PARAM> ... </PARAM>
+    FRAME_TAG_P,         // Index 3: named parameter tag <P name="..."> ... </P>
+    NO_OF_FRAME_TAGS     // Total number of known tags
+} FrameTag_t;
+
+/**
+ * @brief Offsets of the known tags inside a frame.
+ *
+ * open[tag] is the offset of the first byte after "<TAG>" (the start of its value) and
+ * close[tag] is the offset of the '<' of "</TAG>" (the end of its value). Only the first
+ * occurrence of every tag is recorded; missing tags hold FRAME_TAG_NOT_FOUND.
+ */
+struct FrameTagOffsets
+{
+    uint16_t open[NO_OF_FRAME_TAGS];
+    uint16_t close[NO_OF_FRAME_TAGS];
+};
+
+/**
+ * @brief A tag recognised by the matcher.
+ *
+ * Attributes are only allowed in opening tags and only the value of the `name`
+ * attribute is reported, e.g. ch for <P name="ch">.
+ */
+struct TagMatch
+{
+    uint8_t  tag;          /*FrameTag_t of the tag, NO_OF_FRAME_TAGS if the tag is unknown*/
+    uint8_t  kind_of_tag;  /*OPEN_TAG or CLOSE_TAG*/
+    bool     malformed;    /*true if the attributes of the tag are not well-formed*/
+    uint16_t start;        /*offset of the '<' of the tag*/
+    uint16_t end;          /*offset of the '>' of the tag*/
+    uint16_t name_start;   /*offset of the value of the name attribute, FRAME_TAG_NOT_FOUND if absent*/
+    uint16_t name_length;  /*length of the value of the name attribute*/
+};
+
+/**
+ * @brief State of the incremental tag matcher.
+ */
+struct TagMatcher
+{
+    uint8_t  state;        /*current state of the matcher state machine*/
+    uint8_t  kind_of_tag;  /*OPEN_TAG or CLOSE_TAG for the tag being read*/
+    uint8_t  name_length;  /*number of tag name characters read so far*/
+    uint8_t  candidates;   /*bitmask of the known tags that still match the name read so far*/
+    uint16_t tag_start;    /*offset of the '<' of the tag being read*/
+    bool     malformed;    /*true once the attributes of the tag are not well-formed*/
+    uint8_t  attr_length;  /*number of characters of the attribute key read so far*/
+    bool     attr_match;   /*true while the attribute key read so far matches "name"*/
+    char     attr_quote;   /*quote character that opened the attribute value*/
+    uint16_t attr_start;   /*offset of the value of the name attribute*/
+    uint16_t attr_end;     /*offset of the closing quote of the name attribute*/
+};
+
+/*************function prototypes**********************/
+void tag_matcher_reset(struct TagMatcher *matcher);
+bool tag_matcher_feed(struct TagMatcher *matcher, char received_char, uint16_t offset, struct TagMatch *match);
+void tag_matcher_reset_offsets(struct FrameTagOffsets *offsets);
+
+#endif // TAG_MATCHER_H
@@ -0,0 +1,23 @@
+#ifndef __HAL_DMA_CONF_H
+#define __HAL_DMA_CONF_H
+
+#include "../../HAL-SYSTEM/inc/stm32f10x.h"
+#include "../../HAL-RCC/inc/stm32f10x_rcc.h"
+#include "../../HAL-SYSTEM/inc/core_cm3.h"
+#include "../../HAL-UART/inc/hal_usart_ports.h"
+#include <stdint.h>
+
+#define USART_RX_RING_SIZE       (uint16_t) 128          //bytes of every receive ring, must be a power of two
+#define DMA_NVIC_PERIORITY       (uint32_t) 0x00000000   //same as the USARTs so the receive handlers never preempt each other
+
+//rings the DMA writes every byte received on a USART into, indexed by UsartPort_t
+extern uint8_t g_usart_rx_rings[USART_PORT_COUNT][USART_RX_RING_SIZE];
+
+void HAL_DMA_USART_RxConfig(UsartPort_t port, USART_TypeDef *USARTx);
+uint16_t HAL_DMA_USART_RxWriteIndex(UsartPort_t port);
+void HAL_DMA_USART_RxClearFlags(UsartPort_t port);
+void HAL_DMA_USART_TxConfig(UsartPort_t port, USART_TypeDef *USARTx);
+void HAL_DMA_USART_TxStart(UsartPort_t port, const void *data, uint16_t length);
+void HAL_DMA_USART_TxClearFlags(UsartPort_t port);
+
+#endif /* __HAL_DMA_CONF_H */
@@ -0,0 +1,179 @@
+/*
+ * hal_dma_config.c
+ *
+ * This source file configures the DMA1 channels that receive the USARTs into
+ * circular ring buffers and the ones that transmit them. It includes:
+ *
+ * - Configuration of a channel in circular mode with half and full transfer interrupts.
+ * - The position the DMA is currently writing to, for the receive ISR to read up to.
+ * - Transmission of one block of memory at a time, in normal mode with a full transfer
+ *   interrupt when the last byte has been handed to the USART.
+ *
+ * The DMA moves every received byte into the ring without waking the CPU; the CPU only
+ * runs when the line goes idle after a burst or when half of the ring has been filled.
+ * In the other direction the CPU only runs once per block sent.
+ * The StdPeriph DMA driver is not part of the project, the channels are programmed
+ * through their registers.
+ */
+
+#include "../inc/hal_dma_config.h"
+
+//flags of channel 1 in ISR and IFCR, every further channel has the same four bits 4 positions higher
+#define DMA_CHANNEL1_FLAGS  (uint32_t)(DMA_IFCR_CGIF1 | DMA_IFCR_CTCIF1 | DMA_IFCR_CHTIF1 | DMA_IFCR_CTEIF1)
+
+/**
+ * @brief DMA1 channel mapped to the RX or TX request of a USART.
+ */
+struct UsartDmaChannel
+{
+    DMA_Channel_TypeDef *channel;   /*the channel, fixed by the request mapping of DMA1*/
+    IRQn_Type irq;                  /*its interrupt*/
+    uint8_t flag_shift;             /*position of its flags in ISR and IFCR*/
+};
+
+//receive channel of every USART, indexed by UsartPort_t
+static const struct UsartDmaChannel g_usart_rx_channels[USART_PORT_COUNT] =
+{
+    { DMA1_Channel5, DMA1_Channel5_IRQn, 16U },
+    { DMA1_Channel6, DMA1_Channel6_IRQn, 20U },
+    { DMA1_Channel3, DMA1_Channel3_IRQn, 8U },
+};
+
+//transmit channel of every USART, indexed by UsartPort_t
+static const struct UsartDmaChannel g_usart_tx_channels[USART_PORT_COUNT] =
+{
+    { DMA1_Channel4, DMA1_Channel4_IRQn, 12U },
+    { DMA1_Channel7, DMA1_Channel7_IRQn, 24U },
+    { DMA1_Channel2, DMA1_Channel2_IRQn, 4U },
+};
+
+//rings the DMA writes every byte received on a USART into, indexed by UsartPort_t
+uint8_t g_usart_rx_rings[USART_PORT_COUNT][USART_RX_RING_SIZE];
+
+/**
+ * @brief Configures the DMA1 channel of a USART to copy every received byte into its ring.
+ *
+ * The channel runs in circular mode and never stops; the half and full transfer
+ * interrupts make sure the ring is read before the DMA wraps around onto unread bytes.
+ * The USART itself has to be configured to issue DMA requests. The bits of CCR are the
+ * same in every channel.
+ *
+ * @param port The USART the channel receives.
+ * @param USARTx Pointer to the USART peripheral of the port.
+ */
+void HAL_DMA_USART_RxConfig(UsartPort_t port, USART_TypeDef *USARTx)
+{
+    const struct UsartDmaChannel *rx = &g_usart_rx_channels[port];
+
+    //enable the clock of DMA1 to prepare it for configuration
+    RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA1, ENABLE);
+
+    //the channel can only be configured while it is disabled
+    rx->channel->CCR &= (uint32_t)~DMA_CCR1_EN;
+
+    //from the data register of the USART into the ring, one byte per request
+    rx->channel->CPAR  = (uint32_t)(uintptr_t)&USARTx->DR;
+    rx->channel->CMAR  = (uint32_t)(uintptr_t)g_usart_rx_rings[port];
+    rx->channel->CNDTR = USART_RX_RING_SIZE;
+
+    //peripheral to memory, 8-bit transfers, memory increment, circular, high priority
+    rx->channel->CCR = DMA_CCR1_MINC | DMA_CCR1_CIRC | DMA_CCR1_HTIE | DMA_CCR1_TCIE | DMA_CCR1_PL_1;
+
+    //discard flags left over from a previous configuration
+    DMA1->IFCR = DMA_CHANNEL1_FLAGS << rx->flag_shift;
+
+    //configure NVIC for the half and full transfer interrupts
+    NVIC_SetPriority(rx->irq, DMA_NVIC_PERIORITY);
+    NVIC_EnableIRQ(rx->irq);
+
+    //start the channel, it waits for requests from the USART
+    rx->channel->CCR |= DMA_CCR1_EN;
+}
+
+/**
+ * @brief Returns the position of the ring the DMA writes the next received byte to.
+ *
+ * @param port The USART the ring belongs to.
+ *
+ * @return uint16_t Index into the ring of the port, from 0 to USART_RX_RING_SIZE - 1.
+ */
+uint16_t HAL_DMA_USART_RxWriteIndex(UsartPort_t port)
+{
+    //CNDTR counts down from the ring size and is reloaded when it reaches zero
+    uint16_t remaining = (uint16_t)g_usart_rx_channels[port].channel->CNDTR;
+
+    return (uint16_t)((USART_RX_RING_SIZE - remaining) & (USART_RX_RING_SIZE - 1U));
+}
+
+/**
+ * @brief Clears the interrupt flags of the receive channel of a USART.
+ *
+ * @param port The USART the channel receives.
+ */
+void HAL_DMA_USART_RxClearFlags(UsartPort_t port)
+{
+    DMA1->IFCR = DMA_CHANNEL1_FLAGS << g_usart_rx_channels[port].flag_shift;
+}
+
+/**
+ * @brief Configures the DMA1 channel that transmits a USART.
+ *
+ * The channel stays disabled until HAL_DMA_USART_TxStart() gives it a block to send.
+ * Its priority is below the one of the receive channels, a received byte must never
+ * wait for a transmitted one. The USART itself has to be configured to issue DMA
+ * requests.
+ *
+ * @param port The USART the channel transmits.
+ * @param USARTx Pointer to the USART peripheral of the port.
+ */
+void HAL_DMA_USART_TxConfig(UsartPort_t port, USART_TypeDef *USARTx)
+{
+    const struct UsartDmaChannel *tx = &g_usart_tx_channels[port];
+
+    //enable the clock of DMA1 to prepare it for configuration
+    RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA1, ENABLE);
+
+    tx->channel->CCR &= (uint32_t)~DMA_CCR1_EN;
+    tx->channel->CPAR = (uint32_t)(uintptr_t)&USARTx->DR;
+
+    //memory to peripheral, 8-bit transfers, memory increment, normal mode, medium priority
+    tx->channel->CCR = DMA_CCR1_DIR | DMA_CCR1_MINC | DMA_CCR1_TCIE | DMA_CCR1_PL_0;
+
+    //discard flags left over from a previous configuration
+    DMA1->IFCR = DMA_CHANNEL1_FLAGS << tx->flag_shift;
+
+    //configure NVIC for the full transfer interrupt
+    NVIC_SetPriority(tx->irq, DMA_NVIC_PERIORITY);
+    NVIC_EnableIRQ(tx->irq);
+}
+
+/**
+ * @brief Sends a block of memory through the transmit channel of a USART.
+ *
+ * The previous block must have been completed. The memory is read while it is sent,
+ * so it must not change until the full transfer interrupt.
+ *
+ * @param port The USART.
+ * @param data First byte to send.
+ * @param length Number of bytes, at least 1.
+ */
+void HAL_DMA_USART_TxStart(UsartPort_t port, const void *data, uint16_t length)
+{
+    const struct UsartDmaChannel *tx = &g_usart_tx_channels[port];
+
+    //the count and the address can only be written while the channel is disabled
+    tx->channel->CCR &= (uint32_t)~DMA_CCR1_EN;
+    tx->channel->CMAR  = (uint32_t)(uintptr_t)data;
+    tx->channel->CNDTR = length;
+    tx->channel->CCR |= DMA_CCR1_EN;
+}
+
+/**
+ * @brief Clears the interrupt flags of the transmit channel of a USART.
+ *
+ * @param port The USART the channel transmits.
+ */
+void HAL_DMA_USART_TxClearFlags(UsartPort_t port)
+{
+    DMA1->IFCR = DMA_CHANNEL1_FLAGS << g_usart_tx_channels[port].flag_shift;
+}
@@ -0,0 +1,34 @@
+#ifndef __HAL_DWT_CONF_H
+#define __HAL_DWT_CONF_H
+
+#include "../../HAL-SYSTEM/inc/stm32f10x.h"
+#include "../../HAL-RCC/inc/stm32f10x_rcc.h"
+#include "../../HAL-SYSTEM/inc/core_cm3.h"
+#include "../../HAL-SYSTICK/inc/hal_systick_config.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define DWT_US_PER_S             (uint32_t) 1000000
+
+/**
+ * @brief A point in time a blocking wait gives up at.
+ *
+ * Deadlines are kept in core clock cycles, so a wait lasts the same whatever the clock,
+ * the compiler or the baud rate. The cycle counter wraps around after 2^32 cycles, 59 s
+ * at 72 MHz, which is the longest timeout a deadline can hold.
+ */
+struct HalDeadline
+{
+    uint32_t start;    /*cycle count the wait started or last made progress at*/
+    uint32_t cycles;   /*cycles the wait may take from start*/
+};
+
+void HAL_DWT_Config(void);
+bool HAL_DWT_HasCycleCounter(void);
+uint32_t HAL_GetCycles(void);
+uint32_t HAL_MicrosToCycles(uint32_t micros);
+void HAL_DeadlineStart(struct HalDeadline *deadline, uint32_t timeout_us);
+void HAL_DeadlineRestart(struct HalDeadline *deadline);
+bool HAL_DeadlineExpired(const struct HalDeadline *deadline);
+
+#endif /* __HAL_DWT_CONF_H */
@@ -0,0 +1,142 @@
+/*
+ * hal_dwt_config.c
+ *
+ * This source file provides the time base of the blocking waits of the HAL. It includes:
+ *
+ * - Configuration of the cycle counter of the Data Watchpoint and Trace unit (DWT) of
+ *   the Cortex-M3 core, which counts every core clock cycle.
+ * - A fallback for cores without the cycle counter, which counts the cycles from the
+ *   SysTick ticks and the current value of the SysTick counter instead.
+ * - Deadlines in microseconds, converted to cycles of the clock the core runs at.
+ *
+ * A timeout that counts loop iterations lasts longer or shorter with every change of
+ * the clock, of the compiler and of what the loop does, and one that counts SysTick
+ * ticks is only as precise as a millisecond. Cycles are neither: a deadline stays
+ * correct when SYSCLK changes, and a wait of a few byte times at a high baud rate is
+ * not rounded up to whole ticks.
+ */
+
+#include "../inc/hal_dwt_config.h"
+
+//core clock cycles per microsecond, HCLK / 1 MHz
+static uint32_t g_dwt_cycles_per_us = 0;
+
+//true if the cycle counter of the DWT runs, false if the cycles are counted from SysTick
+static bool g_dwt_cycle_counter = false;
+
+/**
+ * @brief Starts the cycle counter, or selects the SysTick fallback on a core without one.
+ *
+ * The fallback needs SysTick to run, so it has to be called after HAL_SysTick_Config().
+ */
+void HAL_DWT_Config(void)
+{
+    RCC_ClocksTypeDef clocks;
+
+    //the deadlines are converted with the clock the core runs at now
+    RCC_GetClocksFreq(&clocks);
+    g_dwt_cycles_per_us = clocks.HCLK_Frequency / DWT_US_PER_S;
+
+    //the DWT is part of the debug unit, which is off without a debugger until TRCENA is set
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+
+    g_dwt_cycle_counter = !(DWT->CTRL & DWT_CTRL_NOCYCCNT_Msk);
+
+    if (g_dwt_cycle_counter)
+    {
+        DWT->CYCCNT = 0;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    }
+}
+
+/**
+ * @brief Tells whether the cycles are counted by the DWT or by the SysTick fallback.
+ *
+ * @return true if the cycle counter of the DWT runs.
+ */
+bool HAL_DWT_HasCycleCounter(void)
+{
+    return g_dwt_cycle_counter;
+}
+
+/**
+ * @brief Counts the cycles since HAL_SysTick_Config() from SysTick.
+ *
+ * SysTick counts down from LOAD once per tick, so the cycles are the ticks times the
+ * period and what the counter has counted of the current tick. If it wraps while it
+ * is read, the tick changes too and the count is read again. With interrupts masked
+ * the tick is not counted until they are unmasked, so the count stays behind by a
+ * tick at most.
+ */
+static uint32_t systick_cycles(void)
+{
+    const uint32_t period = (SysTick->LOAD & SysTick_LOAD_RELOAD_Msk) + 1U;
+    uint32_t ticks = 0;
+    uint32_t counted = 0;
+
+    do
+    {
+        ticks = g_systick_ticks;
+        counted = period - 1U - (SysTick->VAL & SysTick_VAL_CURRENT_Msk);
+    } while (ticks != g_systick_ticks);
+
+    return ticks * period + counted;
+}
+
+/**
+ * @brief Returns the core clock cycles counted so far.
+ *
+ * @return uint32_t The cycle count, differences of two values are valid across a wrap.
+ */
+uint32_t HAL_GetCycles(void)
+{
+    return g_dwt_cycle_counter ? DWT->CYCCNT : systick_cycles();
+}
+
+/**
+ * @brief Converts a time in microseconds to core clock cycles.
+ *
+ * @param micros The time.
+ *
+ * @return uint32_t The cycles, at most the 2^32 - 1 a deadline can hold.
+ */
+uint32_t HAL_MicrosToCycles(uint32_t micros)
+{
+    const uint64_t cycles = (uint64_t)micros * g_dwt_cycles_per_us;
+
+    return (cycles > UINT32_MAX) ? UINT32_MAX : (uint32_t)cycles;
+}
+
+/**
+ * @brief Starts a deadline that expires a given time from now.
+ *
+ * @param deadline Pointer to the deadline.
+ * @param timeout_us Time to the deadline in microseconds.
+ */
+void HAL_DeadlineStart(struct HalDeadline *deadline, uint32_t timeout_us)
+{
+    deadline->start = HAL_GetCycles();
+    deadline->cycles = HAL_MicrosToCycles(timeout_us);
+}
+
+/**
+ * @brief Moves a deadline to the same time from now, for a wait that has made progress.
+ *
+ * @param deadline Pointer to the deadline.
+ */
+void HAL_DeadlineRestart(struct HalDeadline *deadline)
+{
+    deadline->start = HAL_GetCycles();
+}
+
+/**
+ * @brief Tells whether a deadline has passed.
+ *
+ * @param deadline Pointer to the deadline.
+ *
+ * @return true once the time given to HAL_DeadlineStart() has passed since it started.
+ */
+bool HAL_DeadlineExpired(const struct HalDeadline *deadline)
+{
+    return (uint32_t)(HAL_GetCycles() - deadline->start) > deadline->cycles;
+}
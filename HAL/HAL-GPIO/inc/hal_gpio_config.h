@@ -4,9 +4,39 @@
 #include "../../HAL-SYSTEM/inc/stm32f10x.h"
 #include "../../HAL-RCC/inc/stm32f10x_rcc.h"
 #include "stm32f10x_gpio.h"
-#include <stdio.h>
+#include "../../HAL-UART/inc/hal_usart_ports.h"
+#include <stdbool.h>
 #include <string.h>
 
+#define USART1_FLOW_CONTROL   0           //1: CTS (PA11) and RTS (PA12), off because they are the USB pins
+#define USART2_FLOW_CONTROL   1           //1: CTS (PA0) holds the transmitter, RTS (PA1) stops the sender when the frame ring fills up
+#define USART3_FLOW_CONTROL   0           //1: CTS (PB13) and RTS (PB14)
+
+#define USART1_CTS_PIN        GPIO_Pin_11 //input, pulled down so a sender without flow control is always clear to send
+#define USART1_RTS_PIN        GPIO_Pin_12 //output driven by software, low while the command line can take more frames
+#define USART2_CTS_PIN        GPIO_Pin_0
+#define USART2_RTS_PIN        GPIO_Pin_1
+#define USART3_CTS_PIN        GPIO_Pin_13
+#define USART3_RTS_PIN        GPIO_Pin_14
+
+/**
+ * @brief Pins a USART is wired to, all of them on one GPIO port.
+ */
+struct UsartPins
+{
+    GPIO_TypeDef *gpio;     /*port of the pins*/
+    uint32_t rcc_gpio;      /*clock of the port, on APB2*/
+    uint16_t tx_pin;        /*alternate function output*/
+    uint16_t rx_pin;        /*floating input*/
+    uint16_t cts_pin;       /*input with pull-down, used with flow control*/
+    uint16_t rts_pin;       /*output driven by software, used with flow control*/
+    bool enabled;           /*a command line session runs on the USART*/
+    bool flow_control;      /*CTS and RTS are used*/
+};
+
+//pins of every USART, indexed by UsartPort_t
+extern const struct UsartPins g_usart_pins[USART_PORT_COUNT];
+
 void HAL_GPIO_Config(void);
 
 #endif /* __HAL_GPIO_CONF_H */
@@ -3,41 +3,83 @@
  *
  * This header file provides the declaration and implementation of the 
  * HAL_GPIO_Config function, which is responsible for configuring GPIO pins 
- * used for USART2 communication.
+ * used for the USART communication of every command line session.
  *
  * This function initializes the necessary GPIO settings, including enabling 
- * the clocks, configuring pin modes, and remapping USART2 functionality.
+ * the clocks and configuring pin modes. The USARTs use their default pins on
+ * ports A and B; the remapped pins of USART2 and USART3 on port D do not exist
+ * on the 48-pin package.
  */
 
 
 
 #include "../inc/hal_gpio_config.h"
 
+//pins of every USART, indexed by UsartPort_t
+const struct UsartPins g_usart_pins[USART_PORT_COUNT] =
+{
+    { GPIOA, RCC_APB2Periph_GPIOA, GPIO_Pin_9,  GPIO_Pin_10, USART1_CTS_PIN, USART1_RTS_PIN,
+      USART1_COMMAND_LINE, USART1_FLOW_CONTROL },
+    { GPIOA, RCC_APB2Periph_GPIOA, GPIO_Pin_2,  GPIO_Pin_3,  USART2_CTS_PIN, USART2_RTS_PIN,
+      USART2_COMMAND_LINE, USART2_FLOW_CONTROL },
+    { GPIOB, RCC_APB2Periph_GPIOB, GPIO_Pin_10, GPIO_Pin_11, USART3_CTS_PIN, USART3_RTS_PIN,
+      USART3_COMMAND_LINE, USART3_FLOW_CONTROL },
+};
+
 /**
- * @brief Configures GPIO pins for USART2 communication.
- *        - PA2: TX (Alternate Function Push-Pull)
- *        - PA3: RX (Floating Input)
+ * @brief Configures GPIO pins for the USART of every command line session.
+ *        - TX: Alternate Function Push-Pull
+ *        - RX: Floating Input
+ *        - CTS: Input Pull-Down, with flow control
+ *        - RTS: General Purpose Push-Pull, with flow control
  */
 void HAL_GPIO_Config(void)
 {
     GPIO_InitTypeDef GPIO_USART_Config;
+    const struct UsartPins *pins = NULL;
+    uint8_t port = 0;
+
+    //the USARTs stay on their default pins and are not remapped: GPIO_Remap_USART2 would
+    //move USART2 to PD3..PD7, which the 48-pin package does not have
+
+    for (port = 0; port < (uint8_t)USART_PORT_COUNT; ++port)
+    {
+        pins = &g_usart_pins[port];
+
+        if (!pins->enabled)
+        {
+            continue;
+        }
+
+        //enable clock for the GPIO port to access its pins
+        RCC_APB2PeriphClockCmd(pins->rcc_gpio, ENABLE);
 
-    //enable clock for GPIOA to access its pins
-    RCC_APB2PeriphClockCmd(RCC_APB2Periph_GPIOA, ENABLE);
+        //configure TX (Transmit) with Alternate Function Push-Pull mode
+        GPIO_USART_Config.GPIO_Mode  = GPIO_Mode_AF_PP;  //Alternate Function Push-Pull
+        GPIO_USART_Config.GPIO_Speed = GPIO_Speed_50MHz; //High-speed configuration
+        GPIO_USART_Config.GPIO_Pin   = pins->tx_pin;     //Select the TX pin
+        GPIO_Init(pins->gpio, &GPIO_USART_Config);      //Initialize the TX pin
 
-    //enable alternate function remapping for USART2
-    GPIO_PinRemapConfig(GPIO_Remap_USART2, ENABLE);
+        //Configure RX (Receive) with Floating Input mode
+        GPIO_USART_Config.GPIO_Mode  = GPIO_Mode_IN_FLOATING; //Input floating
+        GPIO_USART_Config.GPIO_Pin   = pins->rx_pin;          //Select the RX pin
+        GPIO_Init(pins->gpio, &GPIO_USART_Config);           //Initialize the RX pin
 
-    //configure PA2 as TX (Transmit) with Alternate Function Push-Pull mode
-    GPIO_USART_Config.GPIO_Mode  = GPIO_Mode_AF_PP;  //Alternate Function Push-Pull
-    GPIO_USART_Config.GPIO_Speed = GPIO_Speed_50MHz; //High-speed configuration
-    GPIO_USART_Config.GPIO_Pin   = GPIO_Pin_2;       //Select pin PA2
-    GPIO_Init(GPIOA, &GPIO_USART_Config);           //Initialize GPIOA Pin 2
+        if (pins->flow_control)
+        {
+            //configure CTS; the pull-down keeps a sender without flow control clear to send
+            GPIO_USART_Config.GPIO_Mode  = GPIO_Mode_IPD;     //Input pull-down
+            GPIO_USART_Config.GPIO_Pin   = pins->cts_pin;     //Select the CTS pin
+            GPIO_Init(pins->gpio, &GPIO_USART_Config);       //Initialize the CTS pin
 
-    //Configure PA3 as RX (Receive) with Floating Input mode
-    GPIO_USART_Config.GPIO_Mode  = GPIO_Mode_IN_FLOATING; //Input floating
-    GPIO_USART_Config.GPIO_Pin   = GPIO_Pin_3;            //Select pin PA3
-    GPIO_Init(GPIOA, &GPIO_USART_Config);                //Initialize GPIOA Pin 3
+            //configure RTS, the hardware RTS follows RXNE and is of no use with DMA reception;
+            //the sender is held until the USART is ready
+            GPIO_SetBits(pins->gpio, pins->rts_pin);
+            GPIO_USART_Config.GPIO_Mode  = GPIO_Mode_Out_PP;  //General Purpose Push-Pull
+            GPIO_USART_Config.GPIO_Pin   = pins->rts_pin;     //Select the RTS pin
+            GPIO_Init(pins->gpio, &GPIO_USART_Config);       //Initialize the RTS pin
+        }
+    }
 }
 
 
@@ -6,7 +6,10 @@
 #include "../../HAL-GPIO/inc/hal_gpio_config.h"
 #include "../../HAL-GPIO/inc/stm32f10x_gpio.h"
 #include "../../HAL-UART/inc/stm32f10x_usart.h"
-#include "../../HAL-UART/inc/hal_usart2_config.h"
+#include "../../HAL-UART/inc/hal_usart_config.h"
+#include "../../HAL-DMA/inc/hal_dma_config.h"
+#include "../../HAL-SYSTICK/inc/hal_systick_config.h"
+#include "../../HAL-DWT/inc/hal_dwt_config.h"
 
 typedef enum {
     HAL_OK = 0,         // Operation completed successfully
@@ -5,7 +5,9 @@
  * It includes:
  *
  * - Initialization and configuration of general-purpose input/output (GPIO).
- * - Configuration and initialization of USART2 for communication purposes.
+ * - Configuration and initialization of the USART of every command line session.
+ * - Configuration of SysTick as the millisecond time base of the receive timeouts.
+ * - Configuration of the DWT cycle counter as the time base of the blocking waits.
  * - Integration of core functions to prepare the microcontroller for reliable operation.
  *
  * The file serves as the entry point for configuring critical hardware components 
@@ -17,7 +19,17 @@
 void HAL_config_MCU(void)
 {
     HAL_GPIO_Config();
-    HAL_USART2_Config();
+#if USART1_COMMAND_LINE
+    HAL_USART_Config(USART_PORT_1);
+#endif
+#if USART2_COMMAND_LINE
+    HAL_USART_Config(USART_PORT_2);
+#endif
+#if USART3_COMMAND_LINE
+    HAL_USART_Config(USART_PORT_3);
+#endif
+    HAL_SysTick_Config();
+    HAL_DWT_Config();
 }
 
 
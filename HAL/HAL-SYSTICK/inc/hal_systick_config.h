@@ -0,0 +1,19 @@
+#ifndef __HAL_SYSTICK_CONF_H
+#define __HAL_SYSTICK_CONF_H
+
+#include "../../HAL-SYSTEM/inc/stm32f10x.h"
+#include "../../HAL-RCC/inc/stm32f10x_rcc.h"
+#include "../../HAL-SYSTEM/inc/core_cm3.h"
+#include <stdint.h>
+
+#define SYSTICK_FREQUENCY_HZ     (uint32_t) 1000         //one tick per millisecond
+#define SYSTICK_NVIC_PERIORITY   (uint32_t) 0x00000000   //the USARTs and DMA channels run at 0 too, nothing preempts the receive path the tick times out
+
+//ticks since HAL_SysTick_Config(), wraps around after 49 days
+extern volatile uint32_t g_systick_ticks;
+
+void HAL_SysTick_Config(void);
+uint32_t HAL_GetTick(void);
+void SysTick_Handler(void);
+
+#endif /* __HAL_SYSTICK_CONF_H */
@@ -0,0 +1,61 @@
+/*
+ * hal_systick_config.c
+ *
+ * This source file configures the SysTick timer of the Cortex-M3 core as the
+ * millisecond time base of the firmware. It includes:
+ *
+ * - Configuration of SysTick to interrupt once per millisecond from the core clock.
+ * - The tick counter and the SysTick interrupt handler, which also runs the receive
+ *   timeouts of the command line.
+ *
+ * SysTick runs at the priority of the USART2 and DMA interrupts, so the receive
+ * timeouts and the receive path never interrupt each other.
+ */
+
+#include "../inc/hal_systick_config.h"
+#include "../../HAL_ISR/UART_isr.h"
+
+//ticks since HAL_SysTick_Config(), wraps around after 49 days
+volatile uint32_t g_systick_ticks = 0;
+
+/**
+ * @brief Configures SysTick to interrupt SYSTICK_FREQUENCY_HZ times per second.
+ */
+void HAL_SysTick_Config(void)
+{
+    RCC_ClocksTypeDef clocks;
+
+    //SysTick counts core clock cycles
+    RCC_GetClocksFreq(&clocks);
+
+    g_systick_ticks = 0;
+    SysTick_Config(clocks.HCLK_Frequency / SYSTICK_FREQUENCY_HZ);
+
+    //SysTick_Config() gives the tick the lowest priority, it has to match the receive path
+    NVIC_SetPriority(SysTick_IRQn, SYSTICK_NVIC_PERIORITY);
+}
+
+/**
+ * @brief Returns the number of ticks since HAL_SysTick_Config().
+ *
+ * @return uint32_t The tick counter, differences of two values are valid across a wrap.
+ */
+uint32_t HAL_GetTick(void)
+{
+    return g_systick_ticks;
+}
+
+/**
+ * @brief SysTick Interrupt Service Routine (ISR)
+ *
+ * Counts the tick and checks whether the frame being received has stalled.
+ *
+ * @param None
+ * @retval None
+ */
+void SysTick_Handler(void)
+{
+    ++g_systick_ticks;
+
+    UART_RxTimeoutTick(g_systick_ticks);
+}
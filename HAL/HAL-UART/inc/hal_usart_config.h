@@ -0,0 +1,66 @@
+#ifndef __HAL_USART_CONF_H
+#define __HAL_USART_CONF_H
+
+#include "../../HAL-SYSTEM/inc/stm32f10x.h"
+#include "../../HAL-RCC/inc/stm32f10x_rcc.h"
+#include "stm32f10x_usart.h"
+#include "../../HAL-DMA/inc/hal_dma_config.h"
+#include "../../HAL-SYSTICK/inc/hal_systick_config.h"
+#include "../../HAL-DWT/inc/hal_dwt_config.h"
+#include "../../HAL-GPIO/inc/hal_gpio_config.h"
+#include "hal_usart_ports.h"
+#include "../../HAL-SYSTEM/inc/core_cm3.h"
+#include <string.h>
+
+
+#define USART_BAUD_RATE          (uint32_t) 9600     //rate after reset
+#define USART_NVIC_PERIORITY     (uint32_t) 0x00000000
+#define USART_OVERSAMPLING       (uint32_t) 16       //samples per bit, BRR holds PCLK / baud rate in 12.4 fixed point
+#define USART_BRR_MIN            (uint32_t) 16       //a mantissa of 1, the fastest rate is PCLK / 16 (2.25 Mbaud at 36 MHz)
+#define USART_BRR_MAX            (uint32_t) 0xFFFF
+#define USART_BAUD_MAX_ERROR_PPM (uint32_t) 15000    //1.5 %, leaves the other end its share of what the receiver tolerates
+#define USART_TC_TIMEOUT_BITS    (uint32_t) 20       //longest the transmitter takes to get done, two bytes
+#define USART_BITS_PER_CHAR      (uint32_t) 10       //start bit, 8 data bits and the stop bit
+#define USART_TX_RING_SIZE       (uint16_t) 1024     //bytes copied for transmission per USART with a session, a power of two
+#define USART_TX_SEGMENTS        (uint16_t) 32       //segments queued for transmission per USART, a power of two
+#define USART_TX_RESERVE_MAX     (uint16_t) (USART_TX_RING_SIZE / 2U)  //largest room reserved in place, always fits once the ring drains
+#define USART_TX_STALL_US        (uint32_t) 100000   //microseconds a writer waits for the transmitter to make room
+
+/**
+ * @brief A block of memory to transmit as it is, one entry of a scatter-gather list.
+ */
+struct UsartTxSegment
+{
+    const char *data;   /*first byte, not necessarily null-terminated*/
+    uint16_t length;    /*number of bytes*/
+};
+
+/**
+ * @brief Divider of a baud rate and how far the rate it produces is off.
+ */
+struct UsartBaudSetting
+{
+    uint32_t baud_rate;    /*requested rate*/
+    uint32_t actual_rate;  /*rate the divider produces*/
+    uint16_t brr;          /*value of the BRR register, the nearest divider the hardware has*/
+    int32_t  error_ppm;    /*deviation of the actual rate from the requested one, in parts per million*/
+};
+
+ErrorStatus UART_WriteSegments(USART_TypeDef *UARTx, const struct UsartTxSegment *segments, uint8_t count);
+char *UART_ReserveBuffer(USART_TypeDef *UARTx, uint16_t length);
+ErrorStatus UART_CommitBuffer(USART_TypeDef *UARTx, const char *data, uint16_t length);
+USART_TypeDef *HAL_USART_Instance(UsartPort_t port);
+char *HAL_USART_TxReserve(UsartPort_t port, uint16_t length);
+ErrorStatus HAL_USART_TxCommit(UsartPort_t port, const char *data, uint16_t length);
+ErrorStatus HAL_USART_TxSubmit(UsartPort_t port, const struct UsartTxSegment *segments, uint8_t count);
+uint16_t HAL_USART_TxFree(UsartPort_t port);
+bool HAL_USART_TxIdle(UsartPort_t port);
+void HAL_USART_TxDmaIrq(UsartPort_t port);
+void HAL_USART_TxIrq(UsartPort_t port);
+ErrorStatus HAL_USART_ComputeBaud(UsartPort_t port, uint32_t baud_rate, struct UsartBaudSetting *setting);
+ErrorStatus HAL_USART_SetBaudRate(UsartPort_t port, uint32_t baud_rate);
+uint32_t HAL_USART_GetBaudRate(UsartPort_t port);
+void HAL_USART_SetRts(UsartPort_t port, FunctionalState ready);
+void HAL_USART_Config(UsartPort_t port);
+
+#endif /* __HAL_USART_CONF_H */
@@ -0,0 +1,19 @@
+#ifndef __HAL_USART_PORTS_H
+#define __HAL_USART_PORTS_H
+
+#define USART1_COMMAND_LINE   1   //1: a command line session on USART1 (TX PA9, RX PA10), e.g. a debug console
+#define USART2_COMMAND_LINE   1   //1: a command line session on USART2 (TX PA2, RX PA3), e.g. a machine link
+#define USART3_COMMAND_LINE   0   //1: a command line session on USART3 (TX PB10, RX PB11)
+
+/**
+ * @brief USARTs a command line session can run on.
+ */
+typedef enum
+{
+    USART_PORT_1 = 0,   // USART1, clocked by APB2, received by DMA1 channel 5, transmitted by channel 4
+    USART_PORT_2,       // USART2, clocked by APB1, received by DMA1 channel 6, transmitted by channel 7
+    USART_PORT_3,       // USART3, clocked by APB1, received by DMA1 channel 3, transmitted by channel 2
+    USART_PORT_COUNT    // Number of ports
+} UsartPort_t;
+
+#endif /* __HAL_USART_PORTS_H */
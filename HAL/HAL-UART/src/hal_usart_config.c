@@ -0,0 +1,861 @@
+/*
+ * hal_usart_config.c
+ *
+ * This source file contains the implementation of functions for configuring 
+ * and initializing the USARTs a command line session runs on. It includes:
+ *
+ * - Writing buffers, strings and lists of segments to a USART for debugging and
+ *   communication, through a transmit queue per USART that its DMA1 channel sends, so
+ *   the main loop goes on while a reply is on the line.
+ * - Configuration of USART1, USART2 and USART3 parameters such as baud rate, data
+ *   format, and interrupt handling, each one independently of the others.
+ * - Precise baud rate dividers up to PCLK / 16, with the error of the produced rate,
+ *   and switching the baud rate at run time.
+ * - RTS/CTS flow control: CTS holds the transmitter in hardware, RTS is driven by software.
+ * - Reception through a DMA1 channel into a ring, with the idle-line interrupt marking
+ *   the end of every burst.
+ *
+ * The file ensures proper initialization of the USARTs and prepares them for reliable 
+ * data transmission and reception.
+ */
+
+//#include "../inc/stm32f10x_usart.h"
+//#include "../../HAL-RCC/inc/stm32f10x_rcc.h"
+#include "../../HAL-UART/inc/hal_usart_config.h"
+
+
+#define  PRIORITY_GROUP  (uint32_t)0x300
+#define  PPM             (int64_t) 1000000
+
+/**
+ * @brief A USART a command line session can run on.
+ */
+struct UsartPortHardware
+{
+    USART_TypeDef *usart;   /*the peripheral*/
+    IRQn_Type irq;          /*its interrupt*/
+    uint32_t rcc_periph;    /*its clock, on APB2 for USART1 and on APB1 for the others*/
+    bool on_apb2;           /*true if PCLK2 clocks it, PCLK1 otherwise*/
+};
+
+//the USARTs, indexed by UsartPort_t
+static const struct UsartPortHardware g_usart_ports[USART_PORT_COUNT] =
+{
+    { USART1, USART1_IRQn, RCC_APB2Periph_USART1, true },
+    { USART2, USART2_IRQn, RCC_APB1Periph_USART2, false },
+    { USART3, USART3_IRQn, RCC_APB1Periph_USART3, false },
+};
+
+//baud rate every USART runs at
+static uint32_t g_usart_baud_rates[USART_PORT_COUNT] = { USART_BAUD_RATE, USART_BAUD_RATE, USART_BAUD_RATE };
+
+/**
+ * @brief What is queued for transmission on a USART.
+ *
+ * Everything goes out as a queue of segments, each one a block of memory the DMA reads
+ * from where it is. A segment points either into memory its writer leaves unchanged
+ * until the DMA has read it (HAL_USART_TxSubmit()) or into the copy ring, which holds
+ * the bytes written in place into room reserved with HAL_USART_TxReserve(). Both kinds
+ * are sent in the order they were queued.
+ *
+ * The main loop writes the bytes and the segments and moves the heads, the DMA
+ * interrupt moves the tails; each index is written by one side only. All of them run
+ * freely and wrap around. The DMA is active exactly while segments are queued.
+ */
+struct UsartTxQueue
+{
+    char data[USART_TX_RING_SIZE];                     /*copy ring*/
+    struct UsartTxSegment segments[USART_TX_SEGMENTS];
+    volatile uint16_t head;                            /*next byte of the copy ring to write, moved by the main loop*/
+    volatile uint16_t tail;                            /*oldest byte of the copy ring not sent yet, moved by the DMA interrupt*/
+    volatile uint16_t segment_head;                    /*next segment to queue, moved by the main loop*/
+    volatile uint16_t segment_tail;                    /*segment the DMA sends, moved by the DMA interrupt*/
+    volatile bool dma_active;                          /*true while the DMA sends the segment at segment_tail*/
+    volatile bool busy;                                /*set when something is queued, cleared by TC after the last byte*/
+};
+
+#if USART1_COMMAND_LINE
+static struct UsartTxQueue g_usart1_tx_queue;
+#endif
+
+#if USART2_COMMAND_LINE
+static struct UsartTxQueue g_usart2_tx_queue;
+#endif
+
+#if USART3_COMMAND_LINE
+static struct UsartTxQueue g_usart3_tx_queue;
+#endif
+
+//the transmit queues, indexed by UsartPort_t, NULL for a USART without a command line session
+static struct UsartTxQueue *const g_usart_tx_queues[USART_PORT_COUNT] =
+{
+#if USART1_COMMAND_LINE
+    &g_usart1_tx_queue,
+#else
+    NULL,
+#endif
+#if USART2_COMMAND_LINE
+    &g_usart2_tx_queue,
+#else
+    NULL,
+#endif
+#if USART3_COMMAND_LINE
+    &g_usart3_tx_queue,
+#else
+    NULL,
+#endif
+};
+
+/**
+ * @brief Returns the port of a USART peripheral.
+ *
+ * @param UARTx Pointer to the USART peripheral.
+ * @param port Pointer that receives the port.
+ *
+ * @return true if the peripheral is one of the USARTs a command line runs on.
+ */
+static bool usart_port_of(const USART_TypeDef *UARTx, UsartPort_t *port)
+{
+    uint8_t index = 0;
+
+    for (index = 0; index < (uint8_t)USART_PORT_COUNT; ++index)
+    {
+        if (g_usart_ports[index].usart == UARTx && g_usart_tx_queues[index] != NULL)
+        {
+            *port = (UsartPort_t)index;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief Counts the segments that can be queued without waiting.
+ *
+ * @param queue Pointer to the transmit queue of the USART.
+ *
+ * @return uint16_t Free entries of the segment queue.
+ */
+static uint16_t free_segments(const struct UsartTxQueue *queue)
+{
+    return (uint16_t)(USART_TX_SEGMENTS - (uint16_t)(queue->segment_head - queue->segment_tail));
+}
+
+/**
+ * @brief Tells whether a segment points into the copy ring of a queue.
+ *
+ * @param queue Pointer to the transmit queue.
+ * @param segment Pointer to the segment.
+ *
+ * @return true if the bytes of the segment are held by the copy ring.
+ */
+static bool in_copy_ring(const struct UsartTxQueue *queue, const struct UsartTxSegment *segment)
+{
+    const uintptr_t address = (uintptr_t)segment->data;
+
+    return address >= (uintptr_t)queue->data && address < (uintptr_t)&queue->data[USART_TX_RING_SIZE];
+}
+
+/**
+ * @brief Queues bytes written into the copy ring.
+ *
+ * The bytes join the last segment if it ends where they start and the DMA has not
+ * started on it yet, so a reply written piece by piece costs few DMA interrupts.
+ *
+ * @param queue Pointer to the transmit queue.
+ * @param data First byte, in the copy ring; the bytes do not run past its end.
+ * @param length Number of bytes.
+ * @param segment_head Head of the segment queue, including segments not published yet.
+ *
+ * @return uint16_t The new head of the segment queue, unchanged if the bytes joined the last segment.
+ */
+static uint16_t queue_copied(struct UsartTxQueue *queue, const char *data, uint16_t length, uint16_t segment_head)
+{
+    struct UsartTxSegment *last = &queue->segments[(uint16_t)(segment_head - 1U) & (USART_TX_SEGMENTS - 1U)];
+    uint32_t primask = 0;
+    bool appended = false;
+
+    //the DMA interrupt must not start the last segment while it grows
+    primask = __get_PRIMASK();
+    __disable_irq();
+
+    //the last segment waits behind the one the DMA sends and ends where the new bytes start
+    if ((uint16_t)(segment_head - queue->segment_tail) >= 2U && in_copy_ring(queue, last) &&
+        last->data + last->length == data)
+    {
+        __DMB();
+        last->length = (uint16_t)(last->length + length);
+        appended = true;
+    }
+
+    __set_PRIMASK(primask);
+
+    if (!appended)
+    {
+        queue->segments[segment_head & (USART_TX_SEGMENTS - 1U)].data = data;
+        queue->segments[segment_head & (USART_TX_SEGMENTS - 1U)].length = length;
+        ++segment_head;
+    }
+
+    return segment_head;
+}
+
+/**
+ * @brief Hands the segment at the tail of the queue to the DMA.
+ *
+ * Called with interrupts masked or from the DMA interrupt. TC is cleared first: DMA
+ * writes to DR do not clear it, and it must only tell the end of the last segment.
+ *
+ * @param port The USART.
+ */
+static void start_segment(UsartPort_t port)
+{
+    struct UsartTxQueue *queue = g_usart_tx_queues[port];
+    const struct UsartTxSegment *segment = &queue->segments[queue->segment_tail & (USART_TX_SEGMENTS - 1U)];
+
+    USART_ClearFlag(g_usart_ports[port].usart, USART_FLAG_TC);
+    queue->dma_active = true;
+    HAL_DMA_USART_TxStart(port, segment->data, segment->length);
+}
+
+/**
+ * @brief Publishes the segments queued up to a new head and starts the DMA if it is idle.
+ *
+ * @param port The USART.
+ * @param segment_head The new head of the segment queue.
+ */
+static void publish_segments(UsartPort_t port, uint16_t segment_head)
+{
+    struct UsartTxQueue *queue = g_usart_tx_queues[port];
+    uint32_t primask = 0;
+
+    //release: the segments and their bytes are written before the interrupt can see them
+    __DMB();
+
+    //the DMA interrupt starts segments as well, the two must not race
+    primask = __get_PRIMASK();
+    __disable_irq();
+
+    queue->segment_head = segment_head;
+    queue->busy = true;
+
+    if (!queue->dma_active && queue->segment_tail != segment_head)
+    {
+        //a TC interrupt still waited for would end the transmission early
+        USART_ITConfig(g_usart_ports[port].usart, USART_IT_TC, DISABLE);
+        start_segment(port);
+    }
+
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief Reserves room in the copy ring of a USART to write a reply into, without waiting.
+ *
+ * The room is contiguous, so a formatter can write into it as into any buffer, and
+ * nothing has to be copied once it is done. If the bytes left before the end of the
+ * ring are too few, the room starts at the beginning of the ring and those bytes stay
+ * unused. Nothing is queued until HAL_USART_TxCommit(); a reservation that is never
+ * committed costs nothing, and nothing else may be queued on the USART in between.
+ *
+ * @param port The USART.
+ * @param length Bytes to reserve, 1..USART_TX_RESERVE_MAX; the most the reply can take.
+ *
+ * @return char* First byte of the room, NULL if the queue has no room for it now or the
+ *         input is invalid.
+ */
+char *HAL_USART_TxReserve(UsartPort_t port, uint16_t length)
+{
+    char *outcome = NULL;
+    struct UsartTxQueue *queue = NULL;
+    uint16_t start = 0;
+    uint16_t to_end = 0;
+    uint16_t room = 0;
+
+    if (port < USART_PORT_COUNT && g_usart_tx_queues[port] && length > 0 && length <= USART_TX_RESERVE_MAX &&
+        free_segments(g_usart_tx_queues[port]) > 0)
+    {
+        queue = g_usart_tx_queues[port];
+        start = queue->head & (USART_TX_RING_SIZE - 1U);
+        to_end = (uint16_t)(USART_TX_RING_SIZE - start);
+        room = HAL_USART_TxFree(port);
+
+        if (length <= to_end && length <= room)
+        {
+            outcome = &queue->data[start];
+        }
+        else if (length > to_end && room >= to_end + length)
+        {
+            outcome = queue->data;
+        }
+    }
+
+    return outcome;
+}
+
+/**
+ * @brief Queues the bytes written into room reserved with HAL_USART_TxReserve().
+ *
+ * @param port The USART.
+ * @param data The room HAL_USART_TxReserve() returned.
+ * @param length Bytes written into it, at most the bytes reserved; 0 gives the room back.
+ *
+ * @return SUCCESS if the bytes are queued, ERROR if data does not point into the copy
+ *         ring of the USART.
+ */
+ErrorStatus HAL_USART_TxCommit(UsartPort_t port, const char *data, uint16_t length)
+{
+    ErrorStatus outcome = ERROR;
+    struct UsartTxQueue *queue = NULL;
+    const struct UsartTxSegment reserved = { data, length };
+    uint16_t offset = 0;
+    uint16_t segment_head = 0;
+
+    if (port < USART_PORT_COUNT && g_usart_tx_queues[port] && data && in_copy_ring(g_usart_tx_queues[port], &reserved))
+    {
+        queue = g_usart_tx_queues[port];
+        offset = (uint16_t)(data - queue->data);
+        outcome = SUCCESS;
+
+        if (length > 0 && offset + length <= USART_TX_RING_SIZE)
+        {
+            //the head moves past the bytes a reservation at the beginning of the ring left unused
+            queue->head = (uint16_t)(queue->head + ((uint16_t)(offset - queue->head) & (USART_TX_RING_SIZE - 1U)) +
+                                     length);
+
+            segment_head = queue_copied(queue, data, length, queue->segment_head);
+
+            if (segment_head != queue->segment_head)
+            {
+                publish_segments(port, segment_head);
+            }
+        }
+        else if (length > 0)
+        {
+            outcome = ERROR;
+        }
+    }
+
+    return outcome;
+}
+
+/**
+ * @brief Queues segments for transmission without copying them and without waiting.
+ *
+ * The DMA reads every segment from where it is, so its bytes must stay unchanged until
+ * they have been sent. Constant strings can be sent this way at no cost. Empty
+ * segments are skipped.
+ *
+ * @param port The USART.
+ * @param segments The segments, sent in this order.
+ * @param count Number of segments.
+ *
+ * @return SUCCESS if all segments are queued, ERROR if the queue has no room for all of
+ *         them or the input is invalid, in which case none is queued.
+ */
+ErrorStatus HAL_USART_TxSubmit(UsartPort_t port, const struct UsartTxSegment *segments, uint8_t count)
+{
+    ErrorStatus outcome = ERROR;
+    struct UsartTxQueue *queue = NULL;
+    uint16_t segment_head = 0;
+    uint8_t index = 0;
+
+    if (segments && port < USART_PORT_COUNT && g_usart_tx_queues[port] && count <= free_segments(g_usart_tx_queues[port]))
+    {
+        queue = g_usart_tx_queues[port];
+        segment_head = queue->segment_head;
+
+        for (index = 0; index < count; ++index)
+        {
+            if (segments[index].data != NULL && segments[index].length > 0)
+            {
+                queue->segments[segment_head & (USART_TX_SEGMENTS - 1U)] = segments[index];
+                ++segment_head;
+            }
+        }
+
+        publish_segments(port, segment_head);
+        outcome = SUCCESS;
+    }
+
+    return outcome;
+}
+
+/**
+ * @brief Returns how many bytes of the copy ring of a USART are free.
+ *
+ * @param port The USART.
+ *
+ * @return uint16_t Free bytes in the copy ring.
+ */
+uint16_t HAL_USART_TxFree(UsartPort_t port)
+{
+    const struct UsartTxQueue *queue = g_usart_tx_queues[port];
+
+    return (uint16_t)(USART_TX_RING_SIZE - (uint16_t)(queue->head - queue->tail));
+}
+
+/**
+ * @brief Tells whether a USART has sent everything queued on it.
+ *
+ * @param port The USART.
+ *
+ * @return true once the last queued byte has left the transmitter, including its stop bit.
+ */
+bool HAL_USART_TxIdle(UsartPort_t port)
+{
+    return !g_usart_tx_queues[port]->busy;
+}
+
+/**
+ * @brief Handles the full transfer interrupt of the transmit channel of a USART.
+ *
+ * The DMA has handed the last byte of the segment to the USART. The next segment is
+ * started at once; after the last one TC is waited for, which fires when the last byte
+ * has left the shift register.
+ *
+ * @param port The USART.
+ */
+void HAL_USART_TxDmaIrq(UsartPort_t port)
+{
+    struct UsartTxQueue *queue = g_usart_tx_queues[port];
+    const uint16_t tail = queue->segment_tail;
+    const struct UsartTxSegment *segment = &queue->segments[tail & (USART_TX_SEGMENTS - 1U)];
+
+    HAL_DMA_USART_TxClearFlags(port);
+
+    if (!queue->dma_active)
+    {
+        return;
+    }
+
+    //the bytes of the copy ring can be overwritten once the DMA has read them, and so can
+    //the bytes a reservation at the beginning of the ring left unused before the segment
+    if (in_copy_ring(queue, segment))
+    {
+        queue->tail = (uint16_t)(queue->tail +
+                                 ((uint16_t)((uint16_t)(segment->data - queue->data) - queue->tail) &
+                                  (USART_TX_RING_SIZE - 1U)) + segment->length);
+    }
+
+    queue->segment_tail = (uint16_t)(tail + 1U);
+
+    if (queue->segment_tail != queue->segment_head)
+    {
+        //acquire: the segment is read after the main loop has published it
+        __DMB();
+        start_segment(port);
+    }
+    else
+    {
+        queue->dma_active = false;
+        USART_ITConfig(g_usart_ports[port].usart, USART_IT_TC, ENABLE);
+    }
+}
+
+/**
+ * @brief Handles the transmission complete interrupt of a USART, called from its interrupt handler.
+ *
+ * @param port The USART.
+ */
+void HAL_USART_TxIrq(UsartPort_t port)
+{
+    struct UsartTxQueue *queue = g_usart_tx_queues[port];
+    USART_TypeDef *usart = g_usart_ports[port].usart;
+
+    if (USART_GetITStatus(usart, USART_IT_TC) == SET)
+    {
+        //TC stays set, so the transmitter reads idle until the next segment starts
+        USART_ITConfig(usart, USART_IT_TC, DISABLE);
+        queue->busy = false;
+    }
+}
+
+/**
+ * @brief Sleeps until the transmitter of a USART has made room, called by writers that wait.
+ *
+ * The deadline is moved on whenever the DMA has finished a segment, so only a
+ * transmitter that stalls gives up, however long the whole wait takes.
+ *
+ * @param port The USART.
+ * @param deadline Pointer to the deadline, started with USART_TX_STALL_US.
+ * @param segment_tail Pointer to the tail of the segment queue when the transmitter last made progress.
+ *
+ * @return false if the transmitter has made no progress for USART_TX_STALL_US,
+ *         e.g. because CTS holds it.
+ */
+static bool wait_for_room(UsartPort_t port, struct HalDeadline *deadline, uint16_t *segment_tail)
+{
+    const uint16_t tail = g_usart_tx_queues[port]->segment_tail;
+
+    if (tail != *segment_tail)
+    {
+        *segment_tail = tail;
+        HAL_DeadlineRestart(deadline);
+    }
+    else if (HAL_DeadlineExpired(deadline))
+    {
+        return false;
+    }
+
+    //the next DMA or SysTick interrupt wakes the core up
+    __WFI();
+
+    return true;
+}
+
+/**
+ * @brief Transmits a list of segments via the specified UART interface without copying them.
+ *
+ * The segments are queued for the DMA, which reads them from where they are, and the
+ * call returns once they are queued. Their bytes must stay unchanged until they have
+ * been sent, which constant strings always do. If the queue has no room for all
+ * segments the call sleeps until the DMA has made room, and gives up if the
+ * transmitter makes no progress for USART_TX_STALL_US.
+ *
+ * @param UARTx Pointer to the USART peripheral (e.g., USART1, USART2).
+ * @param segments The segments, sent in this order.
+ * @param count Number of segments, at most USART_TX_SEGMENTS.
+ *
+ * @return SUCCESS if the segments are queued, ERROR otherwise.
+ */
+ErrorStatus UART_WriteSegments(USART_TypeDef *UARTx, const struct UsartTxSegment *segments, uint8_t count)
+{
+    ErrorStatus outcome = ERROR;
+    UsartPort_t port = USART_PORT_2;
+    struct HalDeadline deadline;
+    uint16_t segment_tail = 0;
+
+    //validate input parameters
+    if (segments && UARTx && count <= USART_TX_SEGMENTS && usart_port_of(UARTx, &port))
+    {
+        HAL_DeadlineStart(&deadline, USART_TX_STALL_US);
+        segment_tail = g_usart_tx_queues[port]->segment_tail;
+
+        while ((outcome = HAL_USART_TxSubmit(port, segments, count)) != SUCCESS)
+        {
+            if (!wait_for_room(port, &deadline, &segment_tail))
+            {
+                break;
+            }
+        }
+    }
+
+    return outcome;
+}
+
+/**
+ * @brief Reserves room in the transmit queue of the specified UART interface to write a reply into.
+ *
+ * Sleeps until the DMA has made room if there is none, and gives up if the transmitter
+ * makes no progress for USART_TX_STALL_US. The bytes written into the room are
+ * queued with UART_CommitBuffer(), see HAL_USART_TxReserve().
+ *
+ * @param UARTx Pointer to the USART peripheral (e.g., USART1, USART2).
+ * @param length Bytes to reserve, 1..USART_TX_RESERVE_MAX.
+ *
+ * @return char* First byte of the room, NULL on timeout or invalid input.
+ */
+char *UART_ReserveBuffer(USART_TypeDef *UARTx, uint16_t length)
+{
+    char *outcome = NULL;
+    UsartPort_t port = USART_PORT_2;
+    struct HalDeadline deadline;
+    uint16_t segment_tail = 0;
+
+    //validate input parameters
+    if (UARTx && length > 0 && length <= USART_TX_RESERVE_MAX && usart_port_of(UARTx, &port))
+    {
+        HAL_DeadlineStart(&deadline, USART_TX_STALL_US);
+        segment_tail = g_usart_tx_queues[port]->segment_tail;
+
+        while ((outcome = HAL_USART_TxReserve(port, length)) == NULL)
+        {
+            if (!wait_for_room(port, &deadline, &segment_tail))
+            {
+                break;
+            }
+        }
+    }
+
+    return outcome;
+}
+
+/**
+ * @brief Transmits the bytes written into room reserved with UART_ReserveBuffer().
+ *
+ * @param UARTx Pointer to the USART peripheral the room was reserved on.
+ * @param data The room UART_ReserveBuffer() returned.
+ * @param length Bytes written into it, at most the bytes reserved.
+ *
+ * @return SUCCESS if the bytes are queued, ERROR otherwise.
+ */
+ErrorStatus UART_CommitBuffer(USART_TypeDef *UARTx, const char *data, uint16_t length)
+{
+    ErrorStatus outcome = ERROR;
+    UsartPort_t port = USART_PORT_2;
+
+    //validate input parameters
+    if (UARTx && usart_port_of(UARTx, &port))
+    {
+        outcome = HAL_USART_TxCommit(port, data, length);
+    }
+
+    return outcome;
+}
+
+/**
+ * @brief Returns the USART peripheral of a port.
+ *
+ * @param port The port.
+ *
+ * @return USART_TypeDef* Pointer to the USART peripheral.
+ */
+USART_TypeDef *HAL_USART_Instance(UsartPort_t port)
+{
+    return g_usart_ports[port].usart;
+}
+
+/**
+ * @brief Computes the divider of a baud rate and the error of the rate it produces.
+ *
+ * BRR holds PCLK / baud rate in 12.4 fixed point, i.e. the divider in sixteenths of
+ * the sampling clock, so it is rounded to the nearest integer. A rate the divider
+ * cannot reach is given the nearest divider the hardware has, so the error tells how
+ * far off it is.
+ *
+ * @param port The USART the divider is computed for, USART1 runs from a faster clock.
+ * @param baud_rate Requested rate in bits per second.
+ * @param setting Pointer to the structure that receives the divider and its error.
+ *
+ * @return SUCCESS if the produced rate is within USART_BAUD_MAX_ERROR_PPM of the
+ *         requested one, ERROR otherwise.
+ */
+ErrorStatus HAL_USART_ComputeBaud(UsartPort_t port, uint32_t baud_rate, struct UsartBaudSetting *setting)
+{
+    ErrorStatus outcome = ERROR;
+    RCC_ClocksTypeDef clocks;
+    uint32_t pclk = 0;
+    uint32_t brr = USART_BRR_MIN;
+
+    //validate input parameters
+    if (setting && baud_rate > 0 && port < USART_PORT_COUNT)
+    {
+        //USART1 is clocked by APB2, the others by APB1
+        RCC_GetClocksFreq(&clocks);
+        pclk = g_usart_ports[port].on_apb2 ? clocks.PCLK2_Frequency : clocks.PCLK1_Frequency;
+
+        brr = (pclk + (baud_rate / 2U)) / baud_rate;
+
+        if (brr < USART_BRR_MIN)
+        {
+            brr = USART_BRR_MIN;
+        }
+        else if (brr > USART_BRR_MAX)
+        {
+            brr = USART_BRR_MAX;
+        }
+
+        setting->baud_rate   = baud_rate;
+        setting->brr         = (uint16_t) brr;
+        setting->actual_rate = (pclk + (brr / 2U)) / brr;
+        setting->error_ppm   = (int32_t)((((int64_t)setting->actual_rate - (int64_t)baud_rate) * PPM) / (int64_t)baud_rate);
+
+        if (setting->error_ppm <= (int32_t)USART_BAUD_MAX_ERROR_PPM &&
+            setting->error_ppm >= -(int32_t)USART_BAUD_MAX_ERROR_PPM)
+        {
+            outcome = SUCCESS;
+        }
+    }
+
+    return outcome;
+}
+
+/**
+ * @brief Counts the bytes queued on a USART that the DMA has not read yet.
+ *
+ * @param port The USART.
+ *
+ * @return uint32_t The bytes of every queued segment, those of the one being sent included.
+ */
+static uint32_t queued_bytes(UsartPort_t port)
+{
+    const struct UsartTxQueue *queue = g_usart_tx_queues[port];
+    uint32_t outcome = 0;
+    uint16_t index = 0;
+
+    for (index = queue->segment_tail; index != queue->segment_head; ++index)
+    {
+        outcome += queue->segments[index & (USART_TX_SEGMENTS - 1U)].length;
+    }
+
+    return outcome;
+}
+
+/**
+ * @brief Switches a USART to another baud rate.
+ *
+ * Waits until every queued byte has left the transmitter, so a reply sent at the old
+ * rate is not cut off; callers that must not wait check HAL_USART_TxIdle() first. The
+ * divider must not change while the USART is enabled, so it is disabled for the switch;
+ * the DMA reception goes on where it was.
+ *
+ * @param port The USART to switch.
+ * @param baud_rate New rate in bits per second.
+ *
+ * @return SUCCESS if the USART runs at the new rate, ERROR if the rate can not be reached
+ *         precisely enough or the transmitter does not get done, in which case the rate
+ *         is not changed.
+ */
+ErrorStatus HAL_USART_SetBaudRate(UsartPort_t port, uint32_t baud_rate)
+{
+    ErrorStatus outcome = ERROR;
+    struct UsartBaudSetting setting;
+    USART_TypeDef *usart = NULL;
+    struct HalDeadline deadline;
+    uint32_t bits = 0;
+
+    if (HAL_USART_ComputeBaud(port, baud_rate, &setting) == SUCCESS)
+    {
+        outcome = SUCCESS;
+        usart = g_usart_ports[port].usart;
+
+        //the queued bytes and the ones in the transmitter
+        bits = queued_bytes(port) * USART_BITS_PER_CHAR + USART_TC_TIMEOUT_BITS;
+
+        //time the transmitter may take at the current rate, rounded up to the next microsecond
+        HAL_DeadlineStart(&deadline, (uint32_t)(((uint64_t)bits * DWT_US_PER_S + g_usart_baud_rates[port] - 1U) /
+                                                g_usart_baud_rates[port]));
+
+        // Wait until the transmission is complete or timeout occurs
+        while (!HAL_USART_TxIdle(port))
+        {
+            if (HAL_DeadlineExpired(&deadline))
+            {
+                outcome = ERROR;
+                break;
+            }
+
+            //the DMA, TC or SysTick interrupt wakes the core up
+            __WFI();
+        }
+    }
+
+    if (outcome == SUCCESS)
+    {
+        USART_Cmd(usart, DISABLE);
+        usart->BRR = setting.brr;
+        USART_Cmd(usart, ENABLE);
+
+        g_usart_baud_rates[port] = baud_rate;
+    }
+
+    return outcome;
+}
+
+/**
+ * @brief Returns the baud rate a USART runs at.
+ *
+ * @param port The USART.
+ *
+ * @return uint32_t The rate in bits per second.
+ */
+uint32_t HAL_USART_GetBaudRate(UsartPort_t port)
+{
+    return g_usart_baud_rates[port];
+}
+
+/**
+ * @brief Tells the sender on a USART whether its command line can take more bytes.
+ *
+ * RTS is active low. Without flow control on the port the pin is not used.
+ *
+ * @param port The USART.
+ * @param ready ENABLE to let the sender go on, DISABLE to stop it.
+ */
+void HAL_USART_SetRts(UsartPort_t port, FunctionalState ready)
+{
+    const struct UsartPins *pins = &g_usart_pins[port];
+
+    if (!pins->flow_control)
+    {
+        return;
+    }
+
+    if (ready == ENABLE)
+    {
+        GPIO_ResetBits(pins->gpio, pins->rts_pin);
+    }
+    else
+    {
+        GPIO_SetBits(pins->gpio, pins->rts_pin);
+    }
+}
+
+/**
+ * @brief Configures and initializes a USART for communication.
+ *        Sets baud rate, data format, DMA reception and enables interrupts.
+ *
+ * @param port The USART to configure, its pins are configured by HAL_GPIO_Config().
+ */
+void HAL_USART_Config(UsartPort_t port)
+{
+    USART_InitTypeDef USART_Config;
+    struct UsartBaudSetting baud_setting;
+    const struct UsartPortHardware *hardware = &g_usart_ports[port];
+
+    //enable clock for the USART to prepare it for initialization
+    if (hardware->on_apb2)
+    {
+        RCC_APB2PeriphClockCmd(hardware->rcc_periph, ENABLE);
+    }
+    else
+    {
+        RCC_APB1PeriphClockCmd(hardware->rcc_periph, ENABLE);
+    }
+
+    //configure the USART parameters
+    USART_Config.USART_BaudRate            = USART_BAUD_RATE;           // Set baud rate (defined elsewhere)
+    USART_Config.USART_HardwareFlowControl = g_usart_pins[port].flow_control ?
+                                             USART_HardwareFlowControl_CTS :   // CTS holds the transmitter, RTS is driven by software
+                                             USART_HardwareFlowControl_None;   // No hardware flow control
+    USART_Config.USART_Mode                = USART_Mode_Tx | USART_Mode_Rx;  // Enable both TX and RX modes
+    USART_Config.USART_Parity              = USART_Parity_No;           // No parity check
+    USART_Config.USART_StopBits            = USART_StopBits_1;          // Use 1 stop bit
+    USART_Config.USART_WordLength          = USART_WordLength_8b;       // 8-bit word length
+    USART_Init(hardware->usart, &USART_Config);                         // Initialize the USART with the configuration
+
+    //the divider is computed once, the same way for the reset rate and for a switch
+    if (HAL_USART_ComputeBaud(port, USART_BAUD_RATE, &baud_setting) == SUCCESS)
+    {
+        hardware->usart->BRR = baud_setting.brr;
+    }
+    g_usart_baud_rates[port] = USART_BAUD_RATE;
+
+    //the DMA moves every received byte into the receive ring, the CPU is only
+    //interrupted when the line goes idle after a burst
+    HAL_DMA_USART_RxConfig(port, hardware->usart);
+    USART_DMACmd(hardware->usart, USART_DMAReq_Rx, ENABLE);
+    USART_ITConfig(hardware->usart, USART_IT_IDLE, ENABLE);
+
+    //with DMA reception ERR raises the interrupt on an overrun, framing or noise error, PE on a parity error
+    USART_ITConfig(hardware->usart, USART_IT_ERR, ENABLE);
+    USART_ITConfig(hardware->usart, USART_IT_PE, ENABLE);
+
+    //the DMA sends the transmit queue, TC tells when the last byte has left the line
+    memset(g_usart_tx_queues[port], 0, sizeof(*g_usart_tx_queues[port]));
+    HAL_DMA_USART_TxConfig(port, hardware->usart);
+    USART_DMACmd(hardware->usart, USART_DMAReq_Tx, ENABLE);
+
+    //configure NVIC for the USART interrupts
+    NVIC_SetPriorityGrouping(PRIORITY_GROUP); //set priority grouping
+    NVIC_SetPriority(hardware->irq, USART_NVIC_PERIORITY); //Set interrupt priority
+    NVIC_EnableIRQ(hardware->irq);                   //enable the USART interrupt in NVIC
+
+    //enable the USART for communication
+    USART_Cmd(hardware->usart, ENABLE);
+
+    //let the sender go
+    HAL_USART_SetRts(port, ENABLE);
+}
@@ -2,82 +2,228 @@
 #include "UART_isr.h"
 
 /**
- * @brief Initialize a new message by allocating memory for the raw buffer.
+ * @brief Returns the command the frame being received has got to, if it is a known one.
  *
- * @param mem_blocks Number of memory blocks to allocate
- * @param char_index Pointer to the character index
- * @param received_char First character of the new message
+ * For an XML frame it is the last command the tokenizer has seen closed by </CMD>,
+ * for a binary frame the command id, once it has been decoded.
  *
- * @retval bool True if the ISR should exit, False to continue processing
+ * @param port Pointer to the command line port the frame is received on
+ *
+ * @retval uint8_t Index of the command in the command list, COMMAND_COUNT or above if none is known
  */
-bool start_new_message(uint32_t mem_blocks, uint32_t *char_index, char received_char)
+static uint8_t received_command(const struct CommandLinePort *port)
 {
-    bool exit_isr = false;  // Flag to track if ISR should exit early
+    const struct FrameSlot *slot = port->rx.slot;
+    const struct FrameLayout *layout = NULL;
+    uint8_t command = NO_COMMAND_FOUND;
 
-    // Validate parameters
-    if (char_index == NULL || mem_blocks == 0)
+    // A dropped frame never had a slot
+    if (slot == NULL)
     {
-        exit_isr = true; // Exit ISR due to invalid input
+        return command;
+    }
+
+    if (port->rx.format == FRAME_FORMAT_BINARY)
+    {
+        // The command id is the first byte of the payload
+        if (port->rx.binary_decoder.length > 0 && (uint8_t)slot->data[0] < COMMAND_COUNT)
+        {
+            command = (uint8_t)slot->data[0];
+        }
     }
     else
     {
-        // Attempt to allocate memory for the raw UART buffer
-        g_uart_xml_raw_buffer = (char *)MemoryPool_AllocatePages(mem_blocks);
+        layout = &slot->tokenizer.layout;
 
-        if (g_uart_xml_raw_buffer)
+        // The commands of a batch that is too long are not recorded beyond the last one that fits
+        if (!layout->cmd_overflow && layout->cmd_count > 0)
         {
-            // Clear the allocated buffer
-            memset(g_uart_xml_raw_buffer, 0, sizeof(*g_uart_xml_raw_buffer));
+            command = find_command_in_list(&slot->data[layout->cmds[layout->cmd_count - 1].name_offset],
+                                           layout->cmds[layout->cmd_count - 1].name_length);
+        }
+    }
 
-            // Store the first received character in the buffer
-            g_uart_xml_raw_buffer[(*char_index)++] = received_char;
+    return command;
+}
 
-            // Null-terminate the string
-            g_uart_xml_raw_buffer[*char_index] = '\0';
-        }
-        else
+/**
+ * @brief Queues the error reply of the frame being received for the main loop to send.
+ *
+ * The reply takes the next frame number, so the main loop answers it in the order
+ * the frames ended.
+ *
+ * @param port Pointer to the command line port the frame is received on
+ * @param status Parser status the frame is rejected with
+ *
+ * @retval None
+ */
+static void queue_reply(struct CommandLinePort *port, uint8_t status)
+{
+    struct PendingReply reply;
+
+    reply.format = port->rx.format;
+    reply.status = status;
+    reply.command = received_command(port);
+    reply.sequence = port->rx.sequence++;
+
+    // The main loop sends the reply, transmitting here would block the ISR
+    (void)reply_queue_push(&port->replies, &reply);
+}
+
+/**
+ * @brief Rejects the frame being received and queues its error reply.
+ *
+ * The slot is given back for the next frame at once. If the frame has not ended yet, the
+ * rest of it is skipped without a slot, up to its </UCL> or its closing delimiter.
+ *
+ * @param port Pointer to the command line port the frame is received on
+ * @param status Parser status the frame is rejected with
+ * @param frame_ended true if the rejected byte was the last one of the frame
+ * @param char_index Pointer to the character index
+ *
+ * @retval None
+ */
+static void reject_frame(struct CommandLinePort *port, uint8_t status, bool frame_ended, uint32_t *char_index)
+{
+    queue_reply(port, status);
+
+    reset_buffer_state(port, char_index);
+
+    if (!frame_ended)
+    {
+        port->rx.discarding = true;
+        tag_matcher_reset(&port->rx.discard_matcher);
+    }
+}
+
+/**
+ * @brief Drops a frame that starts while every slot of the frame ring is in use.
+ *
+ * The frame is counted and skipped up to its end, so the rest of it is not taken for
+ * a new frame once a slot is free again. With FRAME_RING_BUSY_NAK the sender is told
+ * to send the frame again.
+ *
+ * @param port Pointer to the command line port the frame is received on
+ * @param received_char The first character of the frame
+ *
+ * @retval None
+ */
+static void drop_frame(struct CommandLinePort *port, char received_char)
+{
+    // Only the start of a frame can be dropped as a whole, line noise is dropped byte by byte
+    if (received_char != '<' && (uint8_t)received_char != BINARY_FRAME_DELIMITER)
+    {
+        return;
+    }
+
+    port->rx.format = ((uint8_t)received_char == BINARY_FRAME_DELIMITER) ? FRAME_FORMAT_BINARY : FRAME_FORMAT_XML;
+    ++port->frames.dropped;
+
+#if FRAME_RING_BUSY_NAK
+    queue_reply(port, FRAME_BUSY);
+#endif
+
+    port->rx.discarding = true;
+    tag_matcher_reset(&port->rx.discard_matcher);
+}
+
+/**
+ * @brief Skips one byte of a rejected frame.
+ *
+ * @param port Pointer to the command line port the frame is received on
+ * @param received_char The character received from UART
+ *
+ * @retval None
+ */
+static void discard_received_char(struct CommandLinePort *port, char received_char)
+{
+    struct TagMatch match;
+
+    if (port->rx.format == FRAME_FORMAT_BINARY)
+    {
+        // The next delimiter ends the rejected binary frame
+        port->rx.discarding = ((uint8_t)received_char != BINARY_FRAME_DELIMITER);
+    }
+    else if (tag_matcher_feed(&port->rx.discard_matcher, received_char, 0, &match) &&
+             match.tag == FRAME_TAG_UCL && match.kind_of_tag == CLOSE_TAG)
+    {
+        // The closing parent tag ends the rejected XML frame
+        port->rx.discarding = false;
+    }
+}
+
+/**
+ * @brief Checks the command that has just been closed by </CMD>.
+ *
+ * @param port Pointer to the command line port the frame is received on
+ * @param char_index Pointer to the character index
+ *
+ * @retval bool True if the frame was rejected, False if it is still valid
+ */
+static bool check_received_command(struct CommandLinePort *port, uint32_t *char_index)
+{
+    const struct FrameLayout *layout = &port->rx.slot->tokenizer.layout;
+    const struct FrameCommand *command = NULL;
+    bool rejected = false;
+
+    if (layout->cmd_overflow)
+    {
+        rejected = true;
+        reject_frame(port, TOO_MANY_COMMANDS, false, char_index);
+    }
+    else if (layout->cmd_count > 0)
+    {
+        command = &layout->cmds[layout->cmd_count - 1];
+
+        // The perfect hash lookup costs the same as in the parser, there is no reason to wait
+        if (find_command_in_list(&port->rx.slot->data[command->name_offset], command->name_length) >= COMMAND_COUNT)
         {
-            // Memory allocation failed; reset state
-            *char_index = 0;
-            exit_isr = true; // Exit ISR due to memory allocation failure
+            rejected = true;
+            reject_frame(port, NO_COMMAND_FOUND, false, char_index);
         }
     }
 
-    return exit_isr;
+    return rejected;
 }
 
-
 /**
- * @brief Validate the presence of the parent tag in the received XML string.
+ * @brief Initialize a new message in the free slot of the frame ring.
  *
- * @param mem_blocks Number of memory blocks allocated
+ * @param port Pointer to the command line port the frame is received on
  * @param char_index Pointer to the character index
  *
  * @retval bool True if the ISR should exit, False to continue processing
  */
-bool validate_parent_tag(uint32_t mem_blocks, uint32_t *char_index)
+bool start_new_message(struct CommandLinePort *port, uint32_t *char_index)
 {
     bool exit_isr = false;  // Flag to track if ISR should exit early
 
     // Validate parameters
-    if (char_index == NULL || mem_blocks == 0)
+    if (char_index == NULL)
     {
         exit_isr = true; // Exit ISR due to invalid input
     }
     else
     {
-        // Check if the opening <UCL> tag exists in the buffer
-        if (find_tag_location(g_uart_xml_raw_buffer, XML_PARENT_TAG, OPEN_TAG) == NULL)
+        // The frame is received straight into the slot the main loop will read it from
+        port->rx.slot = frame_ring_acquire_write(&port->frames);
+
+        if (port->rx.slot)
         {
-            // Free memory if the tag is not found
-            if (g_uart_xml_raw_buffer)
-            {
-                MemoryPool_FreePages((char *)g_uart_xml_raw_buffer, mem_blocks);
-            }
+            port->rx.slot->data[0] = '\0';
+
+            // Prepare the tokenizer and the binary decoder for the new frame
+            frame_tokenizer_reset(&port->rx.slot->tokenizer);
+            binary_frame_reset(&port->rx.binary_decoder);
+            port->rx.format = FRAME_FORMAT_XML;
 
-            // Reset the character index
             *char_index = 0;
-            exit_isr = true; // Exit ISR due to invalid parent tag
+        }
+        else
+        {
+            // Every slot waits for the main loop; reset state
+            *char_index = 0;
+            exit_isr = true; // Exit ISR, the byte is dropped
         }
     }
 
@@ -85,190 +231,633 @@ bool validate_parent_tag(uint32_t mem_blocks, uint32_t *char_index)
 }
 
 /**
- * @brief Process each received character and check for message completeness.
+ * @brief Hands a complete frame over to the main loop.
+ *
+ * @param port Pointer to the command line port the frame is received on
+ * @param length Number of bytes of the frame in the slot
+ * @param char_index Pointer to the character index
+ *
+ * @retval None
+ */
+static void hand_over_frame(struct CommandLinePort *port, uint16_t length, uint32_t *char_index)
+{
+    // Publish the slot, the next frame is received into the next slot
+    process_complete_message(port, length);
+
+    // Reset the character index
+    *char_index = 0;
+}
+
+/**
+ * @brief Process one byte of a binary frame.
+ *
+ * The byte is COBS-decoded in place into the slot; the delimiter that follows the
+ * payload completes the frame.
  *
+ * @param port Pointer to the command line port the frame is received on
  * @param received_char The character received from UART
  * @param char_index Pointer to the character index
- * @param mem_blocks Number of memory blocks allocated
  *
  * @retval None
  */
-void process_received_char(char received_char, uint32_t *char_index, uint32_t mem_blocks)
+static void process_received_binary_char(struct CommandLinePort *port, char received_char, uint32_t *char_index)
 {
-    bool exit_isr = false;  // Flag to track if ISR should exit early
+    Binary_Frame_Status_t decoder_status = BINARY_FRAME_IN_PROGRESS;
 
-    // Validate parameters
-    if (char_index == NULL || mem_blocks == 0)
+    // Keep one byte for the null terminator the frame gets
+    decoder_status = binary_frame_feed(&port->rx.binary_decoder, (uint8_t)received_char,
+                                       (uint8_t *)port->rx.slot->data, (uint16_t)(FRAME_SLOT_SIZE - 1U));
+    ++(*char_index);
+
+    if (decoder_status == BINARY_FRAME_COMPLETE)
     {
-        exit_isr = true; // Exit ISR due to invalid input
+        hand_over_frame(port, port->rx.binary_decoder.length, char_index);
     }
-    else
+    // Idle fill between frames, keep waiting for a payload
+    else if (decoder_status == BINARY_FRAME_EMPTY)
+    {
+        binary_frame_reset(&port->rx.binary_decoder);
+        *char_index = 1;
+    }
+    // Reject frames with a broken encoding, the rest of the frame is skipped
+    else if (decoder_status == BINARY_FRAME_BAD)
     {
-        // Store the received character in the buffer
-        g_uart_xml_raw_buffer[(*char_index)++] = received_char;
+        reject_frame(port, BAD_XML, ((uint8_t)received_char == BINARY_FRAME_DELIMITER), char_index);
+    }
+}
 
-        // Null-terminate the string
-        g_uart_xml_raw_buffer[*char_index] = '\0';
+/**
+ * @brief Drops line noise in front of a frame without losing the frame behind it.
+ *
+ * Noise ends up in the slot until the tokenizer finds that it does not open with <UCL>.
+ * By then the noise may have been followed by the '<' of a real frame, e.g. the tail of a
+ * frame abandoned by a timeout. The bytes from the last '<' on are fed into the tokenizer
+ * again as the start of a new frame. Noise is dropped within PARENT_TAG_WINDOW bytes, so
+ * at most that many bytes are fed again.
+ *
+ * @param port Pointer to the command line port the frame is received on
+ * @param char_index Pointer to the character index
+ *
+ * @retval None
+ */
+static void resync_after_noise(struct CommandLinePort *port, uint32_t *char_index)
+{
+    Tokenizer_Status_t tokenizer_status = TOKENIZER_IN_PROGRESS;
+    uint32_t start = *char_index;
+    uint32_t index = 0;
 
-        // Check if the received string contains the closing </UCL> tag
-        if (find_tag_location(g_uart_xml_raw_buffer, XML_PARENT_TAG, CLOSE_TAG))
-        {
-            // Ensure the semaphore is unlocked before processing
-            if (!obtain_semaphore(&g_semaphore))
-            {
-                // Lock the semaphore to signal data processing
-                acquire_semaphore(&g_semaphore);
+    // The first byte is where the noise started, a frame can only start after it
+    while (--start > 0 && port->rx.slot->data[start] != '<')
+    {
+    }
+
+    if (start == 0)
+    {
+        reset_buffer_state(port, char_index);
+        return;
+    }
 
-                // Process the complete message
-                process_complete_message(mem_blocks);
-            }
+    // Keep the slot, the candidate frame is moved to its start and tokenized again
+    frame_tokenizer_reset(&port->rx.slot->tokenizer);
 
-            // Reset the character index
-            *char_index = 0;
-        }
+    for (index = 0; start + index < *char_index; ++index)
+    {
+        port->rx.slot->data[index] = port->rx.slot->data[start + index];
+        tokenizer_status = frame_tokenizer_feed(&port->rx.slot->tokenizer, port->rx.slot->data[index], (uint16_t)index);
     }
 
-    // Exit ISR if necessary
-    if (exit_isr)
+    port->rx.slot->data[index] = '\0';
+    *char_index = index;
+
+    // Noise such as a stray </UCL> is not the start of a frame either
+    if (tokenizer_status == TOKENIZER_BAD_FRAME)
     {
-        return;
+        reset_buffer_state(port, char_index);
     }
 }
 
-
 /**
- * @brief Process a complete XML message and prepare it for the main application.
+ * @brief Process each received character and check for message completeness.
  *
- * @param mem_blocks Number of memory blocks allocated
+ * The first byte of a frame selects its format: a frame that starts with the binary
+ * frame delimiter is a binary frame, anything else is XML. XML characters are stored in
+ * the slot and fed into the frame tokenizer, which records the tag offsets and
+ * reports when the closing </UCL> tag has arrived. The work done per character is
+ * constant, no matter how long the frame is.
+ *
+ * @param port Pointer to the command line port the frame is received on
+ * @param received_char The character received from UART
+ * @param char_index Pointer to the character index
  *
  * @retval None
  */
-void process_complete_message(uint32_t mem_blocks)
+void process_received_char(struct CommandLinePort *port, char received_char, uint32_t *char_index)
 {
-    bool exit_isr = false;  // Flag to track if ISR should exit early
+    Tokenizer_Status_t tokenizer_status = TOKENIZER_IN_PROGRESS;
 
     // Validate parameters
-    if (mem_blocks == 0)
+    if (char_index == NULL || port->rx.slot == NULL)
     {
-        exit_isr = true; // Exit ISR due to invalid memory block size
+        return; // Exit ISR due to invalid input
     }
-    else
+
+    // The opening delimiter of a binary frame is not stored
+    if (*char_index == 0 && (uint8_t)received_char == BINARY_FRAME_DELIMITER)
+    {
+        port->rx.format = FRAME_FORMAT_BINARY;
+        *char_index = 1;
+        return;
+    }
+
+    if (port->rx.format == FRAME_FORMAT_BINARY)
     {
-        // Allocate memory for the main buffer
-        g_uart_xml_main_buffer = (char *)MemoryPool_AllocatePages(mem_blocks);
+        process_received_binary_char(port, received_char, char_index);
+        return;
+    }
 
-        if (g_uart_xml_main_buffer)
-        {
-            // Clear the main buffer
-            memset(g_uart_xml_main_buffer, 0, sizeof(*g_uart_xml_main_buffer));
+    // Store the received character in the buffer
+    port->rx.slot->data[*char_index] = received_char;
+
+    // Let the tokenizer track the tags of the frame
+    tokenizer_status = frame_tokenizer_feed(&port->rx.slot->tokenizer, received_char, (uint16_t)(*char_index));
 
-            // Copy the received data to the main buffer
-            memcpy(g_uart_xml_main_buffer, g_uart_xml_raw_buffer, strlen(g_uart_xml_raw_buffer) + 1);
+    // Null-terminate the string
+    port->rx.slot->data[++(*char_index)] = '\0';
+
+    // Check if the received character closed the </UCL> tag
+    if (tokenizer_status == TOKENIZER_FRAME_COMPLETE)
+    {
+        hand_over_frame(port, (uint16_t)(*char_index), char_index);
+    }
+    // Reject an unknown command as soon as its name is complete
+    else if (tokenizer_status == TOKENIZER_COMMAND_COMPLETE)
+    {
+        check_received_command(port, char_index);
+    }
+    // Reject malformed frames as soon as a tag is malformed; bytes that do not start with
+    // <UCL> are line noise and are dropped without a reply
+    else if (tokenizer_status == TOKENIZER_BAD_FRAME)
+    {
+        if (port->rx.slot->tokenizer.layout.tags.open[FRAME_TAG_UCL] == FRAME_TAG_NOT_FOUND)
+        {
+            resync_after_noise(port, char_index);
+        }
+        else
+        {
+            reject_frame(port, BAD_XML, (port->rx.slot->tokenizer.layout.tags.close[FRAME_TAG_UCL] != FRAME_TAG_NOT_FOUND),
+                         char_index);
         }
+    }
+}
 
-        // Free the raw buffer as it is no longer needed
-        MemoryPool_FreePages((char *)g_uart_xml_raw_buffer, mem_blocks);
+
+/**
+ * @brief Process a complete XML or binary message and hand it over to the main application.
+ *
+ * The frame already is in its slot of the frame ring, with the layout the tokenizer
+ * recorded next to it; publishing the slot is all the hand-over takes.
+ *
+ * @param port Pointer to the command line port the frame is received on
+ * @param length Number of bytes of the message in the slot
+ *
+ * @retval None
+ */
+void process_complete_message(struct CommandLinePort *port, uint16_t length)
+{
+    // Validate parameters
+    if (port->rx.slot == NULL || length >= FRAME_SLOT_SIZE)
+    {
+        return; // Exit ISR due to invalid input
     }
 
-    // Exit ISR if necessary
-    if (exit_isr)
+    // Binary frames may hold zeros, the length tells where they end
+    port->rx.slot->data[length] = '\0';
+    port->rx.slot->length = length;
+    port->rx.slot->format = port->rx.format;
+    port->rx.slot->sequence = port->rx.sequence++;
+
+    // From here on the slot belongs to the main loop
+    frame_ring_publish(&port->frames);
+    port->rx.slot = NULL;
+
+    // Stop the sender before the ring is full, the main loop lets it go on again
+    if (frame_ring_waiting(&port->frames) >= FRAME_RING_RTS_HIGH)
     {
-        return;
+        HAL_USART_SetRts(port->usart, DISABLE);
     }
 }
 
 /**
- * @brief Reset the state of the raw buffer and free allocated memory.
+ * @brief Reset the receive state and give the slot back for the next frame.
  *
- * @param mem_blocks Number of memory blocks allocated
+ * @param port Pointer to the command line port the frame is received on
  * @param char_index Pointer to the character index
  *
  * @retval None
  */
-void reset_buffer_state(uint32_t mem_blocks, uint32_t *char_index)
+void reset_buffer_state(struct CommandLinePort *port, uint32_t *char_index)
 {
-    bool exit_isr = false;  // Flag to track if ISR should exit early
-
     // Validate parameters
-    if (char_index == NULL || mem_blocks == 0)
+    if (char_index == NULL)
     {
-        exit_isr = true; // Exit ISR due to invalid input
+        return; // Exit ISR due to invalid input
     }
-    else
+
+    // The slot has not been published, the next frame is received into it again
+    port->rx.slot = NULL;
+
+    // Reset the character index
+    *char_index = 0;
+}
+
+
+/**
+ * @brief Assembles one received byte into the current frame.
+ *
+ * Takes a slot of the frame ring when a frame starts, or drops the frame if none is free, skips the rest of a rejected frame and
+ * feeds every other byte into the frame tokenizer or the binary frame decoder.
+ *
+ * @param port Pointer to the command line port the frame is received on
+ * @param received_char The character received from UART
+ * @param char_index Pointer to the character index
+ *
+ * @retval None
+ */
+static void assemble_received_char(struct CommandLinePort *port, char received_char, uint32_t *char_index)
+{
+    // The rest of a rejected frame is skipped without a buffer
+    if (port->rx.discarding)
+    {
+        discard_received_char(port, received_char);
+        return;
+    }
+
+    // Start of a new message
+    if (port->rx.slot == NULL)
     {
-        // Free the raw buffer if it exists
-        if (g_uart_xml_raw_buffer)
+        // The whole-frame timeout runs from the first byte
+        port->rx.frame_start_tick = port->rx.last_byte_tick;
+
+        // Attempt to initialize a new message
+        if (start_new_message(port, char_index))
         {
-            MemoryPool_FreePages((char *)g_uart_xml_raw_buffer, mem_blocks);
+            // Every slot waits for the main loop, the frame is dropped
+            drop_frame(port, received_char);
+            return;
         }
+    }
+
+    // Keep one byte for the null terminator
+    if (*char_index < FRAME_SLOT_SIZE - 1U)
+    {
+        // Process the current received character
+        process_received_char(port, received_char, char_index);
+    }
+    else
+    {
+        // Reject the frame if the slot limit is exceeded
+        ++port->frames.overflowed;
+        reject_frame(port, BAD_XML, false, char_index);
+    }
+}
+
+/**
+ * @brief Assembles the bytes of the receive ring up to a position.
+ *
+ * @param port Pointer to the command line port the frame is received on
+ * @param end Ring position to stop at, the byte there is not assembled
+ *
+ * @retval None
+ */
+static void drain_rx_ring_to(struct CommandLinePort *port, uint16_t end)
+{
+    const uint8_t *ring = g_usart_rx_rings[port->usart];
 
-        // Reset the character index
-        *char_index = 0;
+    // The bytes arrived since the last tick at the latest, that is as precise as the timeouts get
+    if (port->rx.ring_read != end)
+    {
+        port->rx.last_byte_tick = HAL_GetTick();
+        port->rx_stats.bytes_received += (uint32_t)((end - port->rx.ring_read) & (USART_RX_RING_SIZE - 1U));
     }
 
-    // Exit ISR if necessary
-    if (exit_isr)
+    while (port->rx.ring_read != end)
     {
-        return;
+        assemble_received_char(port, (char)ring[port->rx.ring_read], &port->rx.char_index);
+        port->rx.ring_read = (uint16_t)((port->rx.ring_read + 1U) & (USART_RX_RING_SIZE - 1U));
     }
 }
 
+/**
+ * @brief Assembles every byte the DMA has written into the receive ring since the last call.
+ *
+ * Called from the interrupt of the USART and from the DMA half and full transfer
+ * interrupts. All of them run at the same priority, so they never preempt each other.
+ *
+ * @param port Pointer to the command line port the frame is received on
+ *
+ * @retval None
+ */
+static void drain_rx_ring(struct CommandLinePort *port)
+{
+    drain_rx_ring_to(port, HAL_DMA_USART_RxWriteIndex(port->usart));
+}
 
 /**
- * @brief USART2 Interrupt Service Routine (ISR)
+ * @brief Counts the receive errors flagged in the status register and drops the frame they corrupted.
  *
- * Handles UART data reception, allocates memory for incoming messages, processes XML, 
- * and manages memory to avoid fragmentation.
+ * The DMA moves a byte received with a framing, noise or parity error into the ring like any
+ * other, and the error interrupt follows at once, so the corrupted byte is the last one the
+ * DMA has written. The bytes in front of it are assembled, the corrupted byte is skipped
+ * and the frame it belonged to is abandoned; an overrun has lost a byte behind the last
+ * one in the ring instead. The rest of the frame is dropped as line noise, as after a
+ * timeout. With RX_LINE_ERROR_NAK the sender is told to send the frame again.
+ *
+ * @param port Pointer to the command line port the frame is received on
+ * @param status Status register of the USART, read before the flags were cleared
  *
- * @param None
  * @retval None
  */
-static void USART2_IRQHandler(void)
+static void rx_line_error(struct CommandLinePort *port, uint16_t status)
 {
-    static uint32_t char_index = 0;                // Tracks the current position in the received buffer
-    const uint32_t MEM_BLOCK_NO = 8;              // Number of memory blocks for the raw buffer
-    const uint32_t CHECK_PARENT_TAG = 7;          // Position to validate the XML parent tag
+    const uint16_t write_index = HAL_DMA_USART_RxWriteIndex(port->usart);    // Ring position the DMA writes next
 
-    // Check if the RXNE (Receive Data Register Not Empty) flag is set
-    if (SET == USART_GetFlagStatus(USART2, USART_FLAG_RXNE))
+    if (status & USART_FLAG_ORE)
+    {
+        ++port->rx_stats.overruns;
+    }
+    if (status & USART_FLAG_FE)
     {
-        char received_char = (char)USART_ReceiveData(USART2); // Read received character
+        ++port->rx_stats.framing_errors;
+    }
+    if (status & USART_FLAG_NE)
+    {
+        ++port->rx_stats.noise_errors;
+    }
+    if (status & USART_FLAG_PE)
+    {
+        ++port->rx_stats.parity_errors;
+    }
 
-        // Start of a new message
-        if (char_index == 0)
-        {
-            // Attempt to initialize a new message
-            if (start_new_message(MEM_BLOCK_NO, &char_index, received_char))
-                return; // Exit ISR if initialization failed
-        }
-        else if (char_index < (BLOCK_SIZE * MEM_BLOCK_NO))
+    if ((status & (USART_FLAG_FE | USART_FLAG_NE | USART_FLAG_PE)) && port->rx.ring_read != write_index)
+    {
+        // Everything in front of the corrupted byte is still good
+        drain_rx_ring_to(port, (uint16_t)((write_index - 1U) & (USART_RX_RING_SIZE - 1U)));
+        port->rx.ring_read = write_index;
+        ++port->rx_stats.bytes_received;
+    }
+    else
+    {
+        drain_rx_ring_to(port, write_index);
+    }
+
+    // The rest of a rejected frame is already being skipped, it has had its reply
+    if (port->rx.slot != NULL)
+    {
+        ++port->rx_stats.corrupted_frames;
+
+#if RX_LINE_ERROR_NAK
+        queue_reply(port, LINE_ERROR);
+#endif
+
+        // Give the slot back, the next byte starts a new frame
+        reset_buffer_state(port, &port->rx.char_index);
+    }
+}
+
+/**
+ * @brief Abandons a frame of one port that has stalled, e.g. because the sender was disconnected.
+ *
+ * A frame, or the rest of a rejected frame that is being skipped, is abandoned when the
+ * line has been silent in the middle of it for RX_INTER_BYTE_TIMEOUT_BITS, or when it has
+ * been arriving for RX_FRAME_TIMEOUT_BITS as a whole. Its slot is given back and the next
+ * byte starts a new frame. No reply is sent, the sender most likely is gone.
+ *
+ * @param port Pointer to the command line port the frame is received on
+ * @param now The current SysTick tick
+ *
+ * @retval None
+ */
+static void rx_timeout_tick(struct CommandLinePort *port, uint32_t now)
+{
+    bool timed_out = false;
+
+    // Bytes the DMA has written and no interrupt has assembled yet, the frame is still arriving
+    if (HAL_DMA_USART_RxWriteIndex(port->usart) != port->rx.ring_read)
+    {
+        port->rx.last_byte_tick = now;
+        return;
+    }
+
+    // Nothing is received between frames, there is nothing to time out
+    if (port->rx.slot == NULL && !port->rx.discarding)
+    {
+        return;
+    }
+
+    // The timeouts are given in bit-times, convert them again after a baud rate switch
+    if (port->rx.timeout_baud_rate != HAL_USART_GetBaudRate(port->usart))
+    {
+        port->rx.timeout_baud_rate = HAL_USART_GetBaudRate(port->usart);
+        port->rx.inter_byte_timeout_ticks = RX_TIMEOUT_TICKS(RX_INTER_BYTE_TIMEOUT_BITS, port->rx.timeout_baud_rate);
+        port->rx.frame_timeout_ticks = RX_TIMEOUT_TICKS(RX_FRAME_TIMEOUT_BITS, port->rx.timeout_baud_rate);
+    }
+
+    // The tick counter wraps around, only differences of ticks are compared
+    if ((uint32_t)(now - port->rx.last_byte_tick) >= port->rx.inter_byte_timeout_ticks)
+    {
+        ++port->rx_stats.inter_byte_timeouts;
+        timed_out = true;
+    }
+    else if ((uint32_t)(now - port->rx.frame_start_tick) >= port->rx.frame_timeout_ticks)
+    {
+        ++port->rx_stats.frame_timeouts;
+        timed_out = true;
+    }
+
+    if (timed_out)
+    {
+        // Give the slot back, the next byte starts a new frame
+        reset_buffer_state(port, &port->rx.char_index);
+        port->rx.discarding = false;
+    }
+}
+
+/**
+ * @brief Abandons the frames that have stalled on any port.
+ *
+ * Called from SysTick_Handler once per tick. SysTick runs at the priority of the
+ * receive interrupts, so it never preempts them.
+ *
+ * @param now The current SysTick tick
+ *
+ * @retval None
+ */
+void UART_RxTimeoutTick(uint32_t now)
+{
+    uint8_t usart = 0;
+
+    for (usart = 0; usart < (uint8_t)USART_PORT_COUNT; ++usart)
+    {
+        if (g_command_line_ports[usart] != NULL)
         {
-            // If a valid buffer exists
-            if (g_uart_xml_raw_buffer)
-            {
-                // Validate parent tag after receiving sufficient characters
-                if (char_index == CHECK_PARENT_TAG)
-                {
-                    if (validate_parent_tag(MEM_BLOCK_NO, &char_index))
-                    {
-                        return; // Exit ISR if validation fails
-                    }
-                }
-
-                // Process the current received character
-                process_received_char(received_char, &char_index, MEM_BLOCK_NO);
-            }
-            else
-            {
-                // Reset the state if no buffer is allocated
-                reset_buffer_state(MEM_BLOCK_NO, &char_index);
-            }
+            rx_timeout_tick(g_command_line_ports[usart], now);
         }
-        else
+    }
+}
+
+/**
+ * @brief Handles the idle-line and the receive error interrupts of the USART of a port.
+ *
+ * The DMA receives the bytes into the ring without waking the CPU. This interrupt fires
+ * once the line has been idle for a character time, i.e. at the end of every burst, and
+ * assembles the received bytes into frames. It also fires on an overrun, framing, noise
+ * or parity error; an error flag that is not cleared would enter the handler again and
+ * again and starve the main loop.
+ *
+ * @param port Pointer to the command line port of the USART
+ *
+ * @retval None
+ */
+static void usart_rx_irq(struct CommandLinePort *port)
+{
+    USART_TypeDef *usart = HAL_USART_Instance(port->usart);
+    const uint16_t status = usart->SR;   // Read once, the read of DR below clears every flag read here
+
+    if (status & (USART_FLAG_IDLE | USART_RX_ERROR_FLAGS))
+    {
+        // Reading the data register after the status register clears the flags
+        (void)USART_ReceiveData(usart);
+
+        if (status & USART_RX_ERROR_FLAGS)
         {
-            // Reset state if buffer limit is exceeded
-            reset_buffer_state(MEM_BLOCK_NO, &char_index);
+            rx_line_error(port, status);
         }
+
+        drain_rx_ring(port);
     }
 }
 
+/**
+ * @brief Handles the half and full transfer interrupts of the receive channel of a port.
+ *
+ * Fires when the DMA has filled half of the receive ring and when it wraps around, so a
+ * burst longer than the ring is read before the DMA overwrites it.
+ *
+ * @param port Pointer to the command line port of the channel
+ *
+ * @retval None
+ */
+static void dma_rx_irq(struct CommandLinePort *port)
+{
+    HAL_DMA_USART_RxClearFlags(port->usart);
+
+    drain_rx_ring(port);
+}
+
+#if USART1_COMMAND_LINE
+/**
+ * @brief USART1 Interrupt Service Routine (ISR), receives and transmits
+ *
+ * @param None
+ * @retval None
+ */
+void USART1_IRQHandler(void)
+{
+    usart_rx_irq(g_command_line_ports[USART_PORT_1]);
+    HAL_USART_TxIrq(USART_PORT_1);
+}
+
+/**
+ * @brief DMA1 channel 5 Interrupt Service Routine (ISR), receives USART1
+ *
+ * @param None
+ * @retval None
+ */
+void DMA1_Channel5_IRQHandler(void)
+{
+    dma_rx_irq(g_command_line_ports[USART_PORT_1]);
+}
+
+/**
+ * @brief DMA1 channel 4 Interrupt Service Routine (ISR), transmits USART1
+ *
+ * @param None
+ * @retval None
+ */
+void DMA1_Channel4_IRQHandler(void)
+{
+    HAL_USART_TxDmaIrq(USART_PORT_1);
+}
+#endif
+
+#if USART2_COMMAND_LINE
+/**
+ * @brief USART2 Interrupt Service Routine (ISR), receives and transmits
+ *
+ * @param None
+ * @retval None
+ */
+void USART2_IRQHandler(void)
+{
+    usart_rx_irq(g_command_line_ports[USART_PORT_2]);
+    HAL_USART_TxIrq(USART_PORT_2);
+}
+
+/**
+ * @brief DMA1 channel 6 Interrupt Service Routine (ISR), receives USART2
+ *
+ * @param None
+ * @retval None
+ */
+void DMA1_Channel6_IRQHandler(void)
+{
+    dma_rx_irq(g_command_line_ports[USART_PORT_2]);
+}
+
+/**
+ * @brief DMA1 channel 7 Interrupt Service Routine (ISR), transmits USART2
+ *
+ * @param None
+ * @retval None
+ */
+void DMA1_Channel7_IRQHandler(void)
+{
+    HAL_USART_TxDmaIrq(USART_PORT_2);
+}
+#endif
+
+#if USART3_COMMAND_LINE
+/**
+ * @brief USART3 Interrupt Service Routine (ISR), receives and transmits
+ *
+ * @param None
+ * @retval None
+ */
+void USART3_IRQHandler(void)
+{
+    usart_rx_irq(g_command_line_ports[USART_PORT_3]);
+    HAL_USART_TxIrq(USART_PORT_3);
+}
+
+/**
+ * @brief DMA1 channel 3 Interrupt Service Routine (ISR), receives USART3
+ *
+ * @param None
+ * @retval None
+ */
+void DMA1_Channel3_IRQHandler(void)
+{
+    dma_rx_irq(g_command_line_ports[USART_PORT_3]);
+}
+
+/**
+ * @brief DMA1 channel 2 Interrupt Service Routine (ISR), transmits USART3
+ *
+ * @param None
+ * @retval None
+ */
+void DMA1_Channel2_IRQHandler(void)
+{
+    HAL_USART_TxDmaIrq(USART_PORT_3);
+}
+#endif
@@ -3,17 +3,44 @@
 
 #include "../HAL-SYSTEM/inc/stm32f10x.h"
 #include "../HAL-UART/inc/stm32f10x_usart.h"
-#include "../../Command_Line_App/memory_utility/memory_utility.h"
+#include "../HAL-DMA/inc/hal_dma_config.h"
+#include "../HAL-UART/inc/hal_usart_config.h"
+#include "../HAL-SYSTICK/inc/hal_systick_config.h"
+#include "../../Command_Line_App/frame_ring/frame_ring.h"
+#include "../../Command_Line_App/command_line_port/command_line_port.h"
 #include "../../Command_Line_App/UART_command_line/UART_Command_Line.h"
-#include "../../Command_Line_App/semaphore/semaphore.h"
-#include <stdio.h>
+#include "../../Command_Line_App/frame_tokenizer/frame_tokenizer.h"
+#include "../../Command_Line_App/binary_frame/binary_frame.h"
+#include "../../Command_Line_App/reply_queue/reply_queue.h"
+#include "../../Command_Line_App/UART_command_line/command_table.h"
 #include <string.h>
 
-bool start_new_message(uint32_t mem_blocks, uint32_t *char_index, char received_char);
-bool validate_parent_tag(uint32_t mem_blocks, uint32_t *char_index);
-void process_received_char(char received_char, uint32_t *char_index, uint32_t mem_blocks);
-void process_complete_message(uint32_t mem_blocks);
-void reset_buffer_state(uint32_t mem_blocks, uint32_t *char_index);
+#define RX_INTER_BYTE_TIMEOUT_BITS  (uint32_t) 4800    //0.5 s at 9600 baud, leaves room for a frame typed at a terminal
+#define RX_FRAME_TIMEOUT_BITS       (uint32_t) 96000   //10 s at 9600 baud, a full frame slot takes 2560 bit-times
+
+#define RX_LINE_ERROR_NAK           1                  //1 to reply LINE_ERROR to a frame a receive error has corrupted
+
+//flags of the status register raised by a byte that was lost or received corrupted
+#define USART_RX_ERROR_FLAGS        (uint16_t)(USART_FLAG_ORE | USART_FLAG_NE | USART_FLAG_FE | USART_FLAG_PE)
+
+//a timeout in SysTick ticks; the first tick comes anywhere within its period, one more makes sure the whole time passes
+#define RX_TIMEOUT_TICKS(bits, baud_rate) \
+    ((uint32_t)((((uint64_t)(bits) * SYSTICK_FREQUENCY_HZ) + (baud_rate) - 1U) / (baud_rate)) + 1U)
+
+bool start_new_message(struct CommandLinePort *port, uint32_t *char_index);
+void process_received_char(struct CommandLinePort *port, char received_char, uint32_t *char_index);
+void process_complete_message(struct CommandLinePort *port, uint16_t length);
+void reset_buffer_state(struct CommandLinePort *port, uint32_t *char_index);
+void USART1_IRQHandler(void);
+void USART2_IRQHandler(void);
+void USART3_IRQHandler(void);
+void DMA1_Channel2_IRQHandler(void);
+void DMA1_Channel3_IRQHandler(void);
+void DMA1_Channel4_IRQHandler(void);
+void DMA1_Channel5_IRQHandler(void);
+void DMA1_Channel6_IRQHandler(void);
+void DMA1_Channel7_IRQHandler(void);
+void UART_RxTimeoutTick(uint32_t now);
 
 #endif /*UART_ISR_H*/
 
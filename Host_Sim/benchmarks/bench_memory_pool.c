@@ -0,0 +1,163 @@
+/*
+ * bench_memory_pool.c
+ *
+ * Host benchmark of the allocation of single blocks from the memory pool.
+ *
+ * The pool is filled from its first block up to a given occupancy, and one block is
+ * then allocated and freed over and over, once with MemoryPool_Allocate() and
+ * MemoryPool_Free(), which take the block from the free list, and once with
+ * MemoryPool_AllocatePages(1) and MemoryPool_FreePages(), which search the bitmap for
+ * it from the start of the pool. The search passes every block in use, the free list
+ * does not, so only the cost of the search grows with the occupancy.
+ *
+ * Before measuring, every occupancy is checked to hand out a block that is free, so
+ * the benchmark fails if the free list and the bitmap ever disagree.
+ *
+ * The result is reported in cycles per allocation and free (time stamp counter on x86
+ * hosts, nanoseconds elsewhere).
+ */
+
+#include "../../Command_Line_App/memory_utility/memory_utility.h"
+#include "bench_timer.h"
+#include <stdio.h>
+
+#define BENCH_ITERATIONS   (uint32_t) 200000
+
+/*blocks in use while a block is allocated and freed, from an empty pool to a single free block*/
+static const uint32_t g_bench_occupancy[] =
+{
+    0, BLOCK_COUNT / 4U, BLOCK_COUNT / 2U, BLOCK_COUNT * 3U / 4U, BLOCK_COUNT - 1U
+};
+
+#define BENCH_OCCUPANCY_COUNT  (uint32_t) (sizeof(g_bench_occupancy) / sizeof(g_bench_occupancy[0]))
+
+/*blocks taken to fill the pool, the first is the start of the pool*/
+static uint8_t *g_bench_held[BLOCK_COUNT];
+
+/*result sink, keeps the compiler from optimising the work away*/
+static volatile uintptr_t g_bench_sink;
+
+/**
+ * @brief A way of allocating and freeing one block.
+ */
+struct BenchAllocator
+{
+    void *(*allocate)(void);
+    void (*free)(void *block_pointer);
+};
+
+static void *bitmap_allocate(void)
+{
+    return MemoryPool_AllocatePages(1);
+}
+
+static void bitmap_free(void *block_pointer)
+{
+    MemoryPool_FreePages(block_pointer, 1);
+}
+
+static const struct BenchAllocator g_bench_free_list = { MemoryPool_Allocate, MemoryPool_Free };
+static const struct BenchAllocator g_bench_bitmap = { bitmap_allocate, bitmap_free };
+
+/**
+ * @brief Empties the pool and fills its first blocks.
+ */
+static void fill_pool(uint32_t occupancy)
+{
+    uint32_t block = 0;
+
+    MemoryPool_Init();
+
+    for (block = 0; block < occupancy; ++block)
+    {
+        g_bench_held[block] = (uint8_t *)MemoryPool_AllocatePages(1);
+    }
+}
+
+/**
+ * @brief Checks that both ways hand out a block that is not in use, and only one.
+ */
+static bool hands_out_free_block(const struct BenchAllocator *allocator, uint32_t occupancy)
+{
+    uint8_t *block = NULL;
+    uint32_t index = 0;
+    bool outcome = true;
+
+    fill_pool(occupancy);
+    block = (uint8_t *)allocator->allocate();
+
+    if (block == NULL || MemoryPool_GetFreeBlocks() != BLOCK_COUNT - occupancy - 1U)
+    {
+        outcome = false;
+    }
+
+    for (index = 0; outcome && index < occupancy; ++index)
+    {
+        outcome = (g_bench_held[index] != block);
+    }
+
+    if (block != NULL)
+    {
+        allocator->free(block);
+    }
+
+    return outcome && MemoryPool_GetFreeBlocks() == BLOCK_COUNT - occupancy;
+}
+
+/**
+ * @brief Allocates and frees a block over and over and returns the average cost of a pair.
+ */
+static uint64_t measure(const struct BenchAllocator *allocator, uint32_t occupancy)
+{
+    void *block = NULL;
+    uint64_t start = 0;
+    uint32_t iteration = 0;
+
+    fill_pool(occupancy);
+
+    //warm up the caches once
+    block = allocator->allocate();
+    allocator->free(block);
+
+    start = bench_timer_now();
+    for (iteration = 0; iteration < BENCH_ITERATIONS; ++iteration)
+    {
+        block = allocator->allocate();
+        g_bench_sink += (uintptr_t)block;
+        allocator->free(block);
+    }
+
+    return (bench_timer_now() - start) / BENCH_ITERATIONS;
+}
+
+int main(void)
+{
+    uint64_t free_list = 0;
+    uint64_t bitmap = 0;
+    uint32_t level = 0;
+    uint32_t occupancy = 0;
+    int outcome = 0;
+
+    printf("memory pool cost per single block allocated and freed (%s)\n", bench_timer_unit());
+    printf("%-10s %12s %12s %9s\n", "in use", "bitmap", "free list", "speedup");
+
+    for (level = 0; level < BENCH_OCCUPANCY_COUNT; ++level)
+    {
+        occupancy = g_bench_occupancy[level];
+
+        if (!hands_out_free_block(&g_bench_free_list, occupancy) || !hands_out_free_block(&g_bench_bitmap, occupancy))
+        {
+            printf("%u of %u blocks in use: a block in use was handed out\n", occupancy, BLOCK_COUNT);
+            outcome = 1;
+            continue;
+        }
+
+        bitmap    = measure(&g_bench_bitmap, occupancy);
+        free_list = measure(&g_bench_free_list, occupancy);
+
+        printf("%4u of %-3u %12llu %12llu %8.1fx\n", occupancy, BLOCK_COUNT, (unsigned long long) bitmap,
+               (unsigned long long) free_list, (free_list != 0U) ? (double) bitmap / (double) free_list : 0.0);
+    }
+
+    return outcome;
+}
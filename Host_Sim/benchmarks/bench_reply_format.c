@@ -0,0 +1,181 @@
+/*
+ * bench_reply_format.c
+ *
+ * Host benchmark of the formatting of the numbers in the replies.
+ *
+ * Every kind of value the reply formatter handles is formatted once with it and once
+ * with the snprintf call that produces the same text, over a set of values from 0 to
+ * the extremes of the type. Both texts are compared first, so the benchmark fails if
+ * the formatter ever disagrees with the C library.
+ *
+ * The result is reported in cycles per value (time stamp counter on x86 hosts,
+ * nanoseconds elsewhere). The flash both take is reported by "make bench" after it.
+ */
+
+#include "../../Command_Line_App/reply_format/reply_format.h"
+#include "bench_timer.h"
+#include <stdio.h>
+#include <string.h>
+
+#define BENCH_ITERATIONS   (uint32_t) 20000
+#define BENCH_TEXT_SIZE    (uint16_t) 32
+#define BENCH_FRACTION     (uint8_t) 3      //fraction digits of the fixed-point values
+#define BENCH_HEX_DIGITS   (uint8_t) 4      //minimum digits of the hexadecimal values
+
+/*values from a single digit to the extremes of 32 bits*/
+static const int32_t g_bench_values[] =
+{
+    0, 7, -7, 42, 1000, -32768, 115200, 2250000, -1234567, 2147483647, -2147483647 - 1
+};
+
+#define BENCH_VALUE_COUNT  (uint32_t) (sizeof(g_bench_values) / sizeof(g_bench_values[0]))
+
+/*result sink, keeps the compiler from optimising the work away*/
+static volatile uint32_t g_bench_sink;
+
+/**
+ * @brief A way of formatting one value, returning the length of the text.
+ */
+typedef uint16_t (*BenchFormat)(char *text, int32_t value);
+
+static uint16_t formatter_u32(char *text, int32_t value)
+{
+    return reply_format_u32(text, (uint32_t) value);
+}
+
+static uint16_t snprintf_u32(char *text, int32_t value)
+{
+    return (uint16_t) snprintf(text, BENCH_TEXT_SIZE, "%u", (unsigned) value);
+}
+
+static uint16_t formatter_i32(char *text, int32_t value)
+{
+    return reply_format_i32(text, value);
+}
+
+static uint16_t snprintf_i32(char *text, int32_t value)
+{
+    return (uint16_t) snprintf(text, BENCH_TEXT_SIZE, "%d", (int) value);
+}
+
+static uint16_t formatter_hex(char *text, int32_t value)
+{
+    return reply_format_hex(text, (uint32_t) value, BENCH_HEX_DIGITS);
+}
+
+static uint16_t snprintf_hex(char *text, int32_t value)
+{
+    return (uint16_t) snprintf(text, BENCH_TEXT_SIZE, "0x%04x", (unsigned) value);
+}
+
+static uint16_t formatter_fixed(char *text, int32_t value)
+{
+    return reply_format_fixed(text, value, BENCH_FRACTION);
+}
+
+/**
+ * @brief The usual way of printing a scaled value with snprintf, integer and fraction part.
+ */
+static uint16_t snprintf_fixed(char *text, int32_t value)
+{
+    const uint32_t magnitude = (value < 0) ? 0U - (uint32_t) value : (uint32_t) value;
+
+    return (uint16_t) snprintf(text, BENCH_TEXT_SIZE, "%s%u.%03u", (value < 0) ? "-" : "",
+                               (unsigned) (magnitude / 1000U), (unsigned) (magnitude % 1000U));
+}
+
+/**
+ * @brief A kind of value, formatted both ways.
+ */
+struct BenchCase
+{
+    const char *name;
+    BenchFormat formatter;
+    BenchFormat library;
+};
+
+static const struct BenchCase g_bench_cases[] =
+{
+    { "u32",   formatter_u32,   snprintf_u32 },
+    { "i32",   formatter_i32,   snprintf_i32 },
+    { "hex",   formatter_hex,   snprintf_hex },
+    { "fixed", formatter_fixed, snprintf_fixed },
+    { NULL,    NULL,            NULL }
+};
+
+/**
+ * @brief Checks that both ways produce the same text for every value.
+ */
+static bool same_text(const struct BenchCase *bench_case)
+{
+    char expected[BENCH_TEXT_SIZE];
+    char text[BENCH_TEXT_SIZE];
+    uint16_t length = 0;
+    uint32_t value = 0;
+
+    for (value = 0; value < BENCH_VALUE_COUNT; ++value)
+    {
+        length = bench_case->formatter(text, g_bench_values[value]);
+
+        if (bench_case->library(expected, g_bench_values[value]) != length || memcmp(text, expected, length) != 0)
+        {
+            printf("%s: %.*s instead of %s\n", bench_case->name, (int) length, text, expected);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Formats every value over and over and returns the average cost per value.
+ */
+static uint64_t measure(BenchFormat format)
+{
+    char text[BENCH_TEXT_SIZE];
+    uint64_t start = 0;
+    uint32_t iteration = 0;
+    uint32_t value = 0;
+
+    //warm up the caches once
+    g_bench_sink += format(text, g_bench_values[0]);
+
+    start = bench_timer_now();
+    for (iteration = 0; iteration < BENCH_ITERATIONS; ++iteration)
+    {
+        for (value = 0; value < BENCH_VALUE_COUNT; ++value)
+        {
+            g_bench_sink += format(text, g_bench_values[value]);
+        }
+    }
+
+    return (bench_timer_now() - start) / ((uint64_t) BENCH_ITERATIONS * BENCH_VALUE_COUNT);
+}
+
+int main(void)
+{
+    const struct BenchCase *bench_case = NULL;
+    uint64_t formatter = 0;
+    uint64_t library = 0;
+    int outcome = 0;
+
+    printf("reply formatting cost per value (%s)\n", bench_timer_unit());
+    printf("%-8s %12s %12s %9s\n", "kind", "snprintf", "formatter", "speedup");
+
+    for (bench_case = g_bench_cases; bench_case->name; ++bench_case)
+    {
+        if (!same_text(bench_case))
+        {
+            outcome = 1;
+            continue;
+        }
+
+        library   = measure(bench_case->library);
+        formatter = measure(bench_case->formatter);
+
+        printf("%-8s %12llu %12llu %8.1fx\n", bench_case->name, (unsigned long long) library,
+               (unsigned long long) formatter, (formatter != 0U) ? (double) library / (double) formatter : 0.0);
+    }
+
+    return outcome;
+}
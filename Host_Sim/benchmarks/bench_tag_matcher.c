@@ -0,0 +1,208 @@
+/*
+ * bench_tag_matcher.c
+ *
+ * Host benchmark of the tag matching done for every received frame.
+ *
+ * The legacy path is reproduced as it was before the tag matcher: the ISR called
+ * find_tag_location(buffer, "UCL", CLOSE_TAG) after every byte, and each call took a
+ * block from the memory pool, built "</UCL>" with snprintf, searched the whole buffer
+ * with strstr and freed the block again. The parser then searched for the four
+ * CMD and PARAM tags the same way.
+ *
+ * The current path feeds every byte into the frame tokenizer once, which records all
+ * tag offsets while the frame arrives, so the parser does not search at all. For
+ * comparison, the tag matcher is also run once over the complete frame.
+ *
+ * The result is reported in cycles per frame (time stamp counter on x86 hosts,
+ * nanoseconds elsewhere).
+ */
+
+#include "../../Command_Line_App/tag_matcher/tag_matcher.h"
+#include "../../Command_Line_App/frame_tokenizer/frame_tokenizer.h"
+#include "../../Command_Line_App/memory_utility/memory_utility.h"
+#include "bench_timer.h"
+#include <stdio.h>
+#include <string.h>
+
+#define BENCH_ITERATIONS   (uint32_t) 2000
+
+/*frames of increasing length, the last one fills most of the 256 byte receive buffer*/
+static const char *g_bench_frames[] =
+{
+    "<UCL><CMD>LightOn</CMD><PARAM>10</PARAM></UCL>",
+    "<UCL><CMD>GetHeater</CMD><PARAM>0123456789012345678901234567890123456789</PARAM></UCL>",
+    "<UCL><CMD>LightOn</CMD><PARAM>01234567890123456789012345678901234567890123456789"
+    "01234567890123456789012345678901234567890123456789012345678901234567890123456789"
+    "0123456789012345678901234567890123456789012345678901234567890123</PARAM></UCL>",
+    NULL
+};
+
+/*result sink, keeps the compiler from optimising the work away*/
+static volatile uintptr_t g_bench_sink;
+
+/**
+ * @brief find_tag_location as it was implemented before the tag matcher.
+ */
+static const char* legacy_find_tag_location(const char *xml, const char *tag, uint8_t kind_of_tag)
+{
+    char *formatted_tag = NULL;
+    const char *tag_location;
+
+    if(!xml || !tag || kind_of_tag > CLOSE_TAG)
+    {
+        return NULL;
+    }
+
+    formatted_tag = (char *) MemoryPool_Allocate();
+
+    if (!formatted_tag)
+    {
+        return NULL;
+    }
+
+    if (kind_of_tag == OPEN_TAG)
+    {
+        snprintf(formatted_tag, BLOCK_SIZE, "<%s>", tag);
+    }
+    else
+    {
+        snprintf(formatted_tag, BLOCK_SIZE, "</%s>", tag);
+    }
+
+    tag_location = strstr(xml, formatted_tag);
+
+    MemoryPool_Free((char *) formatted_tag);
+
+    return tag_location;
+}
+
+/**
+ * @brief Receives and parses one frame the legacy way.
+ */
+static void legacy_frame(const char *frame, char *buffer)
+{
+    size_t index = 0;
+
+    //ISR: store the byte, then search the whole buffer for </UCL>
+    for (index = 0; frame[index]; ++index)
+    {
+        buffer[index] = frame[index];
+        buffer[index + 1] = '\0';
+        g_bench_sink += (uintptr_t) legacy_find_tag_location(buffer, "UCL", CLOSE_TAG);
+    }
+
+    //parser: search for the command and parameter tags
+    g_bench_sink += (uintptr_t) legacy_find_tag_location(buffer, "CMD", OPEN_TAG);
+    g_bench_sink += (uintptr_t) legacy_find_tag_location(buffer, "CMD", CLOSE_TAG);
+    g_bench_sink += (uintptr_t) legacy_find_tag_location(buffer, "PARAM", OPEN_TAG);
+    g_bench_sink += (uintptr_t) legacy_find_tag_location(buffer, "PARAM", CLOSE_TAG);
+}
+
+/**
+ * @brief Receives one frame through the frame tokenizer.
+ */
+static void tokenizer_frame(const char *frame, char *buffer)
+{
+    struct FrameTokenizer tokenizer;
+    uint16_t index = 0;
+
+    frame_tokenizer_reset(&tokenizer);
+
+    //ISR: store the byte and feed it into the tokenizer, the parser reads the layout
+    for (index = 0; frame[index]; ++index)
+    {
+        buffer[index] = frame[index];
+        buffer[index + 1] = '\0';
+        g_bench_sink += (uintptr_t) frame_tokenizer_feed(&tokenizer, frame[index], index);
+    }
+
+    g_bench_sink += tokenizer.layout.tags.open[FRAME_TAG_CMD] + tokenizer.layout.args[0].value_length;
+}
+
+/**
+ * @brief Finds the first occurrence of every known tag of a complete frame in one scan.
+ */
+static void scan_tags(const char *xml, uint16_t length, struct FrameTagOffsets *offsets)
+{
+    struct TagMatcher matcher;
+    struct TagMatch match;
+    uint16_t offset = 0;
+
+    tag_matcher_reset(&matcher);
+    tag_matcher_reset_offsets(offsets);
+
+    for (offset = 0; offset < length && xml[offset]; ++offset)
+    {
+        if (tag_matcher_feed(&matcher, xml[offset], offset, &match) && match.tag < NO_OF_FRAME_TAGS)
+        {
+            if (match.kind_of_tag == OPEN_TAG && offsets->open[match.tag] == FRAME_TAG_NOT_FOUND)
+            {
+                offsets->open[match.tag] = match.end + 1;
+            }
+            else if (match.kind_of_tag == CLOSE_TAG && offsets->close[match.tag] == FRAME_TAG_NOT_FOUND)
+            {
+                offsets->close[match.tag] = match.start;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Finds all the tags of a complete frame with a single scan.
+ */
+static void scan_frame(const char *frame, char *buffer)
+{
+    struct FrameTagOffsets offsets;
+
+    (void) buffer;
+    scan_tags(frame, (uint16_t) strlen(frame), &offsets);
+    g_bench_sink += offsets.open[FRAME_TAG_CMD] + offsets.close[FRAME_TAG_PARAM];
+}
+
+/**
+ * @brief Runs a frame handler over a frame and returns the average cost per frame.
+ */
+static uint64_t measure(void (*handler)(const char *, char *), const char *frame)
+{
+    static char buffer[MEMORY_POOL_SIZE];
+    uint64_t start = 0;
+    uint32_t iteration = 0;
+
+    //warm up the caches once
+    handler(frame, buffer);
+
+    start = bench_timer_now();
+    for (iteration = 0; iteration < BENCH_ITERATIONS; ++iteration)
+    {
+        handler(frame, buffer);
+    }
+
+    return (bench_timer_now() - start) / BENCH_ITERATIONS;
+}
+
+int main(void)
+{
+    uint32_t frame = 0;
+    uint64_t legacy = 0;
+    uint64_t tokenizer = 0;
+    uint64_t scan = 0;
+
+    MemoryPool_Init();
+
+    printf("tag matching cost per frame (%s)\n", bench_timer_unit());
+    printf("%-8s %12s %12s %12s %9s\n", "length", "legacy", "tokenizer", "scan", "speedup");
+
+    for (frame = 0; g_bench_frames[frame]; ++frame)
+    {
+        legacy    = measure(legacy_frame, g_bench_frames[frame]);
+        tokenizer = measure(tokenizer_frame, g_bench_frames[frame]);
+        scan      = measure(scan_frame, g_bench_frames[frame]);
+
+        printf("%-8u %12llu %12llu %12llu %8.1fx\n", (unsigned) strlen(g_bench_frames[frame]),
+               (unsigned long long) legacy, (unsigned long long) tokenizer, (unsigned long long) scan,
+               (tokenizer != 0U) ? (double) legacy / (double) tokenizer : 0.0);
+    }
+
+    //the pool must be left untouched by the matcher
+    return (MemoryPool_GetFreeBlocks() == BLOCK_COUNT) ? 0 : 1;
+}
@@ -0,0 +1,45 @@
+/*
+ * bench_timer.h
+ *
+ * Cycle counter used by the host benchmarks. On x86 hosts the time stamp counter is
+ * read directly; on other hosts the monotonic clock is used and the results are
+ * reported in nanoseconds instead of cycles.
+ */
+
+#ifndef BENCH_TIMER_H
+#define BENCH_TIMER_H
+
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+
+static inline uint64_t bench_timer_now(void)
+{
+    return (uint64_t) __rdtsc();
+}
+
+static inline const char* bench_timer_unit(void)
+{
+    return "TSC cycles";
+}
+
+#else
+#include <time.h>
+
+static inline uint64_t bench_timer_now(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t) now.tv_sec * 1000000000ULL) + (uint64_t) now.tv_nsec;
+}
+
+static inline const char* bench_timer_unit(void)
+{
+    return "ns";
+}
+
+#endif
+
+#endif /* BENCH_TIMER_H */
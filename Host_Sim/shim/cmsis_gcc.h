@@ -0,0 +1,120 @@
+/*
+ * cmsis_gcc.h (host shim)
+ *
+ * Stand-in for the CMSIS core intrinsics when the command line core is compiled
+ * natively on the development host. core_cmInstr.h and core_cmFunc.h include this
+ * file for any GNU compiler; the host build puts this directory first on the include
+ * path so the Cortex-M3 instructions are replaced by host equivalents.
+ *
+ * PRIMASK is modelled as a plain variable so that the host programs can check that
+ * critical sections are entered and left as expected. Like cpsid and cpsie on the
+ * target, changing it is a compiler barrier: no memory access is moved into or out of
+ * a critical section. __WFI() hands the wait to a hook, so a simulated MCU can let the
+ * interrupt the firmware sleeps for arrive.
+ */
+
+#ifndef __CMSIS_GCC_H
+#define __CMSIS_GCC_H
+
+#include <stdint.h>
+
+/*modelled PRIMASK register, 1 while interrupts are masked*/
+volatile uint32_t g_host_primask __attribute__((weak)) = 0U;
+
+/*called by __WFI() in place of sleeping, the simulation lets time pass until the next
+  interrupt; NULL where nothing interrupts, where __WFI() returns at once*/
+void (*volatile g_host_wait_hook)(void) __attribute__((weak)) = 0;
+
+static inline void __enable_irq(void)
+{
+    __asm__ volatile ("" : : : "memory");
+    g_host_primask = 0U;
+}
+
+static inline void __disable_irq(void)
+{
+    g_host_primask = 1U;
+    __asm__ volatile ("" : : : "memory");
+}
+
+static inline uint32_t __get_PRIMASK(void)
+{
+    return g_host_primask;
+}
+
+static inline void __set_PRIMASK(uint32_t priMask)
+{
+    __asm__ volatile ("" : : : "memory");
+    g_host_primask = priMask & 1U;
+    __asm__ volatile ("" : : : "memory");
+}
+
+static inline void __NOP(void)
+{
+}
+
+static inline void __WFI(void)
+{
+    __asm__ volatile ("" : : : "memory");
+
+    if (g_host_wait_hook)
+    {
+        g_host_wait_hook();
+    }
+
+    __asm__ volatile ("" : : : "memory");
+}
+
+static inline void __WFE(void)
+{
+}
+
+static inline void __SEV(void)
+{
+}
+
+static inline void __ISB(void)
+{
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+static inline void __DSB(void)
+{
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+static inline void __DMB(void)
+{
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+static inline uint32_t __REV(uint32_t value)
+{
+    return __builtin_bswap32(value);
+}
+
+static inline uint32_t __REV16(uint32_t value)
+{
+    return ((value & 0x00FF00FFU) << 8) | ((value & 0xFF00FF00U) >> 8);
+}
+
+static inline uint32_t __RBIT(uint32_t value)
+{
+    uint32_t result = 0U;
+    uint32_t bit = 0U;
+
+    for (bit = 0U; bit < 32U; ++bit)
+    {
+        result = (result << 1) | (value & 1U);
+        value >>= 1;
+    }
+
+    return result;
+}
+
+static inline uint8_t __CLZ(uint32_t value)
+{
+    return (uint8_t)((value == 0U) ? 32U : (uint32_t)__builtin_clz(value));
+}
+
+#endif /* __CMSIS_GCC_H */
@@ -0,0 +1,265 @@
+/**
+ * @file dma_model.c
+ *
+ * @brief Behavioural model of the DMA1 channels, as used by the USART RX and TX requests.
+ *
+ * The firmware programs the channel registers, which are plain memory mapped by
+ * sim_mcu.c. The model performs the transfer a request triggers: it copies DR to the
+ * memory address the channel points at, or the byte at that address to the USART,
+ * counts CNDTR down, reloads it in circular mode and raises the half and full transfer
+ * flags. IFCR is write-one-to-clear on the
+ * target; the model applies and clears it before it looks at the flags.
+ *
+ * The firmware only defines the handlers of the channels it uses; the others are
+ * declared weak and a channel without a handler never interrupts.
+ *
+ * CMAR only holds 32 bits, so the simulation is linked at a fixed low address (-no-pie)
+ * where the buffers of the firmware can be reached through it.
+ */
+
+#include "dma_model.h"
+#include "../../HAL/HAL_ISR/UART_isr.h"
+#include <string.h>
+
+//flags of channel 1 in ISR and IFCR, every further channel has the same four bits 4 positions higher
+#define DMA_CHANNEL1_FLAGS  (uint32_t)(DMA_ISR_GIF1 | DMA_ISR_TCIF1 | DMA_ISR_HTIF1 | DMA_ISR_TEIF1)
+#define DMA_FLAG_SHIFT(channel_number)  (4U * ((uint32_t)(channel_number) - 1U))
+
+/**
+ * @brief Wiring of a modelled channel.
+ */
+struct DmaModelChannel
+{
+    DMA_Channel_TypeDef *regs;  /*registers of the channel*/
+    IRQn_Type irq;              /*its interrupt*/
+    void (*handler)(void);      /*its interrupt handler, NULL if the firmware has none*/
+};
+
+//only the handlers of the channels of a USART with a command line session are defined
+#pragma weak DMA1_Channel2_IRQHandler
+#pragma weak DMA1_Channel3_IRQHandler
+#pragma weak DMA1_Channel4_IRQHandler
+#pragma weak DMA1_Channel5_IRQHandler
+#pragma weak DMA1_Channel6_IRQHandler
+#pragma weak DMA1_Channel7_IRQHandler
+
+//the channels, indexed by their number - 1
+static const struct DmaModelChannel g_dma_channels[DMA_MODEL_CHANNELS] =
+{
+    { DMA1_Channel1, DMA1_Channel1_IRQn, NULL },
+    { DMA1_Channel2, DMA1_Channel2_IRQn, DMA1_Channel2_IRQHandler },
+    { DMA1_Channel3, DMA1_Channel3_IRQn, DMA1_Channel3_IRQHandler },
+    { DMA1_Channel4, DMA1_Channel4_IRQn, DMA1_Channel4_IRQHandler },
+    { DMA1_Channel5, DMA1_Channel5_IRQn, DMA1_Channel5_IRQHandler },
+    { DMA1_Channel6, DMA1_Channel6_IRQn, DMA1_Channel6_IRQHandler },
+    { DMA1_Channel7, DMA1_Channel7_IRQn, DMA1_Channel7_IRQHandler },
+};
+
+//counters of the current simulation, summed over the channels
+struct DmaModelStats g_dma_model_stats;
+
+//number of transfers every channel was programmed with, CNDTR is reloaded with it
+static uint32_t g_reload[DMA_MODEL_CHANNELS];
+
+//CNDTR as the model left it; any other value has been programmed by the firmware
+static uint32_t g_counter[DMA_MODEL_CHANNELS];
+
+/**
+ * @brief Forgets the channel state and clears the counters.
+ */
+void dma_model_reset(void)
+{
+    memset(g_reload, 0, sizeof(g_reload));
+    memset(g_counter, 0, sizeof(g_counter));
+    memset(&g_dma_model_stats, 0, sizeof(g_dma_model_stats));
+}
+
+/**
+ * @brief Applies the flags written to the write-one-to-clear IFCR register.
+ */
+static void apply_flag_clear(void)
+{
+    uint32_t clear = DMA1->IFCR;
+    uint8_t channel = 0;
+
+    //clearing the global flag of a channel clears all of its flags
+    for (channel = 1; channel <= DMA_MODEL_CHANNELS; ++channel)
+    {
+        if (clear & (DMA_ISR_GIF1 << DMA_FLAG_SHIFT(channel)))
+        {
+            clear |= DMA_CHANNEL1_FLAGS << DMA_FLAG_SHIFT(channel);
+        }
+    }
+
+    DMA1->ISR &= ~clear;
+    DMA1->IFCR = 0;
+}
+
+/**
+ * @brief Finds the memory address the next transfer of a channel reads or writes.
+ *
+ * The bits of CCR are the same in every channel.
+ *
+ * @param channel_number Channel mapped to the request, 1 to DMA_MODEL_CHANNELS.
+ * @param address Pointer that receives the address.
+ *
+ * @return true if the channel serves the request, false if it is disabled or has stopped.
+ */
+static bool next_transfer(uint8_t channel_number, uintptr_t *address)
+{
+    DMA_Channel_TypeDef *channel = g_dma_channels[channel_number - 1U].regs;
+    uint32_t *reload = &g_reload[channel_number - 1U];
+
+    if (!(channel->CCR & DMA_CCR1_EN))
+    {
+        return false;
+    }
+
+    //the firmware has programmed a new transfer count
+    if (channel->CNDTR != g_counter[channel_number - 1U])
+    {
+        *reload = channel->CNDTR;
+    }
+
+    //a normal mode transfer that has completed does not serve requests any more
+    if (channel->CNDTR == 0)
+    {
+        return false;
+    }
+
+    *address = (uintptr_t)channel->CMAR + ((channel->CCR & DMA_CCR1_MINC) ? (*reload - channel->CNDTR) : 0U);
+
+    return true;
+}
+
+/**
+ * @brief Counts a transfer of a channel and raises its half and full transfer flags.
+ *
+ * @param channel_number Channel mapped to the request, 1 to DMA_MODEL_CHANNELS.
+ */
+static void finish_transfer(uint8_t channel_number)
+{
+    DMA_Channel_TypeDef *channel = g_dma_channels[channel_number - 1U].regs;
+    const uint32_t shift = DMA_FLAG_SHIFT(channel_number);
+    const uint32_t reload = g_reload[channel_number - 1U];
+
+    --channel->CNDTR;
+    ++g_dma_model_stats.transfers;
+
+    if (channel->CNDTR == reload / 2U)
+    {
+        DMA1->ISR |= (DMA_ISR_GIF1 | DMA_ISR_HTIF1) << shift;
+    }
+
+    if (channel->CNDTR == 0)
+    {
+        DMA1->ISR |= (DMA_ISR_GIF1 | DMA_ISR_TCIF1) << shift;
+
+        if (channel->CCR & DMA_CCR1_CIRC)
+        {
+            channel->CNDTR = reload;
+        }
+    }
+
+    g_counter[channel_number - 1U] = channel->CNDTR;
+}
+
+/**
+ * @brief Serves the RX request of a USART: moves DR into memory.
+ *
+ * @param channel_number Channel mapped to the request, 1 to DMA_MODEL_CHANNELS.
+ *
+ * @return true if the channel took the byte, false if it is disabled or has stopped.
+ */
+bool dma_model_usart_rx(uint8_t channel_number)
+{
+    const DMA_Channel_TypeDef *channel = g_dma_channels[channel_number - 1U].regs;
+    uintptr_t address = 0;
+
+    if (!next_transfer(channel_number, &address))
+    {
+        return false;
+    }
+
+    *(volatile uint8_t *)address = (uint8_t)*(volatile uint32_t *)(uintptr_t)channel->CPAR;
+    finish_transfer(channel_number);
+
+    return true;
+}
+
+/**
+ * @brief Serves the TX request of a USART: reads the next byte to send from memory.
+ *
+ * @param channel_number Channel mapped to the request, 1 to DMA_MODEL_CHANNELS.
+ * @param value Pointer that receives the byte, the USART model writes it to DR.
+ *
+ * @return true if the channel delivered a byte, false if it is disabled or has stopped.
+ */
+bool dma_model_usart_tx(uint8_t channel_number, uint8_t *value)
+{
+    uintptr_t address = 0;
+
+    if (!next_transfer(channel_number, &address))
+    {
+        return false;
+    }
+
+    *value = *(volatile const uint8_t *)address;
+    finish_transfer(channel_number);
+
+    return true;
+}
+
+/**
+ * @brief Runs the handler of every channel for as long as the channel requests it.
+ */
+void dma_model_service(void)
+{
+    const struct DmaModelChannel *channel = NULL;
+    uint32_t shift = 0;
+    uint32_t pending = 0;
+    uint8_t number = 0;
+
+    for (number = 1; number <= DMA_MODEL_CHANNELS; ++number)
+    {
+        channel = &g_dma_channels[number - 1U];
+        shift = DMA_FLAG_SHIFT(number);
+
+        while (channel->handler != NULL)
+        {
+            apply_flag_clear();
+            pending = 0;
+
+            if (channel->regs->CCR & DMA_CCR1_TCIE)
+            {
+                pending |= DMA1->ISR & (DMA_ISR_TCIF1 << shift);
+            }
+
+            if (channel->regs->CCR & DMA_CCR1_HTIE)
+            {
+                pending |= DMA1->ISR & (DMA_ISR_HTIF1 << shift);
+            }
+
+            if (channel->regs->CCR & DMA_CCR1_TEIE)
+            {
+                pending |= DMA1->ISR & (DMA_ISR_TEIF1 << shift);
+            }
+
+            if (pending == 0 || !sim_irq_enter(channel->irq))
+            {
+                break;
+            }
+
+            ++g_dma_model_stats.isr_calls;
+            channel->handler();
+            sim_irq_exit();
+            apply_flag_clear();
+
+            //a handler that does not clear the flag would be entered again forever
+            if (DMA1->ISR & pending)
+            {
+                break;
+            }
+        }
+    }
+}
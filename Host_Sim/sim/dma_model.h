@@ -0,0 +1,28 @@
+#ifndef DMA_MODEL_H
+#define DMA_MODEL_H
+
+#include "sim_mcu.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define DMA_MODEL_CHANNELS  (uint8_t) 7   //channels of DMA1
+
+/**
+ * @brief Counters of what happened on the modelled DMA1 channels.
+ */
+struct DmaModelStats
+{
+    uint32_t transfers;   /*bytes moved between a USART and memory*/
+    uint32_t isr_calls;   /*calls of the channel interrupt handlers*/
+};
+
+//counters of the current simulation, summed over the channels
+extern struct DmaModelStats g_dma_model_stats;
+
+/*************function prototypes**********************/
+void dma_model_reset(void);
+bool dma_model_usart_rx(uint8_t channel_number);
+bool dma_model_usart_tx(uint8_t channel_number, uint8_t *value);
+void dma_model_service(void);
+
+#endif // DMA_MODEL_H
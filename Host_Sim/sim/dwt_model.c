@@ -0,0 +1,57 @@
+/**
+ * @file dwt_model.c
+ *
+ * @brief Behavioural model of the cycle counter of the Data Watchpoint and Trace unit.
+ *
+ * CYCCNT is plain memory mapped by sim_mcu.c. While CYCCNTENA is set, the model adds
+ * the core clock cycles of the simulated time that has passed since the last update,
+ * so the counter reads right whenever the firmware runs, after a poll of the main loop
+ * or a wake-up from __WFI(). A core without the counter is modelled by NOCYCCNT, which
+ * makes the firmware count its cycles from SysTick instead.
+ */
+
+#include "dwt_model.h"
+#include "../../HAL/HAL-RCC/inc/stm32f10x_rcc.h"
+
+//simulated time the counter was last brought up to
+static uint64_t g_synced_ns = 0;
+
+/**
+ * @brief Converts a simulated time to the core clock cycles counted up to it.
+ */
+static uint64_t cycles_at(uint64_t time_ns, uint32_t clock_hz)
+{
+    return (time_ns / SIM_NS_PER_S) * clock_hz + ((time_ns % SIM_NS_PER_S) * clock_hz) / SIM_NS_PER_S;
+}
+
+/**
+ * @brief Stops the counter, after sim_mcu_init() has cleared the registers.
+ *
+ * @param cycle_counter false to model a core without the cycle counter.
+ */
+void dwt_model_reset(bool cycle_counter)
+{
+    g_synced_ns = 0;
+
+    if (!cycle_counter)
+    {
+        DWT->CTRL |= DWT_CTRL_NOCYCCNT_Msk;
+    }
+}
+
+/**
+ * @brief Adds the cycles of the time passed since the last call to CYCCNT, if it counts.
+ */
+void dwt_model_sync(void)
+{
+    RCC_ClocksTypeDef clocks;
+
+    if ((DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk) && !(DWT->CTRL & DWT_CTRL_NOCYCCNT_Msk))
+    {
+        RCC_GetClocksFreq(&clocks);
+        DWT->CYCCNT += (uint32_t)(cycles_at(g_sim_time_ns, clocks.HCLK_Frequency) -
+                                  cycles_at(g_synced_ns, clocks.HCLK_Frequency));
+    }
+
+    g_synced_ns = g_sim_time_ns;
+}
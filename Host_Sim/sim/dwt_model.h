@@ -0,0 +1,12 @@
+#ifndef DWT_MODEL_H
+#define DWT_MODEL_H
+
+#include "sim_mcu.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/*************function prototypes**********************/
+void dwt_model_reset(bool cycle_counter);
+void dwt_model_sync(void);
+
+#endif // DWT_MODEL_H
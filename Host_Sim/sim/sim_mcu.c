@@ -0,0 +1,225 @@
+/**
+ * @file sim_mcu.c
+ *
+ * @brief Register-level model of the STM32F103 the command line core runs on.
+ *
+ * The firmware reaches the peripherals through the fixed addresses of stm32f10x.h and
+ * core_cm3.h, so the model maps plain memory at those addresses and the unmodified
+ * drivers read and write it. Registers behave like RAM; the behaviour that matters to
+ * the command line (USART2 flags, DMA transfers, SysTick, the cycle counter, NVIC
+ * enables, PRIMASK) is modelled by usart_model.c, dma_model.c, systick_model.c and
+ * dwt_model.c on top of it.
+ *
+ * Time is simulated: it only moves when the model is told a piece of work has taken
+ * some time, or when the firmware sleeps in __WFI() until the next interrupt, so a run
+ * is deterministic and independent of the speed of the host.
+ */
+
+#include "sim_mcu.h"
+#include "usart_model.h"
+#include "dma_model.h"
+#include "systick_model.h"
+#include "dwt_model.h"
+#include "../../Command_Line_App/UART_command_line/UART_Command_Line.h"
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#ifndef MAP_FIXED_NOREPLACE
+#define MAP_FIXED_NOREPLACE 0x100000
+#endif
+
+#define RCC_CFGR_AFTER_SYSTEMINIT  (uint32_t) 0x001D040A  //PLL from HSE x9 as system clock, APB1 at /2
+
+//simulated time since sim_mcu_init(), in nanoseconds
+uint64_t g_sim_time_ns;
+
+//true once the register regions are mapped
+static bool g_sim_mapped = false;
+
+//true while an interrupt handler runs; the modelled handlers share one priority and never nest
+static bool g_sim_in_isr = false;
+
+/**
+ * @brief Maps a register region at its fixed address.
+ *
+ * @param base Address of the region.
+ * @param size Size of the region in bytes.
+ *
+ * @return true if the region is mapped at the requested address.
+ */
+static bool map_region(uintptr_t base, size_t size)
+{
+    void *region = mmap((void *)base, size, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+
+    if (region == MAP_FAILED || region != (void *)base)
+    {
+        fprintf(stderr, "sim: can not map the registers at 0x%08lx\n", (unsigned long)base);
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Sleeps until the next event of the modelled peripherals, in place of __WFI().
+ *
+ * The core would wake up on any interrupt; the model lets time pass up to the next
+ * USART event or SysTick tick and runs the handlers due then.
+ */
+static void sim_wait_for_interrupt(void)
+{
+    uint64_t next = systick_model_next_event();
+    const uint64_t usart_next = usart_model_next_event();
+
+    if (usart_next < next)
+    {
+        next = usart_next;
+    }
+
+    //nothing would ever wake the core, the time of a poll passes instead of forever
+    if (next == UINT64_MAX)
+    {
+        next = g_sim_time_ns + SIM_POLL_COST_NS;
+    }
+
+    sim_advance((next > g_sim_time_ns) ? next - g_sim_time_ns : 0);
+}
+
+/**
+ * @brief Puts the modelled MCU into the state SystemInit() leaves it in.
+ *
+ * The first call maps the registers; later calls reset them, so one process can run
+ * any number of independent simulations.
+ *
+ * @param cycle_counter false to model a core without the DWT cycle counter.
+ *
+ * @return true if the MCU is ready, false if the registers could not be mapped.
+ */
+bool sim_mcu_init(bool cycle_counter)
+{
+    bool outcome = true;
+
+    if (!g_sim_mapped)
+    {
+        g_sim_mapped = map_region(SIM_PERIPH_BASE, SIM_PERIPH_SIZE) &&
+                       map_region(SIM_CORE_BASE, SIM_CORE_SIZE);
+        outcome = g_sim_mapped;
+    }
+    else
+    {
+        memset((void *)SIM_PERIPH_BASE, 0, SIM_PERIPH_SIZE);
+        memset((void *)SIM_CORE_BASE, 0, SIM_CORE_SIZE);
+    }
+
+    if (outcome)
+    {
+        //the clock tree the firmware finds when main() starts, 72 MHz core and 36 MHz APB1
+        RCC->CFGR = RCC_CFGR_AFTER_SYSTEMINIT;
+
+        g_sim_time_ns = 0;
+        g_host_primask = 0;
+        g_host_wait_hook = sim_wait_for_interrupt;
+        g_sim_in_isr = false;
+        usart_model_reset();
+        dma_model_reset();
+        systick_model_reset();
+        dwt_model_reset(cycle_counter);
+    }
+
+    return outcome;
+}
+
+/**
+ * @brief Enters an interrupt handler if the core would take the interrupt now.
+ *
+ * The enable bits of the NVIC are not modelled: ISER is plain memory here, where a write
+ * replaces the bits of the earlier writes instead of adding to them, so with more than
+ * one interrupt in a register only the last one enabled would be seen. The enable bits
+ * of the peripherals decide instead.
+ *
+ * @param irq The interrupt.
+ *
+ * @return true if PRIMASK does not mask the interrupt and no other handler is running;
+ *         sim_irq_exit() has to follow the handler.
+ */
+bool sim_irq_enter(IRQn_Type irq)
+{
+    if (g_host_primask != 0 || g_sim_in_isr)
+    {
+        return false;
+    }
+
+    g_sim_in_isr = true;
+
+    return true;
+}
+
+/**
+ * @brief Leaves the interrupt handler entered with sim_irq_enter().
+ */
+void sim_irq_exit(void)
+{
+    g_sim_in_isr = false;
+}
+
+/**
+ * @brief Runs the handlers of every modelled peripheral that requests an interrupt.
+ */
+void sim_service_interrupts(void)
+{
+    //the handlers see the counters at the time they run
+    systick_model_sync();
+    dwt_model_sync();
+
+
+    usart_model_service();
+    dma_model_service();
+    systick_model_service();
+}
+
+/**
+ * @brief Lets simulated time pass, delivering the received bytes and the SysTick
+ *        interrupts that are due.
+ *
+ * Called between the iterations of the main loop and while the firmware sleeps in
+ * __WFI(), so the interrupts preempt it just like on the target. A byte and a tick that
+ * fall on the same time are taken in that order.
+ *
+ * @param duration_ns Time to let pass.
+ */
+void sim_advance(uint64_t duration_ns)
+{
+    const uint64_t end = g_sim_time_ns + duration_ns;
+    uint64_t tick = 0;
+
+    while ((tick = systick_model_next_event()) <= end)
+    {
+        usart_model_run_until(tick);
+        systick_model_step();
+        sim_service_interrupts();
+    }
+
+    usart_model_run_until(end);
+
+    //the firmware goes on with the counters at the time it has slept until
+    systick_model_sync();
+    dwt_model_sync();
+}
+
+/**
+ * @brief Runs the main loop of the firmware for a while.
+ *
+ * @param duration_ns Time to run for.
+ */
+void sim_run(uint64_t duration_ns)
+{
+    uint64_t end = g_sim_time_ns + duration_ns;
+
+    while (g_sim_time_ns < end)
+    {
+        command_line_poll();
+        sim_advance(SIM_POLL_COST_NS);
+    }
+}
@@ -0,0 +1,30 @@
+#ifndef SIM_MCU_H
+#define SIM_MCU_H
+
+#include "../../HAL/HAL-SYSTEM/inc/stm32f10x.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SIM_PERIPH_BASE     (uintptr_t) 0x40000000  //APB1, APB2 and AHB peripherals
+#define SIM_PERIPH_SIZE     (size_t) 0x00030000
+#define SIM_CORE_BASE       (uintptr_t) 0xE0000000  //ITM, DWT and the system control space
+#define SIM_CORE_SIZE       (size_t) 0x00100000
+
+#define SIM_NS_PER_S        (uint64_t) 1000000000
+#define SIM_POLL_COST_NS    (uint64_t) 1000         //time one iteration of the main loop takes
+
+/*simulated time since sim_mcu_init(), in nanoseconds*/
+extern uint64_t g_sim_time_ns;
+
+/*modelled PRIMASK register, see shim/cmsis_gcc.h*/
+extern volatile uint32_t g_host_primask;
+
+/*************function prototypes**********************/
+bool sim_mcu_init(bool cycle_counter);
+bool sim_irq_enter(IRQn_Type irq);
+void sim_irq_exit(void);
+void sim_service_interrupts(void);
+void sim_advance(uint64_t duration_ns);
+void sim_run(uint64_t duration_ns);
+
+#endif // SIM_MCU_H
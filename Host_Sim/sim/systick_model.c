@@ -0,0 +1,148 @@
+/**
+ * @file systick_model.c
+ *
+ * @brief Behavioural model of the SysTick timer of the Cortex-M3 core.
+ *
+ * SysTick_Config() programs LOAD, VAL and CTRL, which are plain memory mapped by
+ * sim_mcu.c. While the timer is enabled the model counts LOAD + 1 cycles of the core
+ * clock, or of the core clock divided by 8 without CLKSOURCE, per period; at the end of
+ * every period it sets COUNTFLAG and, with TICKINT, requests SysTick_Handler. VAL is
+ * brought up to the simulated time by systick_model_sync() whenever the firmware runs,
+ * so it reads the counts left to the next wrap, as on the target.
+ */
+
+#include "systick_model.h"
+#include "../../HAL/HAL-RCC/inc/stm32f10x_rcc.h"
+#include "../../HAL/HAL-SYSTICK/inc/hal_systick_config.h"
+#include <string.h>
+
+#define SYSTICK_EXTERNAL_DIVIDER  (uint64_t) 8   //the reference clock without CLKSOURCE is HCLK / 8
+
+//counters of the current simulation
+struct SysTickModelStats g_systick_model_stats;
+
+//time the running counter reaches zero next, 0 while the timer is stopped
+static uint64_t g_next_wrap_ns = 0;
+
+//true while the exception is requested and has not been taken yet
+static bool g_pending = false;
+
+/**
+ * @brief Stops the timer and clears the counters.
+ */
+void systick_model_reset(void)
+{
+    g_next_wrap_ns = 0;
+    g_pending = false;
+    memset(&g_systick_model_stats, 0, sizeof(g_systick_model_stats));
+}
+
+/**
+ * @brief Returns the clock the timer counts with the current settings.
+ *
+ * @return uint64_t The clock in Hz, 0 if it is not configured.
+ */
+static uint64_t counter_clock_hz(void)
+{
+    RCC_ClocksTypeDef clocks;
+    uint64_t clock_hz = 0;
+
+    RCC_GetClocksFreq(&clocks);
+    clock_hz = clocks.HCLK_Frequency;
+
+    if (!(SysTick->CTRL & SysTick_CTRL_CLKSOURCE_Msk))
+    {
+        clock_hz /= SYSTICK_EXTERNAL_DIVIDER;
+    }
+
+    return clock_hz;
+}
+
+/**
+ * @brief Computes one period of the timer with the current settings.
+ *
+ * @return uint64_t The period in nanoseconds, 0 if the clock is not configured.
+ */
+static uint64_t period_ns(void)
+{
+    const uint64_t clock_hz = counter_clock_hz();
+
+    return (clock_hz == 0) ? 0 : (((uint64_t)(SysTick->LOAD & SysTick_LOAD_RELOAD_Msk) + 1U) * SIM_NS_PER_S) / clock_hz;
+}
+
+/**
+ * @brief Returns the time the counter reaches zero next.
+ *
+ * A timer the firmware has just enabled starts counting now.
+ *
+ * @return uint64_t Time of the next wrap, UINT64_MAX while the timer is stopped.
+ */
+uint64_t systick_model_next_event(void)
+{
+    uint64_t period = 0;
+
+    if (!(SysTick->CTRL & SysTick_CTRL_ENABLE_Msk) || (period = period_ns()) == 0)
+    {
+        g_next_wrap_ns = 0;
+        return UINT64_MAX;
+    }
+
+    if (g_next_wrap_ns == 0)
+    {
+        g_next_wrap_ns = g_sim_time_ns + period;
+    }
+
+    return g_next_wrap_ns;
+}
+
+/**
+ * @brief Reloads the counter at the time returned by systick_model_next_event().
+ */
+void systick_model_step(void)
+{
+    if (g_next_wrap_ns == 0)
+    {
+        return;
+    }
+
+    ++g_systick_model_stats.wraps;
+    SysTick->CTRL |= SysTick_CTRL_COUNTFLAG_Msk;
+
+    if (SysTick->CTRL & SysTick_CTRL_TICKINT_Msk)
+    {
+        g_pending = true;
+    }
+
+    g_next_wrap_ns += period_ns();
+}
+
+/**
+ * @brief Sets VAL to the counts left until the running counter reaches zero next.
+ */
+void systick_model_sync(void)
+{
+    const uint32_t reload = SysTick->LOAD & SysTick_LOAD_RELOAD_Msk;
+    uint64_t counts = 0;
+
+    if (g_next_wrap_ns == 0 || g_next_wrap_ns < g_sim_time_ns)
+    {
+        return;
+    }
+
+    counts = ((g_next_wrap_ns - g_sim_time_ns) * counter_clock_hz()) / SIM_NS_PER_S;
+    SysTick->VAL = (counts < reload) ? (uint32_t)counts : reload;
+}
+
+/**
+ * @brief Runs SysTick_Handler if the exception is requested and the core would take it now.
+ */
+void systick_model_service(void)
+{
+    if (g_pending && sim_irq_enter(SysTick_IRQn))
+    {
+        g_pending = false;
+        ++g_systick_model_stats.isr_calls;
+        SysTick_Handler();
+        sim_irq_exit();
+    }
+}
@@ -0,0 +1,27 @@
+#ifndef SYSTICK_MODEL_H
+#define SYSTICK_MODEL_H
+
+#include "sim_mcu.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * @brief Counters of what happened on the modelled SysTick timer.
+ */
+struct SysTickModelStats
+{
+    uint32_t wraps;       /*times the counter reached zero and was reloaded*/
+    uint32_t isr_calls;   /*calls of SysTick_Handler*/
+};
+
+//counters of the current simulation
+extern struct SysTickModelStats g_systick_model_stats;
+
+/*************function prototypes**********************/
+void systick_model_reset(void);
+uint64_t systick_model_next_event(void);
+void systick_model_step(void);
+void systick_model_sync(void);
+void systick_model_service(void);
+
+#endif // SYSTICK_MODEL_H
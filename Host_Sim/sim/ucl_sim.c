@@ -0,0 +1,355 @@
+/**
+ * @file ucl_sim.c
+ *
+ * @brief Runs the command line firmware on the host against simulated USARTs.
+ *
+ * The bytes of the input files are sent to the receiver at the configured baud rate,
+ * the main loop runs in simulated time and everything the firmware transmits is
+ * written to stdout. A run is fully deterministic, which makes the program the base
+ * for regression scenarios, benchmarks and fuzzing.
+ *
+ *     ucl_sim [-l] [-b baud] [-f] [-c] [-g gap_us] [-i idle_ms] [-v] [[port:]file...]
+ *
+ *     -l          every line of a file is a separate burst, the newline is not sent
+ *     -b baud     rate the bytes are sent at, the rate the firmware starts with by default
+ *     -f          the sender honours RTS and stops while it is high
+ *     -c          the core has no DWT cycle counter, the firmware counts cycles from SysTick
+ *     -g gap_us   idle time after every byte, 0 sends the bytes back to back
+ *     -i idle_ms  idle time between bursts
+ *     -v          print the counters of the simulation to stderr
+ *
+ * Without files the bytes are read from stdin. With -l, a line "@baud <rate>" is not
+ * sent; the lines after it are sent at the new rate, as a client does after SetBaud. A
+ * line "@noise <n>" is not sent either; byte n of the next line, counted from 1, is
+ * received with a noise error.
+ *
+ * Files are sent to USART2. A file prefixed with "1:" or "3:" is sent to USART1 or
+ * USART3 at the same time, and what the firmware answers there is printed after the
+ * output of USART2, under a line "--- USARTn ---".
+ */
+
+#include "sim_mcu.h"
+#include "usart_model.h"
+#include "dma_model.h"
+#include "systick_model.h"
+#include "../../HAL/HAL-SYSTEM/inc/HAL_Common.h"
+#include "../../Command_Line_App/memory_utility/memory_utility.h"
+#include "../../Command_Line_App/command_line_port/command_line_port.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define SIM_NS_PER_US       (uint64_t) 1000
+#define SIM_NS_PER_MS       (uint64_t) 1000000
+#define SIM_DEFAULT_IDLE_MS (uint64_t) 100
+#define SIM_QUIET_MS        (uint64_t) 50     //the run ends after this long without any transmission
+#define SIM_MAX_INPUT       (size_t) 65536
+#define SIM_BAUD_DIRECTIVE  "@baud "          //a line switching the rate the following lines are sent at
+#define SIM_NOISE_DIRECTIVE "@noise "         //a line giving the byte of the next line received with a noise error
+#define SIM_MAIN_PORT       USART_PORT_2      //the USART stdin and files without a prefix are sent to
+
+/**
+ * @brief Settings taken from the command line.
+ */
+struct SimOptions
+{
+    bool     split_lines;   /*send every line as a separate burst*/
+    uint64_t gap_ns;        /*idle time after every byte*/
+    uint64_t idle_ns;       /*idle time between bursts*/
+    bool     verbose;       /*print the counters at the end*/
+};
+
+/**
+ * @brief Schedules one burst of bytes after the bursts scheduled so far.
+ *
+ * @param port The USART the burst is sent to.
+ * @param data Pointer to the bytes.
+ * @param length Number of bytes.
+ * @param options The settings.
+ * @param start_ns Pointer to the earliest start of the burst, moved past its end.
+ */
+static void schedule_burst(UsartPort_t port, const uint8_t *data, size_t length,
+                           const struct SimOptions *options, uint64_t *start_ns)
+{
+    uint64_t char_time = usart_model_line_char_time_ns(port);
+
+    if (length > 0)
+    {
+        usart_model_schedule_rx(port, data, (uint32_t)length, *start_ns, options->gap_ns);
+        *start_ns += length * (char_time + options->gap_ns) + options->idle_ns;
+    }
+}
+
+/**
+ * @brief Schedules the content of a file.
+ *
+ * @param port The USART the file is sent to.
+ * @param stream The file.
+ * @param options The settings.
+ * @param start_ns Pointer to the earliest start of the next burst.
+ *
+ * @return 0 on success, 1 if the file is too big.
+ */
+static int schedule_file(UsartPort_t port, FILE *stream, const struct SimOptions *options, uint64_t *start_ns)
+{
+    static uint8_t input[SIM_MAX_INPUT];
+    size_t length = fread(input, 1, sizeof(input), stream);
+    size_t line_start = 0;
+    size_t index = 0;
+    size_t noisy_byte = 0;   //byte of the next line received with a noise error, counted from 1, 0 for none
+
+    if (!feof(stream))
+    {
+        fprintf(stderr, "ucl_sim: input longer than %u bytes\n", (unsigned)SIM_MAX_INPUT);
+        return 1;
+    }
+
+    if (!options->split_lines)
+    {
+        schedule_burst(port, input, length, options, start_ns);
+        return 0;
+    }
+
+    for (index = 0; index <= length; ++index)
+    {
+        if (index == length || input[index] == '\n')
+        {
+            if (index - line_start > strlen(SIM_BAUD_DIRECTIVE) &&
+                memcmp(&input[line_start], SIM_BAUD_DIRECTIVE, strlen(SIM_BAUD_DIRECTIVE)) == 0)
+            {
+                usart_model_set_line_rate(port,
+                                          (uint32_t)strtoul((const char *)&input[line_start + strlen(SIM_BAUD_DIRECTIVE)],
+                                                            NULL, 10));
+            }
+            else if (index - line_start > strlen(SIM_NOISE_DIRECTIVE) &&
+                     memcmp(&input[line_start], SIM_NOISE_DIRECTIVE, strlen(SIM_NOISE_DIRECTIVE)) == 0)
+            {
+                noisy_byte = (size_t)strtoul((const char *)&input[line_start + strlen(SIM_NOISE_DIRECTIVE)], NULL, 10);
+            }
+            else
+            {
+                schedule_burst(port, &input[line_start], index - line_start, options, start_ns);
+
+                if (noisy_byte != 0 && noisy_byte <= index - line_start)
+                {
+                    (void)usart_model_corrupt_rx(port, (uint32_t)(index - line_start - noisy_byte));
+                }
+                noisy_byte = 0;
+            }
+            line_start = index + 1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Splits a file argument into the USART it is sent to and the name of the file.
+ *
+ * @param argument The argument, "1:name" or "3:name" for USART1 or USART3.
+ * @param path Pointer that receives the name of the file.
+ *
+ * @return UsartPort_t The USART, SIM_MAIN_PORT without a prefix.
+ */
+static UsartPort_t file_port(const char *argument, const char **path)
+{
+    UsartPort_t port = SIM_MAIN_PORT;
+
+    *path = argument;
+
+    if (argument[0] >= '1' && argument[0] <= '3' && argument[1] == ':')
+    {
+        port = (UsartPort_t)(argument[0] - '1');
+        *path = &argument[2];
+    }
+
+    return port;
+}
+
+/**
+ * @brief Checks whether the run is over.
+ *
+ * @return true once every byte has been received on every USART, every frame has been
+ *         answered and the firmware has stopped answering on all of them.
+ */
+static bool run_finished(void)
+{
+    uint64_t last_tx_ns = 0;
+    uint8_t port = 0;
+
+    for (port = 0; port < (uint8_t)USART_PORT_COUNT; ++port)
+    {
+        if (!usart_model_rx_idle((UsartPort_t)port) || !usart_model_tx_idle((UsartPort_t)port))
+        {
+            return false;
+        }
+
+        //a frame not executed yet or a reply still queued is answered later
+        if (g_command_line_ports[port] != NULL &&
+            (frame_ring_waiting(&g_command_line_ports[port]->frames) != 0 || !HAL_USART_TxIdle((UsartPort_t)port)))
+        {
+            return false;
+        }
+
+        if (g_usart_model_stats[port].last_tx_ns > last_tx_ns)
+        {
+            last_tx_ns = g_usart_model_stats[port].last_tx_ns;
+        }
+    }
+
+    return g_sim_time_ns >= last_tx_ns + SIM_QUIET_MS * SIM_NS_PER_MS;
+}
+
+/**
+ * @brief Prints the counters of a USART and of its command line session to stderr.
+ *
+ * @param port The USART.
+ */
+static void print_port_stats(UsartPort_t port)
+{
+    const struct UsartModelStats *stats = &g_usart_model_stats[port];
+    const struct CommandLinePort *session = g_command_line_ports[port];
+
+    fprintf(stderr, "USART%u: rx %u bytes, %u overruns, tx %u bytes, %u interrupts, %u replies dropped\n",
+            (unsigned)port + 1U, stats->rx_delivered, stats->rx_overruns, stats->tx_bytes, stats->isr_calls,
+            (unsigned)session->replies.dropped);
+    fprintf(stderr, "USART%u frame ring: %u of %u slots used at most, %u frames dropped, %u frames too long\n",
+            (unsigned)port + 1U, (unsigned)session->frames.high_water, (unsigned)FRAME_RING_SLOTS,
+            (unsigned)session->frames.dropped, (unsigned)session->frames.overflowed);
+    fprintf(stderr, "USART%u receive timeouts: %u inter-byte, %u whole frame\n",
+            (unsigned)port + 1U, (unsigned)session->rx_stats.inter_byte_timeouts,
+            (unsigned)session->rx_stats.frame_timeouts);
+    fprintf(stderr, "USART%u line errors: %u overruns, %u framing, %u noise, %u parity, %u frames corrupted\n",
+            (unsigned)port + 1U, (unsigned)session->rx_stats.overruns, (unsigned)session->rx_stats.framing_errors,
+            (unsigned)session->rx_stats.noise_errors, (unsigned)session->rx_stats.parity_errors,
+            (unsigned)session->rx_stats.corrupted_frames);
+    fprintf(stderr, "USART%u baud rate: %u at the end, %u switches undone, %u bytes sent at another rate\n",
+            (unsigned)port + 1U, (unsigned)HAL_USART_GetBaudRate(port), (unsigned)session->baud_switch.fallbacks,
+            stats->rx_mismatched);
+    fprintf(stderr, "USART%u flow control: sender stopped %u times by RTS, held for %.3f ms\n",
+            (unsigned)port + 1U, stats->rts_stops, (double)stats->rts_held_ns / SIM_NS_PER_MS);
+}
+
+int main(int argc, char **argv)
+{
+    struct SimOptions options = { false, 0, SIM_DEFAULT_IDLE_MS * SIM_NS_PER_MS, false };
+    uint32_t line_rate = 0;
+    bool flow_control = false;
+    bool cycle_counter = true;
+    uint64_t start_ns[USART_PORT_COUNT] = { 0 };
+    bool port_used[USART_PORT_COUNT] = { false };
+    FILE *captures[USART_PORT_COUNT] = { NULL };
+    FILE *stream = NULL;
+    const char *path = NULL;
+    UsartPort_t port = SIM_MAIN_PORT;
+    uint8_t index = 0;
+    int option = 0;
+    int character = 0;
+    int outcome = 0;
+
+    while ((option = getopt(argc, argv, "lb:fcg:i:v")) != -1)
+    {
+        switch (option)
+        {
+            case 'l': options.split_lines = true; break;
+            case 'b': line_rate = (uint32_t)strtoul(optarg, NULL, 10); break;
+            case 'f': flow_control = true; break;
+            case 'c': cycle_counter = false; break;
+            case 'g': options.gap_ns = strtoull(optarg, NULL, 10) * SIM_NS_PER_US; break;
+            case 'i': options.idle_ns = strtoull(optarg, NULL, 10) * SIM_NS_PER_MS; break;
+            case 'v': options.verbose = true; break;
+            default:
+                fprintf(stderr, "usage: %s [-l] [-b baud] [-f] [-c] [-g gap_us] [-i idle_ms] [-v] [[port:]file...]\n",
+                        argv[0]);
+                return 2;
+        }
+    }
+
+    if (!sim_mcu_init(cycle_counter))
+    {
+        return 1;
+    }
+
+    //the same start-up as main() of the firmware
+    HAL_config_MCU();
+    MemoryPool_Init();
+
+    for (index = 0; index < (uint8_t)USART_PORT_COUNT; ++index)
+    {
+        //USART2 replies straight to stdout, the others are collected and printed after it
+        captures[index] = (index == (uint8_t)SIM_MAIN_PORT) ? stdout : tmpfile();
+        usart_model_capture((UsartPort_t)index, captures[index]);
+
+        //the client starts at the rate the firmware starts with and keeps its rate when the firmware switches
+        usart_model_set_line_rate((UsartPort_t)index,
+                                  (line_rate != 0) ? line_rate : HAL_USART_GetBaudRate((UsartPort_t)index));
+        usart_model_set_flow_control((UsartPort_t)index, flow_control);
+    }
+
+    if (optind == argc)
+    {
+        port_used[SIM_MAIN_PORT] = true;
+        outcome = schedule_file(SIM_MAIN_PORT, stdin, &options, &start_ns[SIM_MAIN_PORT]);
+    }
+
+    for (; optind < argc && outcome == 0; ++optind)
+    {
+        port = file_port(argv[optind], &path);
+        stream = fopen(path, "rb");
+
+        if (!stream)
+        {
+            perror(path);
+            return 1;
+        }
+
+        //every USART has a line of its own, the files of one USART follow each other
+        port_used[port] = true;
+        outcome = schedule_file(port, stream, &options, &start_ns[port]);
+        fclose(stream);
+    }
+
+    //run until every byte has been received and the firmware has stopped answering
+    while (outcome == 0 && !run_finished())
+    {
+        sim_run(SIM_NS_PER_MS);
+    }
+
+    for (index = 0; index < (uint8_t)USART_PORT_COUNT; ++index)
+    {
+        if (index == (uint8_t)SIM_MAIN_PORT || !port_used[index] || !captures[index])
+        {
+            continue;
+        }
+
+        printf("--- USART%u ---\n", (unsigned)index + 1U);
+        rewind(captures[index]);
+
+        while ((character = fgetc(captures[index])) != EOF)
+        {
+            putchar(character);
+        }
+
+        fclose(captures[index]);
+    }
+
+    fflush(stdout);
+
+    if (options.verbose)
+    {
+        fprintf(stderr, "time %.3f ms, %u DMA and %u SysTick interrupts\n",
+                (double)g_sim_time_ns / SIM_NS_PER_MS, g_dma_model_stats.isr_calls,
+                g_systick_model_stats.isr_calls);
+
+        for (index = 0; index < (uint8_t)USART_PORT_COUNT; ++index)
+        {
+            if (g_command_line_ports[index] != NULL)
+            {
+                print_port_stats((UsartPort_t)index);
+            }
+        }
+    }
+
+    return outcome;
+}
@@ -0,0 +1,894 @@
+/**
+ * @file usart_model.c
+ *
+ * @brief Behavioural model of USART1, USART2 and USART3 for the host simulation.
+ *
+ * The registers themselves are plain memory mapped by sim_mcu.c, so USART_Init(),
+ * USART_ITConfig() and USART_GetFlagStatus() of the unmodified driver work on them.
+ * Only the accesses with side effects on the target are replaced, by linking with
+ * --wrap: reading DR clears the receive flags, writing DR transmits a byte and writing
+ * SR only clears the flags that are written 0 and can be cleared that way.
+ *
+ * The transmitter has DR and a shift register. A byte written to DR clears TXE and TC
+ * and moves on into the shift register as soon as it is free, which sets TXE again.
+ * When the stop bit of the shifted byte ends the byte is captured, and the next one
+ * moves in from DR or, with DR empty, TC is set. Transmission takes its time while the
+ * firmware goes on. With DMA transmission TXE requests the next byte from the DMA
+ * channel; a byte the DMA writes clears TXE but not TC.
+ *
+ * Received bytes are scheduled with the time their stop bit ends. When that time is
+ * reached the byte goes to the DMA if the USART issues DMA requests; otherwise it lands
+ * in DR and raises RXNE, or raises ORE and is lost if the previous byte has not been
+ * read yet. A whole idle character after the last byte raises IDLE. The interrupt
+ * handler of the USART runs whenever an enabled flag is set and the interrupt is not
+ * masked. Every USART has a line of its own; the events of the receivers and the
+ * transmitters are taken in time order.
+ *
+ * The other end of the line either follows whatever rate the firmware configures or
+ * sends at a rate of its own, see usart_model_set_line_rate(). A byte sent at a rate
+ * more than USART_MODEL_RATE_TOLERANCE_PPM away from the rate of the receiver is
+ * received as garbage with a framing error, as on the target. A byte can also be marked
+ * to arrive with a noise error, see usart_model_corrupt_rx(). With DMA reception the
+ * error flags interrupt through EIE, as on the target.
+ *
+ * A sender with flow control finishes the byte it is sending when RTS goes high
+ * and starts no other until RTS is low again; every byte after that arrives later by
+ * the time the sender was held. The GPIO registers are plain memory too, so the model
+ * applies the writes to BSRR and BRR to ODR itself.
+ *
+ * The firmware only defines the handlers of the USARTs that run a command line
+ * session; the others are declared weak and a USART without a handler never
+ * interrupts.
+ */
+
+#include "usart_model.h"
+#include "dma_model.h"
+#include "../../HAL/HAL-RCC/inc/stm32f10x_rcc.h"
+#include "../../HAL/HAL-UART/inc/stm32f10x_usart.h"
+#include "../../HAL/HAL-GPIO/inc/hal_gpio_config.h"
+#include "../../HAL/HAL_ISR/UART_isr.h"
+#include <string.h>
+
+#define USART_RX_FLAGS   (uint16_t)(USART_SR_RXNE | USART_SR_IDLE | USART_SR_ORE | USART_SR_NE | USART_SR_FE | USART_SR_PE)
+#define USART_DR_MASK    (uint16_t) 0x01FF
+
+#define USART_MODEL_RATE_TOLERANCE_PPM  (int64_t) 37500   //deviation the receiver samples a whole byte through
+#define USART_MODEL_LINE_BITS           (uint64_t) 10     //the other end sends 8N1
+#define USART_MODEL_PPM                 (int64_t) 1000000
+
+/**
+ * @brief Byte waiting on the line of the modelled receiver.
+ */
+struct ScheduledByte
+{
+    uint64_t time_ns;   /*time the byte is complete in the receiver*/
+    uint32_t baud_rate; /*rate the byte was sent at, 0 if at the rate of the receiver*/
+    uint8_t  value;     /*the byte*/
+    bool     noisy;     /*true if the receiver samples the byte with a noise error*/
+};
+
+/**
+ * @brief Wiring of a modelled USART.
+ */
+struct UsartModelHardware
+{
+    USART_TypeDef *regs;        /*registers of the USART*/
+    IRQn_Type irq;              /*its interrupt*/
+    void (*handler)(void);      /*its interrupt handler, NULL if the firmware has none*/
+    uint8_t dma_channel;        /*DMA1 channel of its RX request*/
+    uint8_t tx_dma_channel;     /*DMA1 channel of its TX request*/
+    bool on_apb2;               /*true if PCLK2 clocks it, PCLK1 otherwise*/
+    GPIO_TypeDef *rts_gpio;     /*port of its RTS pin*/
+    uint16_t rts_pin;           /*its RTS pin*/
+};
+
+/**
+ * @brief State of a modelled USART and of the other end of its line.
+ */
+struct UsartModel
+{
+    struct ScheduledByte schedule[USART_MODEL_RX_QUEUE]; /*bytes on their way to the receiver, in the order they arrive*/
+    uint32_t head;             /*next entry of the schedule to write*/
+    uint32_t tail;             /*next byte to arrive*/
+    FILE *tx_stream;           /*stream receiving the transmitted bytes, NULL to drop them*/
+    uint64_t idle_at_ns;       /*time the line has been idle for a whole character after the last byte, 0 if not pending*/
+    uint32_t line_rate;        /*rate the other end sends at, 0 if it follows the receiver*/
+    bool flow_control;         /*true if the other end stops sending while RTS is high*/
+    bool rts_stopped;          /*true while RTS holds the sender, since rts_stop_ns*/
+    uint64_t rts_stop_ns;
+    uint64_t rx_delay_ns;      /*time the scheduled bytes have been held back by RTS, added to their scheduled time*/
+    uint64_t next_byte_ns;     /*time the next byte arrives as of the last look at the line, UINT64_MAX if none*/
+    uint64_t next_rx_ns;       /*time of the next receive event as of the last look at the line*/
+    bool tx_shifting;          /*true while the shift register sends tx_shift_value, until tx_done_ns*/
+    uint8_t tx_shift_value;
+    uint64_t tx_done_ns;
+    bool tx_dr_full;           /*true while DR holds tx_dr_value for the shift register, TXE is clear*/
+    uint8_t tx_dr_value;
+    uint32_t tx_written;       /*bytes written to DR*/
+};
+
+//only the handlers of the USARTs with a command line session are defined
+#pragma weak USART1_IRQHandler
+#pragma weak USART2_IRQHandler
+#pragma weak USART3_IRQHandler
+
+//the modelled USARTs, indexed by UsartPort_t
+static const struct UsartModelHardware g_usart_hardware[USART_PORT_COUNT] =
+{
+    { USART1, USART1_IRQn, USART1_IRQHandler, 5U, 4U, true,  GPIOA, USART1_RTS_PIN },
+    { USART2, USART2_IRQn, USART2_IRQHandler, 6U, 7U, false, GPIOA, USART2_RTS_PIN },
+    { USART3, USART3_IRQn, USART3_IRQHandler, 3U, 2U, false, GPIOB, USART3_RTS_PIN },
+};
+
+//counters of the current simulation, indexed by UsartPort_t
+struct UsartModelStats g_usart_model_stats[USART_PORT_COUNT];
+
+//state of the modelled USARTs, indexed by UsartPort_t
+static struct UsartModel g_usart_models[USART_PORT_COUNT];
+
+/*the real driver functions, called through the linker wrappers*/
+uint16_t __real_USART_ReceiveData(USART_TypeDef *USARTx);
+void __real_USART_SendData(USART_TypeDef *USARTx, uint16_t Data);
+
+static void write_dr(UsartPort_t port, uint8_t value);
+
+/**
+ * @brief Moves simulated time forward to an event.
+ *
+ * @param time_ns Time of the event; time never goes backwards.
+ */
+static void advance_to(uint64_t time_ns)
+{
+    if (time_ns > g_sim_time_ns)
+    {
+        g_sim_time_ns = time_ns;
+    }
+}
+
+/**
+ * @brief Checks whether the receiver samples the line.
+ *
+ * @param port The USART.
+ *
+ * @return true if the USART and its receiver are enabled.
+ */
+static bool receiver_enabled(UsartPort_t port)
+{
+    return (g_usart_hardware[port].regs->CR1 & (USART_CR1_UE | USART_CR1_RE)) == (USART_CR1_UE | USART_CR1_RE);
+}
+
+/**
+ * @brief Forgets the scheduled bytes and clears the counters.
+ */
+void usart_model_reset(void)
+{
+    uint8_t port = 0;
+
+    for (port = 0; port < (uint8_t)USART_PORT_COUNT; ++port)
+    {
+        //the capture stream is chosen once per process
+        FILE *tx_stream = g_usart_models[port].tx_stream;
+
+        memset(&g_usart_models[port], 0, sizeof(g_usart_models[port]));
+        g_usart_models[port].tx_stream = tx_stream;
+        memset(&g_usart_model_stats[port], 0, sizeof(g_usart_model_stats[port]));
+
+        //transmitter empty and idle after reset
+        g_usart_hardware[port].regs->SR = USART_SR_TXE | USART_SR_TC;
+    }
+}
+
+/**
+ * @brief Selects the stream the bytes transmitted on a USART are written to.
+ *
+ * @param port The USART.
+ * @param stream The stream, NULL to drop the transmitted bytes.
+ */
+void usart_model_capture(UsartPort_t port, FILE *stream)
+{
+    g_usart_models[port].tx_stream = stream;
+}
+
+/**
+ * @brief Sets the baud rate the other end sends the bytes scheduled from now on at.
+ *
+ * @param port The USART.
+ * @param baud_rate The rate, 0 to follow the rate the firmware configures.
+ */
+void usart_model_set_line_rate(UsartPort_t port, uint32_t baud_rate)
+{
+    g_usart_models[port].line_rate = baud_rate;
+}
+
+/**
+ * @brief Selects whether the other end honours RTS.
+ *
+ * @param port The USART.
+ * @param honour_rts true if the sender stops while RTS is high.
+ */
+void usart_model_set_flow_control(UsartPort_t port, bool honour_rts)
+{
+    g_usart_models[port].flow_control = honour_rts;
+}
+
+/**
+ * @brief Returns the frequency of the clock of a USART.
+ *
+ * @param port The USART.
+ *
+ * @return uint32_t PCLK2 for USART1, PCLK1 for the others.
+ */
+static uint32_t peripheral_clock(UsartPort_t port)
+{
+    RCC_ClocksTypeDef clocks;
+
+    RCC_GetClocksFreq(&clocks);
+
+    return g_usart_hardware[port].on_apb2 ? clocks.PCLK2_Frequency : clocks.PCLK1_Frequency;
+}
+
+/**
+ * @brief Computes the baud rate the receiver runs at with the current settings.
+ *
+ * @param port The USART.
+ *
+ * @return uint32_t The rate, 0 if the receiver is not configured.
+ */
+static uint32_t receiver_rate(UsartPort_t port)
+{
+    const uint32_t brr = g_usart_hardware[port].regs->BRR;
+
+    return (brr == 0) ? 0 : peripheral_clock(port) / brr;
+}
+
+/**
+ * @brief Computes how long one character takes on the line with the current settings.
+ *
+ * Baud rate, word length and stop bits are read back from BRR, CR1 and CR2, so the
+ * timing follows whatever the firmware has configured.
+ *
+ * @param port The USART.
+ *
+ * @return uint64_t Time of one character in nanoseconds, start and stop bits included.
+ */
+uint64_t usart_model_char_time_ns(UsartPort_t port)
+{
+    USART_TypeDef *regs = g_usart_hardware[port].regs;
+    const uint32_t pclk = peripheral_clock(port);
+    uint64_t half_bits = 0;     //length of a character in half bits
+    uint32_t brr = regs->BRR;
+
+    if (brr == 0 || pclk == 0)
+    {
+        return 0;
+    }
+
+    //start bit and 8 or 9 data bits
+    half_bits = (regs->CR1 & USART_CR1_M) ? 20U : 18U;
+
+    switch (regs->CR2 & USART_CR2_STOP)
+    {
+        case USART_StopBits_0_5: half_bits += 1U; break;
+        case USART_StopBits_2:   half_bits += 4U; break;
+        case USART_StopBits_1_5: half_bits += 3U; break;
+        default:                 half_bits += 2U; break;
+    }
+
+    //one bit lasts BRR cycles of the peripheral clock
+    return (half_bits * brr * SIM_NS_PER_S) / (2U * pclk);
+}
+
+/**
+ * @brief Computes how long one character sent by the other end takes on the line.
+ *
+ * @param port The USART.
+ *
+ * @return uint64_t Time of one character in nanoseconds, the receive timing if the
+ *         other end follows the receiver.
+ */
+uint64_t usart_model_line_char_time_ns(UsartPort_t port)
+{
+    const uint32_t line_rate = g_usart_models[port].line_rate;
+
+    return (line_rate == 0) ? usart_model_char_time_ns(port) : (USART_MODEL_LINE_BITS * SIM_NS_PER_S) / line_rate;
+}
+
+/**
+ * @brief Returns the time a scheduled byte is complete in the receiver.
+ *
+ * @param port The USART.
+ * @param index Position of the byte in the schedule.
+ *
+ * @return uint64_t The time, including the time the sender was held by RTS.
+ */
+static uint64_t scheduled_end(UsartPort_t port, uint32_t index)
+{
+    const struct UsartModel *model = &g_usart_models[port];
+
+    return model->schedule[index % USART_MODEL_RX_QUEUE].time_ns + model->rx_delay_ns;
+}
+
+/**
+ * @brief Returns the time the start bit of a scheduled byte begins.
+ *
+ * @param port The USART.
+ * @param index Position of the byte in the schedule.
+ *
+ * @return uint64_t The time, including the time the sender was held by RTS.
+ */
+static uint64_t scheduled_start(UsartPort_t port, uint32_t index)
+{
+    const uint32_t baud_rate = g_usart_models[port].schedule[index % USART_MODEL_RX_QUEUE].baud_rate;
+    const uint64_t char_time = (baud_rate == 0) ? usart_model_char_time_ns(port) :
+                               (USART_MODEL_LINE_BITS * SIM_NS_PER_S) / baud_rate;
+
+    return scheduled_end(port, index) - char_time;
+}
+
+/**
+ * @brief Follows RTS, the sender stops when it goes high and goes on when it goes low.
+ *
+ * @param port The USART.
+ */
+static void follow_rts(UsartPort_t port)
+{
+    const struct UsartModelHardware *hardware = &g_usart_hardware[port];
+    struct UsartModel *model = &g_usart_models[port];
+    GPIO_TypeDef *gpio = hardware->rts_gpio;
+    bool rts_high = false;
+
+    //BSRR sets and BRR resets bits of ODR, the upper half of BSRR resets them too
+    gpio->ODR = (gpio->ODR | (gpio->BSRR & 0xFFFFU)) & ~((gpio->BSRR >> 16) | gpio->BRR);
+    gpio->BSRR = 0;
+    gpio->BRR = 0;
+
+    rts_high = (gpio->ODR & hardware->rts_pin) != 0;
+
+    if (!model->flow_control)
+    {
+        return;
+    }
+
+    if (!model->rts_stopped && rts_high)
+    {
+        model->rts_stopped = true;
+        model->rts_stop_ns = g_sim_time_ns;
+        ++g_usart_model_stats[port].rts_stops;
+    }
+    else if (model->rts_stopped && !rts_high)
+    {
+        model->rts_stopped = false;
+        g_usart_model_stats[port].rts_held_ns += g_sim_time_ns - model->rts_stop_ns;
+
+        //the first byte that was held starts now instead
+        if (model->tail != model->head && scheduled_start(port, model->tail) >= model->rts_stop_ns &&
+            scheduled_start(port, model->tail) < g_sim_time_ns)
+        {
+            model->rx_delay_ns += g_sim_time_ns - scheduled_start(port, model->tail);
+        }
+    }
+}
+
+/**
+ * @brief Schedules bytes to arrive at the receiver of a USART.
+ *
+ * The bytes are sent at the rate of the other end, each one followed by an idle gap.
+ * Bytes scheduled earlier are sent first, so the new ones start no earlier than the
+ * last byte already on the line.
+ *
+ * @param port The USART.
+ * @param data Pointer to the bytes.
+ * @param length Number of bytes.
+ * @param start_ns Earliest time the first byte starts.
+ * @param gap_ns Idle time after every byte.
+ *
+ * @return uint32_t Number of bytes scheduled.
+ */
+uint32_t usart_model_schedule_rx(UsartPort_t port, const uint8_t *data, uint32_t length, uint64_t start_ns,
+                                 uint64_t gap_ns)
+{
+    struct UsartModel *model = &g_usart_models[port];
+    uint64_t char_time = usart_model_line_char_time_ns(port);
+    uint64_t line_free = start_ns;
+    uint32_t index = 0;
+
+    if (!data)
+    {
+        return 0;
+    }
+
+    //the line is busy until the last scheduled byte has been received
+    if (model->head != model->tail && scheduled_end(port, model->head - 1U) > line_free)
+    {
+        line_free = scheduled_end(port, model->head - 1U);
+    }
+
+    for (index = 0; index < length; ++index)
+    {
+        if (model->head - model->tail >= USART_MODEL_RX_QUEUE)
+        {
+            g_usart_model_stats[port].rx_dropped += length - index;
+            break;
+        }
+
+        line_free += char_time;
+        model->schedule[model->head % USART_MODEL_RX_QUEUE].time_ns   = line_free - model->rx_delay_ns;
+        model->schedule[model->head % USART_MODEL_RX_QUEUE].value     = data[index];
+        model->schedule[model->head % USART_MODEL_RX_QUEUE].baud_rate = model->line_rate;
+        model->schedule[model->head % USART_MODEL_RX_QUEUE].noisy     = false;
+        ++model->head;
+        line_free += gap_ns;
+    }
+
+    return index;
+}
+
+/**
+ * @brief Marks a scheduled byte to be received with a noise error, as a spike on the line would.
+ *
+ * @param port The USART.
+ * @param back Position of the byte, counted back from the last byte scheduled, which is 0.
+ *
+ * @return true if the byte is still on its way.
+ */
+bool usart_model_corrupt_rx(UsartPort_t port, uint32_t back)
+{
+    struct UsartModel *model = &g_usart_models[port];
+    bool outcome = false;
+
+    if (back < model->head - model->tail)
+    {
+        model->schedule[(model->head - 1U - back) % USART_MODEL_RX_QUEUE].noisy = true;
+        outcome = true;
+    }
+
+    return outcome;
+}
+
+/**
+ * @brief Checks whether every byte scheduled on a USART has been delivered and its line is idle.
+ *
+ * @param port The USART.
+ *
+ * @return true if nothing is left on the line and the idle line has been detected.
+ */
+bool usart_model_rx_idle(UsartPort_t port)
+{
+    return (g_usart_models[port].head == g_usart_models[port].tail) && (g_usart_models[port].idle_at_ns == 0);
+}
+
+/**
+ * @brief Checks whether the transmitter of a USART has sent every byte written to it.
+ *
+ * @param port The USART.
+ *
+ * @return true if DR and the shift register are empty.
+ */
+bool usart_model_tx_idle(UsartPort_t port)
+{
+    return !g_usart_models[port].tx_shifting && !g_usart_models[port].tx_dr_full;
+}
+
+/**
+ * @brief Serves the TX DMA request of a USART for as long as TXE is set and the channel has bytes.
+ *
+ * @param port The USART.
+ */
+static void serve_tx_dma(UsartPort_t port)
+{
+    const struct UsartModelHardware *hardware = &g_usart_hardware[port];
+    uint8_t value = 0;
+
+    while ((hardware->regs->CR3 & USART_CR3_DMAT) && (hardware->regs->SR & USART_SR_TXE) &&
+           (hardware->regs->CR1 & USART_CR1_UE) && dma_model_usart_tx(hardware->tx_dma_channel, &value))
+    {
+        hardware->regs->DR = value;
+        write_dr(port, value);
+    }
+}
+
+/**
+ * @brief Runs the interrupt handler of every USART for as long as the hardware would request it.
+ *
+ * RXNE and ORE request the interrupt with RXNEIE, IDLE with IDLEIE and PE with PEIE. With
+ * DMA reception, ORE, NE and FE request it with EIE. TXE requests it with TXEIE and TC
+ * with TCIE. The DMA requests of the transmitters are served first.
+ */
+void usart_model_service(void)
+{
+    const struct UsartModelHardware *hardware = NULL;
+    uint16_t pending = 0;
+    uint32_t tx_written = 0;
+    uint8_t port = 0;
+
+    for (port = 0; port < (uint8_t)USART_PORT_COUNT; ++port)
+    {
+        hardware = &g_usart_hardware[port];
+        serve_tx_dma((UsartPort_t)port);
+
+        while (hardware->handler != NULL)
+        {
+            pending = 0;
+
+            if (hardware->regs->CR1 & USART_CR1_RXNEIE)
+            {
+                pending |= (uint16_t)(hardware->regs->SR & (USART_SR_RXNE | USART_SR_ORE));
+            }
+
+            if (hardware->regs->CR1 & USART_CR1_IDLEIE)
+            {
+                pending |= (uint16_t)(hardware->regs->SR & USART_SR_IDLE);
+            }
+
+            if (hardware->regs->CR1 & USART_CR1_PEIE)
+            {
+                pending |= (uint16_t)(hardware->regs->SR & USART_SR_PE);
+            }
+
+            if ((hardware->regs->CR3 & (USART_CR3_EIE | USART_CR3_DMAR)) == (USART_CR3_EIE | USART_CR3_DMAR))
+            {
+                pending |= (uint16_t)(hardware->regs->SR & (USART_SR_ORE | USART_SR_NE | USART_SR_FE));
+            }
+
+            if (hardware->regs->CR1 & USART_CR1_TXEIE)
+            {
+                pending |= (uint16_t)(hardware->regs->SR & USART_SR_TXE);
+            }
+
+            if (hardware->regs->CR1 & USART_CR1_TCIE)
+            {
+                pending |= (uint16_t)(hardware->regs->SR & USART_SR_TC);
+            }
+
+            if (!(hardware->regs->CR1 & USART_CR1_UE) || pending == 0 || !sim_irq_enter(hardware->irq))
+            {
+                break;
+            }
+
+            ++g_usart_model_stats[port].isr_calls;
+            tx_written = g_usart_models[port].tx_written;
+            hardware->handler();
+            sim_irq_exit();
+
+            //a handler that does not clear the flag would be entered again forever; TXE is
+            //set again at once when the byte written moves into an idle shift register
+            if ((hardware->regs->SR & pending) && g_usart_models[port].tx_written == tx_written)
+            {
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Shifts one byte into the receiver; DMA takes it, DR holds it or it overruns.
+ *
+ * A byte sent at another rate is sampled at the wrong times: a faster receiver sees the
+ * long start bit as zeros, a slower one misses it and sees ones. Either way the stop bit
+ * is not where the receiver expects it.
+ *
+ * @param port The USART.
+ * @param value The received byte.
+ * @param baud_rate Rate the byte was sent at, 0 if at the rate of the receiver.
+ * @param noisy true if the byte is received with a noise error.
+ */
+static void receive_byte(UsartPort_t port, uint8_t value, uint32_t baud_rate, bool noisy)
+{
+    const struct UsartModelHardware *hardware = &g_usart_hardware[port];
+    const int64_t rate = (int64_t)receiver_rate(port);
+
+    if (baud_rate != 0 && rate != 0 &&
+        ((rate - (int64_t)baud_rate) * USART_MODEL_PPM > USART_MODEL_RATE_TOLERANCE_PPM * (int64_t)baud_rate ||
+         ((int64_t)baud_rate - rate) * USART_MODEL_PPM > USART_MODEL_RATE_TOLERANCE_PPM * (int64_t)baud_rate))
+    {
+        value = (rate > (int64_t)baud_rate) ? 0x00U : 0xFFU;
+        hardware->regs->SR |= USART_SR_FE;
+        ++g_usart_model_stats[port].rx_mismatched;
+    }
+
+    //the value is taken from the majority of the samples, it arrives as it was sent
+    if (noisy)
+    {
+        hardware->regs->SR |= USART_SR_NE;
+        ++g_usart_model_stats[port].rx_noisy;
+    }
+
+    hardware->regs->DR = value;
+
+    //a DMA request reads DR at once, RXNE is never seen set
+    if ((hardware->regs->CR3 & USART_CR3_DMAR) && dma_model_usart_rx(hardware->dma_channel))
+    {
+        ++g_usart_model_stats[port].rx_delivered;
+    }
+    else if (hardware->regs->SR & USART_SR_RXNE)
+    {
+        //the shift register is overwritten by the next byte, this one is lost
+        hardware->regs->SR |= USART_SR_ORE;
+        ++g_usart_model_stats[port].rx_overruns;
+    }
+    else
+    {
+        hardware->regs->SR |= USART_SR_RXNE;
+        ++g_usart_model_stats[port].rx_delivered;
+    }
+}
+
+/**
+ * @brief Looks at the receiving line of a USART and returns the time of its next event.
+ *
+ * @param port The USART.
+ *
+ * @return uint64_t Time the next byte arrives or the idle line is detected, UINT64_MAX
+ *         if nothing is pending.
+ */
+static uint64_t next_rx_event(UsartPort_t port)
+{
+    struct UsartModel *model = &g_usart_models[port];
+    const uint64_t char_time = usart_model_char_time_ns(port);
+
+    follow_rts(port);
+
+    model->next_byte_ns = (model->tail != model->head) ? scheduled_end(port, model->tail) : UINT64_MAX;
+
+    //a byte that had not started when RTS stopped the sender waits
+    if (model->rts_stopped && model->next_byte_ns != UINT64_MAX &&
+        scheduled_start(port, model->tail) >= model->rts_stop_ns)
+    {
+        model->next_byte_ns = UINT64_MAX;
+    }
+
+    //the line is not idle if the next start bit comes before a whole idle character
+    if (model->idle_at_ns != 0 && model->next_byte_ns != UINT64_MAX &&
+        model->next_byte_ns - char_time < model->idle_at_ns)
+    {
+        model->idle_at_ns = 0;
+    }
+
+    return (model->idle_at_ns != 0 && model->idle_at_ns <= model->next_byte_ns) ? model->idle_at_ns :
+                                                                                   model->next_byte_ns;
+}
+
+/**
+ * @brief Looks at both lines of a USART and returns the time of its next event.
+ *
+ * @param port The USART.
+ *
+ * @return uint64_t Time of the next receive event or the time the byte in the shift
+ *         register has been sent, UINT64_MAX if nothing is pending.
+ */
+static uint64_t next_event(UsartPort_t port)
+{
+    struct UsartModel *model = &g_usart_models[port];
+
+    model->next_rx_ns = next_rx_event(port);
+
+    return (model->tx_shifting && model->tx_done_ns < model->next_rx_ns) ? model->tx_done_ns : model->next_rx_ns;
+}
+
+/**
+ * @brief Loads a byte into the shift register of the transmitter.
+ *
+ * @param port The USART.
+ * @param value The byte.
+ * @param start_ns Time its start bit begins.
+ */
+static void shift_out(UsartPort_t port, uint8_t value, uint64_t start_ns)
+{
+    struct UsartModel *model = &g_usart_models[port];
+
+    model->tx_shifting = true;
+    model->tx_shift_value = value;
+    model->tx_done_ns = start_ns + usart_model_char_time_ns(port);
+    g_usart_hardware[port].regs->SR |= USART_SR_TXE;
+}
+
+/**
+ * @brief Finishes the byte in the shift register; it is captured and the next one follows.
+ *
+ * @param port The USART.
+ */
+static void take_tx_event(UsartPort_t port)
+{
+    struct UsartModel *model = &g_usart_models[port];
+
+    advance_to(model->tx_done_ns);
+    model->tx_shifting = false;
+
+    ++g_usart_model_stats[port].tx_bytes;
+    g_usart_model_stats[port].last_tx_ns = g_sim_time_ns;
+
+    if (model->tx_stream)
+    {
+        fputc((int)model->tx_shift_value, model->tx_stream);
+    }
+
+    if (model->tx_dr_full)
+    {
+        model->tx_dr_full = false;
+        shift_out(port, model->tx_dr_value, g_sim_time_ns);
+    }
+    else
+    {
+        g_usart_hardware[port].regs->SR |= USART_SR_TC;
+    }
+}
+
+/**
+ * @brief Takes the event next_event() has found on the lines of a USART.
+ *
+ * A byte sent and a byte received at the same time are taken in that order.
+ *
+ * @param port The USART.
+ */
+static void take_event(UsartPort_t port)
+{
+    struct UsartModel *model = &g_usart_models[port];
+    USART_TypeDef *regs = g_usart_hardware[port].regs;
+
+    if (model->tx_shifting && model->tx_done_ns <= model->next_rx_ns)
+    {
+        take_tx_event(port);
+    }
+    else if (model->idle_at_ns != 0 && model->idle_at_ns <= model->next_byte_ns)
+    {
+        advance_to(model->idle_at_ns);
+        model->idle_at_ns = 0;
+
+        if (receiver_enabled(port))
+        {
+            regs->SR |= USART_SR_IDLE;
+        }
+    }
+    else
+    {
+        advance_to(model->next_byte_ns);
+        ++model->tail;
+
+        //the receiver is disabled, the byte is not sampled
+        if (receiver_enabled(port))
+        {
+            receive_byte(port, model->schedule[(model->tail - 1U) % USART_MODEL_RX_QUEUE].value,
+                         model->schedule[(model->tail - 1U) % USART_MODEL_RX_QUEUE].baud_rate,
+                         model->schedule[(model->tail - 1U) % USART_MODEL_RX_QUEUE].noisy);
+            model->idle_at_ns = g_sim_time_ns + usart_model_char_time_ns(port);
+        }
+    }
+}
+
+/**
+ * @brief Returns the time of the next event on any USART.
+ *
+ * @return uint64_t The time, UINT64_MAX if no USART has anything pending.
+ */
+uint64_t usart_model_next_event(void)
+{
+    uint64_t earliest = UINT64_MAX;
+    uint64_t event = 0;
+    uint8_t port = 0;
+
+    for (port = 0; port < (uint8_t)USART_PORT_COUNT; ++port)
+    {
+        event = next_event((UsartPort_t)port);
+
+        if (event < earliest)
+        {
+            earliest = event;
+        }
+    }
+
+    return earliest;
+}
+
+/**
+ * @brief Moves simulated time forward, delivering the bytes that are due on every USART
+ *        and sending the ones the firmware has written.
+ *
+ * After every burst the line is idle; once it has been idle for a whole character the
+ * receiver raises IDLE. The events of all lines are taken in time order, those of the
+ * same time in the order of the USARTs.
+ *
+ * @param time_ns Time to move to; time never goes backwards.
+ */
+void usart_model_run_until(uint64_t time_ns)
+{
+    uint64_t earliest = 0;
+    uint64_t event = 0;
+    uint8_t next_port = 0;
+    uint8_t port = 0;
+
+    for (;;)
+    {
+        earliest = UINT64_MAX;
+
+        for (port = 0; port < (uint8_t)USART_PORT_COUNT; ++port)
+        {
+            event = next_event((UsartPort_t)port);
+
+            if (event < earliest)
+            {
+                earliest = event;
+                next_port = port;
+            }
+        }
+
+        if (earliest > time_ns)
+        {
+            break;
+        }
+
+        take_event((UsartPort_t)next_port);
+        sim_service_interrupts();
+    }
+
+    advance_to(time_ns);
+
+    //requests raised while the interrupts were masked are taken once they are unmasked
+    sim_service_interrupts();
+}
+
+/**
+ * @brief Reads DR; on the target this clears RXNE and, after reading SR, IDLE and the error flags.
+ */
+uint16_t __wrap_USART_ReceiveData(USART_TypeDef *USARTx)
+{
+    uint16_t data = (uint16_t)(USARTx->DR & USART_DR_MASK);
+
+    USARTx->SR &= (uint16_t)~USART_RX_FLAGS;
+
+    return data;
+}
+
+/**
+ * @brief Takes a byte written to DR; it moves into the shift register at once if it is
+ *        idle, otherwise it waits in DR until the byte before it has been sent.
+ *
+ * A byte written while DR is still full overwrites it, as on the target.
+ *
+ * @param port The USART.
+ * @param value The byte.
+ */
+static void write_dr(UsartPort_t port, uint8_t value)
+{
+    struct UsartModel *model = &g_usart_models[port];
+
+    ++model->tx_written;
+    g_usart_hardware[port].regs->SR &= (uint16_t)~USART_SR_TXE;
+
+    if (!model->tx_shifting)
+    {
+        shift_out(port, value, g_sim_time_ns);
+    }
+    else
+    {
+        model->tx_dr_full = true;
+        model->tx_dr_value = value;
+    }
+}
+
+/**
+ * @brief Writes DR; on the target this clears TXE and, after reading SR, TC.
+ */
+void __wrap_USART_SendData(USART_TypeDef *USARTx, uint16_t Data)
+{
+    uint8_t port = 0;
+
+    __real_USART_SendData(USARTx, Data);
+
+    for (port = 0; port < (uint8_t)USART_PORT_COUNT; ++port)
+    {
+        if (USARTx == g_usart_hardware[port].regs)
+        {
+            USARTx->SR &= (uint16_t)~USART_SR_TC;
+            write_dr((UsartPort_t)port, (uint8_t)Data);
+        }
+    }
+}
+
+/**
+ * @brief Clears flags of SR; on the target only CTS, LBD, TC and RXNE can be cleared by
+ *        writing 0, the bits written 1 keep their value.
+ */
+void __wrap_USART_ClearFlag(USART_TypeDef *USARTx, uint16_t USART_FLAG)
+{
+    USARTx->SR &= (uint16_t)~(USART_FLAG & (USART_SR_CTS | USART_SR_LBD | USART_SR_TC | USART_SR_RXNE));
+}
@@ -0,0 +1,48 @@
+#ifndef USART_MODEL_H
+#define USART_MODEL_H
+
+#include "sim_mcu.h"
+#include "../../HAL/HAL-UART/inc/hal_usart_ports.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#define USART_MODEL_RX_QUEUE    (uint32_t) 65536   //received bytes that can be scheduled ahead on every USART
+
+/**
+ * @brief Counters of what happened on one modelled USART.
+ */
+struct UsartModelStats
+{
+    uint32_t rx_delivered;   /*bytes shifted into the receive data register*/
+    uint32_t rx_overruns;    /*bytes lost because the previous one had not been read (ORE)*/
+    uint32_t rx_mismatched;  /*bytes sent at a baud rate the receiver was not set to (FE)*/
+    uint32_t rx_noisy;       /*bytes received with a noise error (NE)*/
+    uint32_t rx_dropped;     /*bytes that did not fit into the schedule*/
+    uint32_t tx_bytes;       /*bytes sent, up to their stop bit*/
+    uint32_t isr_calls;      /*calls of the interrupt handler of the USART*/
+    uint32_t rts_stops;      /*times RTS stopped a sender that honours it*/
+    uint64_t rts_held_ns;    /*time the sender was held by RTS*/
+    uint64_t last_tx_ns;     /*time the stop bit of the last byte sent ended*/
+};
+
+//counters of the current simulation, indexed by UsartPort_t
+extern struct UsartModelStats g_usart_model_stats[USART_PORT_COUNT];
+
+/*************function prototypes**********************/
+void usart_model_reset(void);
+void usart_model_capture(UsartPort_t port, FILE *stream);
+void usart_model_set_line_rate(UsartPort_t port, uint32_t baud_rate);
+void usart_model_set_flow_control(UsartPort_t port, bool honour_rts);
+uint64_t usart_model_char_time_ns(UsartPort_t port);
+uint64_t usart_model_line_char_time_ns(UsartPort_t port);
+uint32_t usart_model_schedule_rx(UsartPort_t port, const uint8_t *data, uint32_t length, uint64_t start_ns,
+                                 uint64_t gap_ns);
+bool usart_model_corrupt_rx(UsartPort_t port, uint32_t back);
+bool usart_model_rx_idle(UsartPort_t port);
+bool usart_model_tx_idle(UsartPort_t port);
+uint64_t usart_model_next_event(void);
+void usart_model_run_until(uint64_t time_ns);
+void usart_model_service(void);
+
+#endif // USART_MODEL_H
@@ -0,0 +1,274 @@
+/*
+ * stress_memory_pool.c
+ *
+ * Host stress test of the memory pool used from an interrupt handler and from the
+ * main loop at the same time.
+ *
+ * A POSIX interval timer stands in for the interrupt: its signal handler runs between
+ * any two instructions of the main loop, unless the modelled PRIMASK masks it (see
+ * shim/cmsis_gcc.h), in which case the interrupt is counted as deferred. Both sides
+ * allocate runs of pages, fill every byte with a tag of their own and check the tag
+ * again before they free the pages. Pages handed out to both sides at once show up as
+ * a tag overwritten by the other side.
+ *
+ * Single pages go through the free list of MemoryPool_Allocate() and MemoryPool_Free(),
+ * longer runs through the bitmap search, so both paths interleave with each other. At
+ * the end every block has to come out of the free list exactly once.
+ *
+ * The test fails if any tag was overwritten, if the free list lost or repeated a block,
+ * or if no interrupt hit the main loop in the middle of a pool call, in which case
+ * nothing was interleaved.
+ */
+
+#include "../../Command_Line_App/memory_utility/memory_utility.h"
+#include "../../HAL/HAL-SYSTEM/inc/stm32f10x.h"
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+
+#define STRESS_ISR_RUNS       (uint32_t) 50000   //interrupts to run before the test ends
+#define STRESS_TIMER_US       (long) 20          //period of the simulated interrupt
+#define STRESS_MAX_ITERATIONS (uint32_t) 200000000
+#define STRESS_MAIN_PAGES     (uint32_t) 5       //largest run of pages the main loop allocates, the size of a parse result
+#define STRESS_ISR_PAGES      (uint32_t) 4       //largest run of pages the interrupt allocates
+#define STRESS_ISR_HELD       (uint32_t) 3       //allocations the interrupt keeps across its runs
+#define STRESS_ISR_TAG        (uint8_t) 0x80     //tags of the interrupt have the top bit set, those of the main loop not
+
+/**
+ * @brief A run of pages held by one side, with the tag written into it.
+ */
+struct StressAllocation
+{
+    uint8_t *pages;       /*first page, NULL if nothing is held*/
+    uint32_t page_count;  /*number of pages*/
+    uint8_t tag;          /*value of every byte of the pages*/
+};
+
+/*state of the simulated interrupt, only touched by the signal handler*/
+static struct StressAllocation g_isr_held[STRESS_ISR_HELD];
+static uint32_t g_isr_random = 0x2545F491U;
+static uint32_t g_isr_next = 0;
+
+/*counters shared between the signal handler and the main loop*/
+static volatile sig_atomic_t g_main_in_pool = 0;   /*1 while the main loop is inside a pool call*/
+static volatile uint32_t g_isr_runs = 0;
+static volatile uint32_t g_isr_interleaved = 0;    /*interrupts that hit the main loop inside a pool call*/
+static volatile uint32_t g_isr_deferred = 0;       /*interrupts PRIMASK held back*/
+static volatile uint32_t g_isr_failed = 0;         /*allocations of the interrupt that found no free run*/
+static volatile uint32_t g_overlaps = 0;           /*tags found overwritten by the other side*/
+
+/**
+ * @brief Advances a xorshift generator; rand() is not safe to call from a signal handler.
+ */
+static uint32_t stress_random(uint32_t *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+
+    return *state;
+}
+
+/**
+ * @brief Allocates a run of pages, a single page from the free list.
+ */
+static uint8_t *stress_allocate(uint32_t page_count)
+{
+    return (uint8_t *)((page_count == 1U) ? MemoryPool_Allocate() : MemoryPool_AllocatePages(page_count));
+}
+
+/**
+ * @brief Frees a run of pages the way it was allocated.
+ */
+static void stress_free(const struct StressAllocation *allocation)
+{
+    if (allocation->page_count == 1U)
+    {
+        MemoryPool_Free(allocation->pages);
+    }
+    else
+    {
+        MemoryPool_FreePages(allocation->pages, allocation->page_count);
+    }
+}
+
+/**
+ * @brief Takes every block out of the free list and gives them back.
+ *
+ * @return true if the list held every block of the pool exactly once.
+ */
+static bool stress_free_list_complete(void)
+{
+    uint8_t *blocks[BLOCK_COUNT + 1U];
+    bool outcome = true;
+    uint32_t count = 0;
+    uint32_t index = 0;
+    uint32_t other = 0;
+
+    //one more than the pool holds, a list that repeats a block would hand it out
+    while (count <= BLOCK_COUNT && (blocks[count] = (uint8_t *)MemoryPool_Allocate()) != NULL)
+    {
+        ++count;
+    }
+
+    for (index = 0; index < count; ++index)
+    {
+        for (other = index + 1U; other < count; ++other)
+        {
+            outcome = outcome && (blocks[index] != blocks[other]);
+        }
+    }
+
+    for (index = 0; index < count && index < BLOCK_COUNT; ++index)
+    {
+        MemoryPool_Free(blocks[index]);
+    }
+
+    return outcome && count == BLOCK_COUNT;
+}
+
+/**
+ * @brief Fills a run of pages with a tag.
+ */
+static void stress_fill(const struct StressAllocation *allocation)
+{
+    memset(allocation->pages, allocation->tag, allocation->page_count * BLOCK_SIZE);
+}
+
+/**
+ * @brief Checks that no byte of a run of pages has been overwritten.
+ *
+ * @return true if every byte still holds the tag.
+ */
+static bool stress_intact(const struct StressAllocation *allocation)
+{
+    uint32_t index = 0;
+
+    for (index = 0; index < allocation->page_count * BLOCK_SIZE; ++index)
+    {
+        if (allocation->pages[index] != allocation->tag)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief The simulated interrupt handler: gives back its oldest allocation and makes a new one.
+ */
+static void stress_isr(int signal_number)
+{
+    struct StressAllocation *allocation = &g_isr_held[g_isr_next];
+
+    (void)signal_number;
+
+    //the core would take the interrupt once PRIMASK is cleared, the run is left out instead
+    if (g_host_primask != 0U)
+    {
+        ++g_isr_deferred;
+        return;
+    }
+
+    ++g_isr_runs;
+    if (g_main_in_pool)
+    {
+        ++g_isr_interleaved;
+    }
+
+    if (allocation->pages != NULL)
+    {
+        if (!stress_intact(allocation))
+        {
+            ++g_overlaps;
+        }
+        stress_free(allocation);
+    }
+
+    allocation->page_count = 1U + stress_random(&g_isr_random) % STRESS_ISR_PAGES;
+    allocation->pages = stress_allocate(allocation->page_count);
+    allocation->tag = (uint8_t)(STRESS_ISR_TAG | (g_isr_runs & 0x7FU));
+
+    if (allocation->pages != NULL)
+    {
+        stress_fill(allocation);
+    }
+    else
+    {
+        ++g_isr_failed;
+    }
+
+    g_isr_next = (g_isr_next + 1U) % STRESS_ISR_HELD;
+}
+
+int main(void)
+{
+    struct StressAllocation allocation = { NULL, 0, 0 };
+    struct itimerval timer = { { 0, STRESS_TIMER_US }, { 0, STRESS_TIMER_US } };
+    struct itimerval stop = { { 0, 0 }, { 0, 0 } };
+    uint32_t main_random = 0x9E3779B9U;
+    uint32_t iterations = 0;
+    uint32_t main_failed = 0;
+    uint32_t index = 0;
+    bool free_list_complete = false;
+
+    MemoryPool_Init();
+
+    signal(SIGALRM, stress_isr);
+    setitimer(ITIMER_REAL, &timer, NULL);
+
+    for (iterations = 0; g_isr_runs < STRESS_ISR_RUNS && iterations < STRESS_MAX_ITERATIONS; ++iterations)
+    {
+        allocation.page_count = 1U + stress_random(&main_random) % STRESS_MAIN_PAGES;
+        allocation.tag = (uint8_t)(iterations & 0x7FU);
+
+        g_main_in_pool = 1;
+        allocation.pages = stress_allocate(allocation.page_count);
+        g_main_in_pool = 0;
+
+        if (allocation.pages == NULL)
+        {
+            ++main_failed;
+            continue;
+        }
+
+        stress_fill(&allocation);
+
+        if (!stress_intact(&allocation))
+        {
+            ++g_overlaps;
+        }
+
+        g_main_in_pool = 1;
+        stress_free(&allocation);
+        g_main_in_pool = 0;
+    }
+
+    setitimer(ITIMER_REAL, &stop, NULL);
+
+    //what the interrupt still holds must be intact and free the pool completely
+    for (index = 0; index < STRESS_ISR_HELD; ++index)
+    {
+        if (g_isr_held[index].pages != NULL)
+        {
+            if (!stress_intact(&g_isr_held[index]))
+            {
+                ++g_overlaps;
+            }
+            stress_free(&g_isr_held[index]);
+        }
+    }
+
+    free_list_complete = stress_free_list_complete();
+
+    printf("memory pool: %u main loop allocations (%u found no free run), %u interrupts "
+           "(%u inside a pool call of the main loop, %u held back by PRIMASK, %u found no free run)\n",
+           iterations, main_failed, g_isr_runs, g_isr_interleaved, g_isr_deferred, g_isr_failed);
+    printf("memory pool: %u overlapping allocations, %u of %u blocks free at the end, free list %s\n",
+           g_overlaps, MemoryPool_GetFreeBlocks(), BLOCK_COUNT, free_list_complete ? "complete" : "broken");
+
+    return (g_overlaps == 0 && g_isr_interleaved > 0 && free_list_complete &&
+            MemoryPool_GetFreeBlocks() == BLOCK_COUNT) ? 0 : 1;
+}
@@ -0,0 +1,402 @@
+#!/usr/bin/env python3
+"""
+gen_command_table.py
+
+Generates the command table of the UART command line from its command schema.
+
+The schema (Command_Line_App/UART_command_line/command_schema.json) lists every
+command with its name, callback, parameter spec and the values of its response.
+From it this script writes
+
+  - command_table.h: command ids, table sizes and the callback prototypes
+  - command_table.c: g_cmd_list and a collision-free (perfect) hash table
+
+The hash table is built with the hash-and-displace method: a first hash of the
+command name selects a bucket, and the bucket stores the seed of a second hash
+that maps every name of the bucket to its own slot. A lookup therefore costs two
+hashes of the received name and one final memcmp, whatever the number of commands.
+
+command_hash() below must stay identical to command_hash() in UART-Command-Line.c.
+
+The largest response of every command is worked out from the values it declares, so
+the command line reserves exactly that much room in the transmit queue and builds the
+response in place. The sizes below must stay identical to RESPONSE_FRAME_* in
+Command_Line_App/response_frame/response_frame.h.
+
+Usage: python3 Tools/gen_command_table.py [schema] [output directory]
+"""
+
+import json
+import os
+import re
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+DEFAULT_SCHEMA = os.path.join(ROOT, "Command_Line_App", "UART_command_line", "command_schema.json")
+
+FNV_OFFSET = 0x811C9DC5
+FNV_PRIME = 0x01000193
+MASK32 = 0xFFFFFFFF
+
+MAX_COMMANDS = 0xF0       # callback indexes share a byte with the parser status codes
+MAX_SEED = 0xFFFF         # displacement seeds are stored as uint16_t
+HASH_EMPTY_SLOT = 0xFF    # marks a slot of the hash table that holds no command
+MAX_PARAMS = 8            # must match MAX_COMMAND_PARAMS in UART_Command_Line.h
+
+IDENTIFIER = re.compile(r"^[A-Za-z_][A-Za-z0-9_]*$")
+
+INT32_MIN = -0x80000000
+INT32_MAX = 0x7FFFFFFF
+
+# C enumerator and natural range of every parameter type of the schema
+PARAM_TYPES = {
+    "string": ("PARAM_TYPE_STRING", 0, 0),
+    "u8":     ("PARAM_TYPE_U8", 0, 0xFF),
+    "u16":    ("PARAM_TYPE_U16", 0, 0xFFFF),
+    "i32":    ("PARAM_TYPE_I32", INT32_MIN, INT32_MAX),
+    "fixed":  ("PARAM_TYPE_FIXED", INT32_MIN, INT32_MAX),
+    "hex":    ("PARAM_TYPE_HEX", 0, 0xFFFFFFFF),
+    "bool":   ("PARAM_TYPE_BOOL", 0, 1),
+    "enum":   ("PARAM_TYPE_ENUM", 0, 0),
+}
+MAX_FRACTION_DIGITS = 9
+
+# largest text and binary encoding of every value type a response can carry
+REPLY_TYPES = {
+    "u8":    (3, 1),
+    "u16":   (5, 2),
+    "u32":   (10, 4),
+    "i32":   (11, 4),
+    "fixed": (12, 4),
+}
+XML_RESPONSE_OVERHEAD = 44     # <UCL><RSP></RSP><STATUS>0x00</STATUS></UCL> and the newline
+XML_VALUE_OVERHEAD = 11        # <VAL></VAL>
+BINARY_RESPONSE_OVERHEAD = 7   # delimiters, COBS code byte, command id, status and CRC-16
+BINARY_VALUE_OVERHEAD = 2      # type and length bytes of a value
+MAX_REPLY_SIZE = 512           # must match USART_TX_RESERVE_MAX in hal_usart_config.h
+
+
+def command_hash(name, seed):
+    """Seeded FNV-1a hash followed by a final mix of the high bits into the low bits."""
+    value = (FNV_OFFSET ^ seed) & MASK32
+    for byte in name:
+        value ^= byte
+        value = (value * FNV_PRIME) & MASK32
+    value ^= value >> 15
+    return value
+
+
+def next_power_of_two(value):
+    power = 1
+    while power < value:
+        power <<= 1
+    return power
+
+
+def build_perfect_hash(names):
+    """Returns (bucket_count, slot_count, displacement seeds, slots)."""
+    bucket_count = next_power_of_two(max(1, (len(names) + 1) // 2))
+    slot_count = next_power_of_two(max(1, len(names)))
+
+    while True:
+        buckets = [[] for _ in range(bucket_count)]
+        for index, name in enumerate(names):
+            buckets[command_hash(name, 0) & (bucket_count - 1)].append(index)
+
+        seeds = [0] * bucket_count
+        slots = [HASH_EMPTY_SLOT] * slot_count
+        placed = True
+
+        # the biggest buckets are the hardest to place, so they go first
+        for bucket in sorted(range(bucket_count), key=lambda b: len(buckets[b]), reverse=True):
+            members = buckets[bucket]
+            if not members:
+                continue
+
+            for seed in range(1, MAX_SEED + 1):
+                targets = [command_hash(names[m], seed) & (slot_count - 1) for m in members]
+                if len(set(targets)) == len(targets) and all(slots[t] == HASH_EMPTY_SLOT for t in targets):
+                    for member, target in zip(members, targets):
+                        slots[target] = member
+                    seeds[bucket] = seed
+                    break
+            else:
+                placed = False
+                break
+
+        if placed:
+            return bucket_count, slot_count, seeds, slots
+
+        # no seed fits, retry with a sparser table
+        slot_count <<= 1
+
+
+def c_string(text):
+    return '"' + text.replace("\\", "\\\\").replace('"', '\\"') + '"'
+
+
+def load_schema(path):
+    with open(path, "r", encoding="utf-8") as schema_file:
+        schema = json.load(schema_file)
+
+    commands = schema.get("commands", [])
+    if not commands:
+        sys.exit("%s: the schema does not define any command" % path)
+    if len(commands) >= MAX_COMMANDS:
+        sys.exit("%s: at most %d commands are supported" % (path, MAX_COMMANDS - 1))
+
+    seen = set()
+    for command in commands:
+        name = command.get("name", "")
+        callback = command.get("callback", "")
+        if not name or len(name) > 0xFF or any(c in name for c in "<>&"):
+            sys.exit("%s: invalid command name %r" % (path, name))
+        if name in seen:
+            sys.exit("%s: command %r is defined twice" % (path, name))
+        if not IDENTIFIER.match(callback):
+            sys.exit("%s: invalid callback %r for command %r" % (path, callback, name))
+        params = command.get("params", [])
+        if len(params) > MAX_PARAMS:
+            sys.exit("%s: command %r has more than %d parameters" % (path, name, MAX_PARAMS))
+        if len(set(param.get("name") for param in params)) != len(params):
+            sys.exit("%s: command %r has two parameters with the same name" % (path, name))
+        for param in params:
+            check_param(path, name, param)
+        command["reply_size"] = reply_size(path, command)
+        seen.add(name)
+
+    return commands
+
+
+def check_param(path, command, param):
+    """Validates a parameter spec and fills in its type, scaled range and enum values."""
+    where = "%s: parameter %r of command %r" % (path, param.get("name"), command)
+
+    if not IDENTIFIER.match(param.get("name", "")):
+        sys.exit("%s: invalid parameter name" % where)
+
+    param.setdefault("type", "string")
+    param.setdefault("required", True)
+    if param["type"] not in PARAM_TYPES:
+        sys.exit("%s: unknown type %r, expected one of %s" % (where, param["type"], ", ".join(sorted(PARAM_TYPES))))
+
+    _, low, high = PARAM_TYPES[param["type"]]
+    digits = param.get("fraction_digits", 0)
+    if param["type"] == "fixed":
+        if not 0 < digits <= MAX_FRACTION_DIGITS:
+            sys.exit("%s: fraction_digits must be between 1 and %d" % (where, MAX_FRACTION_DIGITS))
+    elif digits:
+        sys.exit("%s: fraction_digits is only valid for fixed parameters" % where)
+    param["fraction_digits"] = digits
+
+    if param["type"] == "enum":
+        values = param.get("values", [])
+        if not values or len(values) > 0xFF or len(set(values)) != len(values):
+            sys.exit("%s: an enum needs between 1 and 255 distinct values" % where)
+        high = len(values) - 1
+    elif "values" in param:
+        sys.exit("%s: values is only valid for enum parameters" % where)
+
+    # the range is given in natural units, fixed values are stored scaled
+    scale = 10 ** digits
+    minimum = int(round(param.get("min", low / scale) * scale))
+    maximum = int(round(param.get("max", high / scale) * scale))
+    if param["type"] in ("string", "bool", "enum") and ("min" in param or "max" in param):
+        sys.exit("%s: min and max are not valid for %s parameters" % (where, param["type"]))
+    if not low <= minimum <= maximum <= high:
+        sys.exit("%s: the range must be within %d..%d" % (where, low, high))
+    param["min"] = minimum
+    param["max"] = maximum
+
+
+def reply_size(path, command):
+    """Validates the response values of a command and returns the size of its largest response frame."""
+    values = command.get("reply", [])
+    if len(values) > 0xFF:
+        sys.exit("%s: command %r has more than 255 response values" % (path, command["name"]))
+
+    xml_size = XML_RESPONSE_OVERHEAD + len(command["name"].encode("utf-8"))
+    binary_size = BINARY_RESPONSE_OVERHEAD
+    for value in values:
+        where = "%s: response value %r of command %r" % (path, value.get("name"), command["name"])
+        if not IDENTIFIER.match(value.get("name", "")):
+            sys.exit("%s: invalid value name" % where)
+        value_type = value.get("type")
+        if value_type in REPLY_TYPES:
+            if (value_type == "fixed") != ("fraction_digits" in value):
+                sys.exit("%s: fraction_digits is required for fixed values and only valid for them" % where)
+            if not 0 < value.get("fraction_digits", 1) <= MAX_FRACTION_DIGITS:
+                sys.exit("%s: fraction_digits must be between 1 and %d" % (where, MAX_FRACTION_DIGITS))
+            text, encoded = REPLY_TYPES[value_type]
+        else:
+            sys.exit("%s: unknown type %r, expected one of %s" %
+                     (where, value_type, ", ".join(sorted(REPLY_TYPES))))
+        xml_size += XML_VALUE_OVERHEAD + text
+        binary_size += BINARY_VALUE_OVERHEAD + encoded
+
+    size = max(xml_size, binary_size)
+    if size > MAX_REPLY_SIZE:
+        sys.exit("%s: the response of command %r takes up to %d bytes, at most %d fit" %
+                 (path, command["name"], size, MAX_REPLY_SIZE))
+    return size
+
+
+def range_literal(param, value):
+    if param["type"] == "hex":
+        return "(int32_t)0x%08XU" % value
+    if value == INT32_MIN:
+        return "INT32_MIN"
+    return "%d" % value
+
+
+def command_id(name):
+    return "COMMAND_ID_" + re.sub(r"[^A-Za-z0-9]", "_", name).upper()
+
+
+def params_table(name):
+    return "g_params_" + re.sub(r"[^A-Za-z0-9]", "_", name).lower()
+
+
+def enum_table(command, param):
+    return "g_enum_%s_%s" % (re.sub(r"[^A-Za-z0-9]", "_", command).lower(), param.lower())
+
+
+def generate_header(commands, bucket_count, slot_count):
+    callbacks = []
+    for command in commands:
+        if command["callback"] not in callbacks:
+            callbacks.append(command["callback"])
+
+    lines = []
+    lines.append("/**")
+    lines.append("  ******************************************************************************")
+    lines.append("  * @file    command_table.h")
+    lines.append("  * @brief   Command ids and lookup tables of the UART command line.")
+    lines.append("  *")
+    lines.append("  *          GENERATED by Tools/gen_command_table.py from command_schema.json.")
+    lines.append("  *          Do not edit this file by hand, edit the schema instead.")
+    lines.append("  ******************************************************************************/")
+    lines.append("")
+    lines.append("#ifndef COMMAND_TABLE_H")
+    lines.append("#define COMMAND_TABLE_H")
+    lines.append("")
+    lines.append('#include "UART_Command_Line.h"')
+    lines.append("")
+    lines.append("#define COMMAND_COUNT              (uint8_t) %d   //number of commands in g_cmd_list" % len(commands))
+    lines.append("#define COMMAND_HASH_BUCKETS       (uint32_t) %d  //number of displacement buckets, a power of two" % bucket_count)
+    lines.append("#define COMMAND_HASH_SLOTS         (uint32_t) %d  //number of hash table slots, a power of two" % slot_count)
+    lines.append("#define COMMAND_HASH_EMPTY_SLOT    (uint8_t) 0x%02X //marks a slot that holds no command" % HASH_EMPTY_SLOT)
+    lines.append("")
+    lines.append("/**")
+    lines.append(" * @brief Ids of the commands, each id is the index of the command in g_cmd_list.")
+    lines.append(" */")
+    lines.append("typedef enum")
+    lines.append("{")
+    for index, command in enumerate(commands):
+        lines.append("    %s = %d," % (command_id(command["name"]), index))
+    lines.append("} CommandId_t;")
+    lines.append("")
+    lines.append("extern const struct CommandEntry g_cmd_list[COMMAND_COUNT];")
+    lines.append("extern const uint16_t g_cmd_hash_seeds[COMMAND_HASH_BUCKETS];")
+    lines.append("extern const uint8_t g_cmd_hash_slots[COMMAND_HASH_SLOTS];")
+    lines.append("")
+    lines.append("/******************************callback prototypes*******************************/")
+    for callback in callbacks:
+        lines.append("ErrorStatus %s(const struct XMLDataExtractionResult *CommandContent);" % callback)
+    lines.append("")
+    lines.append("#endif //End of COMMAND_TABLE_H")
+    lines.append("")
+    return "\n".join(lines)
+
+
+def generate_source(commands, seeds, slots):
+    lines = []
+    lines.append("/**")
+    lines.append("  ******************************************************************************")
+    lines.append("  * @file    command_table.c")
+    lines.append("  * @brief   Command list and perfect hash table of the UART command line.")
+    lines.append("  *")
+    lines.append("  *          GENERATED by Tools/gen_command_table.py from command_schema.json.")
+    lines.append("  *          Do not edit this file by hand, edit the schema instead.")
+    lines.append("  ******************************************************************************/")
+    lines.append("")
+    lines.append('#include "command_table.h"')
+    lines.append("")
+
+    for command in commands:
+        params = command.get("params", [])
+        for param in params:
+            if param["type"] == "enum":
+                lines.append("static const char *const %s[] =" % enum_table(command["name"], param["name"]))
+                lines.append("{")
+                lines.append("    " + ", ".join(c_string(value) for value in param["values"]))
+                lines.append("};")
+                lines.append("")
+        if params:
+            lines.append("static const struct ParamSpec %s[] =" % params_table(command["name"]))
+            lines.append("{")
+            for param in params:
+                enum_values = "NULL, 0"
+                if param["type"] == "enum":
+                    enum_values = "%s, %d" % (enum_table(command["name"], param["name"]), len(param["values"]))
+                lines.append("    {%s, %s, %s, %d, %s, %s, %s}," % (
+                    c_string(param["name"]), "true" if param["required"] else "false",
+                    PARAM_TYPES[param["type"]][0], param["fraction_digits"],
+                    range_literal(param, param["min"]), range_literal(param, param["max"]), enum_values))
+            lines.append("};")
+            lines.append("")
+
+    lines.append("/*commands of the command line, indexed by CommandId_t*/")
+    lines.append("const struct CommandEntry g_cmd_list[COMMAND_COUNT] =")
+    lines.append("{")
+    for command in commands:
+        params = command.get("params", [])
+        table = params_table(command["name"]) if params else "NULL"
+        lines.append("    {%s, %d, %s, %s, %d, %d}," % (c_string(command["name"]), len(command["name"].encode("utf-8")),
+                                                       command["callback"], table, len(params), command["reply_size"]))
+    lines.append("};")
+    lines.append("")
+    lines.append("/*seed of the second hash for every bucket selected by the first hash*/")
+    lines.append("const uint16_t g_cmd_hash_seeds[COMMAND_HASH_BUCKETS] =")
+    lines.append("{")
+    for start in range(0, len(seeds), 8):
+        lines.append("    " + ", ".join("%d" % seed for seed in seeds[start:start + 8]) + ",")
+    lines.append("};")
+    lines.append("")
+    lines.append("/*command index stored in every slot of the hash table*/")
+    lines.append("const uint8_t g_cmd_hash_slots[COMMAND_HASH_SLOTS] =")
+    lines.append("{")
+    for start in range(0, len(slots), 8):
+        lines.append("    " + ", ".join("0x%02X" % slot for slot in slots[start:start + 8]) + ",")
+    lines.append("};")
+    lines.append("")
+    return "\n".join(lines)
+
+
+def write_if_changed(path, content):
+    try:
+        with open(path, "r", encoding="utf-8") as existing:
+            if existing.read() == content:
+                return
+    except OSError:
+        pass
+
+    with open(path, "w", encoding="utf-8", newline="\n") as output:
+        output.write(content)
+    print("generated %s" % os.path.relpath(path, ROOT))
+
+
+def main():
+    schema_path = sys.argv[1] if len(sys.argv) > 1 else DEFAULT_SCHEMA
+    output_dir = sys.argv[2] if len(sys.argv) > 2 else os.path.dirname(os.path.abspath(schema_path))
+
+    commands = load_schema(schema_path)
+    names = [command["name"].encode("utf-8") for command in commands]
+    bucket_count, slot_count, seeds, slots = build_perfect_hash(names)
+
+    write_if_changed(os.path.join(output_dir, "command_table.h"), generate_header(commands, bucket_count, slot_count))
+    write_if_changed(os.path.join(output_dir, "command_table.c"), generate_source(commands, seeds, slots))
+
+
+if __name__ == "__main__":
+    main()